@@ -0,0 +1,115 @@
+/*
+ * airtime.c
+ *
+ * Frame airtime and goodput. MR-FSK only, as the other PHYs cannot be
+ * configured by at86rf215_bb_conf() yet.
+ */
+#include <airtime.h>
+
+/* Symbol rate in symbols/s, indexed by at86rf215_fsk_srate_t */
+static const uint32_t fsk_srate_hz[] =
+        { 50000, 100000, 150000, 200000, 300000, 400000 };
+
+/* Tail of the convolutional code, IEEE 802.15.4 MR-FSK FEC */
+#define FSK_FEC_TAIL_BITS   3
+
+/* PHR of MR-FSK */
+#define FSK_PHR_BITS        16
+
+/*
+ * PHR and PSDU are sent in the modulation order of the configuration. The
+ * SHR is always sent at one bit per symbol, as 4-FSK sends it on the outer
+ * deviation only. With FEC, PHR and PSDU are rate 1/2 coded after the tail
+ * and pad bits, which round them up to a multiple of 16 bits. Whitening and
+ * interleaving do not change the length.
+ */
+static int fsk_frame(const struct at86rf215_mrfsk_conf *fsk, size_t len,
+                     struct airtime *a)
+{
+    if (fsk->srate >= sizeof(fsk_srate_hz) / sizeof(fsk_srate_hz[0]))
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    a->sym_rate_hz = fsk_srate_hz[fsk->srate];
+    a->shr_sym = fsk->preamble_length * 8 + (fsk->sfd32 ? 32 : 16);
+
+    /* The SFD sent on TX selects the coded or uncoded mode */
+    const at86rf215_sfd_mode_t mode = fsk->sfd ? fsk->csfd1 : fsk->csfd0;
+    a->data_bits = FSK_PHR_BITS + len * 8;
+    if (mode == AT86RF215_SFD_CODED_IEEE || mode == AT86RF215_SFD_CODED_RAW)
+    {
+        a->data_bits = ((a->data_bits + FSK_FEC_TAIL_BITS + 15) & ~15UL) * 2;
+    }
+    const uint32_t bps = fsk->mord == AT86RF215_4FSK ? 2 : 1;
+    a->data_sym = (a->data_bits + bps - 1) / bps;
+    a->us = ((uint64_t) (a->shr_sym + a->data_sym) * 1000000
+            + a->sym_rate_hz - 1) / a->sym_rate_hz;
+    return AT86RF215_OK;
+}
+
+/*
+ * Symbol counts and time on air of a frame of len PSDU bytes, FCS included.
+ */
+int airtime_frame(const struct at86rf215_bb_conf *conf, size_t len,
+                  struct airtime *a)
+{
+    if (!conf || !a || len > AT86RF215_MAX_PDU)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    switch (conf->pt)
+    {
+    case AT86RF215_BB_MRFSK:
+        return fsk_frame(&conf->fsk, len, a);
+    case AT86RF215_BB_MROFDM:
+    case AT86RF215_BB_MROQPSK:
+        return -AT86RF215_NOT_IMPL;
+    default:
+        return -AT86RF215_INVAL_PARAM;
+    }
+}
+
+int airtime_frame_us(const struct at86rf215_bb_conf *conf, size_t len,
+                     uint32_t *us)
+{
+    struct airtime a;
+    if (!us)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    int ret = airtime_frame(conf, len, &a);
+    if (ret)
+    {
+        return ret;
+    }
+    *us = a.us;
+    return AT86RF215_OK;
+}
+
+/* Bytes of the PSDU taken by the FCS */
+size_t airtime_fcs_len(const struct at86rf215_bb_conf *conf)
+{
+    return conf->fcst == AT86RF215_FCS_32 ? 4 : 2;
+}
+
+/*
+ * Payload bits per second for back to back frames carrying payload bytes
+ * each, the FCS added. gap_us is the idle time between two frames, e.g. the
+ * TX turnaround or the wait for an acknowledgement.
+ */
+int airtime_goodput_bps(const struct at86rf215_bb_conf *conf, size_t payload,
+                        uint32_t gap_us, uint32_t *bps)
+{
+    struct airtime a;
+    if (!conf || !bps)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    int ret = airtime_frame(conf, payload + airtime_fcs_len(conf), &a);
+    if (ret)
+    {
+        return ret;
+    }
+    *bps = ((uint64_t) payload * 8 * 1000000) / (a.us + gap_us);
+    return AT86RF215_OK;
+}
@@ -0,0 +1,434 @@
+/*
+ * arq.c
+ *
+ * Selective-repeat ARQ with bitmap acknowledgements
+ */
+#include <arq.h>
+#include <airtime.h>
+#include <timebase.h>
+#include <regs.h>
+#include <spi_helper.h>
+#include <string.h>
+
+#if ARQ_WINDOW > 32 || (ARQ_WINDOW & (ARQ_WINDOW - 1))
+#error "ARQ_WINDOW should be a power of two up to 32"
+#endif
+
+/* BBCn_AMCS: back to RX at the end of every frame sent */
+#define AMCS_TX2RX          0x01
+
+/* Bound of the RX state transition in arq_init() */
+#define RX_START_TIMEOUT_MS 10
+
+#define SLOT(seq)           ((seq) & (ARQ_WINDOW - 1))
+
+static size_t fcs_len(const struct arq *a)
+{
+    return airtime_fcs_len(&a->h->priv.bbc[a->radio]);
+}
+
+static uint8_t in_flight(const struct arq *a)
+{
+    return (uint8_t) (a->snd_next - a->snd_base);
+}
+
+/* Uploads the frame and starts it from RX, no TXPREP wait needed */
+static int transmit(struct arq *a, const uint8_t *psdu, size_t len,
+                    uint32_t airtime_us)
+{
+    int ret = at86rf215_tx_preload(a->h, a->radio, psdu, len);
+    if (ret)
+    {
+        return ret;
+    }
+    ret = at86rf215_set_cmd(a->h, AT86RF215_CMD_RF_TX, a->radio);
+    if (ret)
+    {
+        return ret;
+    }
+    a->tx_busy = 1;
+    a->tx_t0 = timebase_now();
+    a->tx_limit = timebase_us_to_ticks(airtime_us + ARQ_ACK_SLACK_US);
+    return AT86RF215_OK;
+}
+
+/*
+ * The TXFE of the last frame did not come in time, typically held up behind
+ * SPI traffic. The frame counts as a failed try: the radio goes back to RX
+ * through TRXOFF and a data frame is repeated once due, as if unacknowledged.
+ */
+static int tx_recover(struct arq *a)
+{
+    a->tx_busy = 0;
+    a->stats.tx_timeouts++;
+    int ret = at86rf215_set_trxoff(a->h, a->radio, RX_START_TIMEOUT_MS);
+    if (ret)
+    {
+        return ret;
+    }
+    return at86rf215_rx(a->h, a->radio, RX_START_TIMEOUT_MS);
+}
+
+static int send_ack(struct arq *a)
+{
+    uint8_t ack[ARQ_ACK_LEN + 4] = { ARQ_TYPE_ACK, a->rcv_base };
+    uint32_t bitmap = 0;
+    uint8_t i;
+    for (i = 1; i < ARQ_WINDOW; i++)
+    {
+        if (a->rcv[SLOT(a->rcv_base + i)])
+        {
+            bitmap |= 1UL << (i - 1);
+        }
+    }
+    ack[2] = bitmap;
+    ack[3] = bitmap >> 8;
+    ack[4] = bitmap >> 16;
+    ack[5] = bitmap >> 24;
+    a->stats.acks_sent++;
+    return transmit(a, ack, ARQ_ACK_LEN + fcs_len(a), a->ack_us);
+}
+
+static void rx_data(struct arq *a, struct at86rf215_rx_pkt *pkt, size_t len)
+{
+    const uint8_t seq = pkt->psdu[1];
+    /* Answered even if already received, the previous ACK may be lost */
+    a->ack_pending = 1;
+    if ((uint8_t) (seq - a->rcv_base) >= ARQ_WINDOW || a->rcv[SLOT(seq)])
+    {
+        a->stats.dups++;
+        return;
+    }
+    /* The block of pkt is already counted in use, see ARQ_RX_RESERVE */
+    if (seq != a->rcv_base
+            && frame_pool_free_blocks(AT86RF215_MAX_PDU) < ARQ_RX_RESERVE)
+    {
+        a->stats.not_held++;
+        return;
+    }
+    frame_buf_ref(pkt->buf);
+    a->rcv[SLOT(seq)] = pkt->buf;
+    a->rcv_len[SLOT(seq)] = len;
+
+    while (a->rcv[SLOT(a->rcv_base)])
+    {
+        const uint8_t i = SLOT(a->rcv_base);
+        struct frame_buf *buf = a->rcv[i];
+        a->rcv[i] = NULL;
+        a->rcv_base++;
+        a->stats.delivered++;
+        a->deliver(a, buf->data + ARQ_DATA_HDR, a->rcv_len[i] - ARQ_DATA_HDR,
+                   a->arg);
+        frame_buf_free(buf);
+    }
+}
+
+static void rx_ack(struct arq *a, const uint8_t *p)
+{
+    const uint8_t next = p[1];
+    const uint32_t bitmap = p[2] | (p[3] << 8) | ((uint32_t) p[4] << 16)
+            | ((uint32_t) p[5] << 24);
+    const uint8_t n = in_flight(a);
+    const uint8_t cum = next - a->snd_base;
+    a->stats.acks_rcvd++;
+    if (cum > n)
+    {
+        /* Older than the last one, or not ours */
+        return;
+    }
+
+    uint32_t newest = 0;
+    bool any = false;
+    uint8_t i;
+    for (i = 0; i < n; i++)
+    {
+        struct arq_slot *s = &a->snd[SLOT(a->snd_base + i)];
+        const uint8_t beyond = i - cum;
+        const bool ok = i < cum
+                || (beyond >= 1 && beyond <= 32
+                        && ((bitmap >> (beyond - 1)) & 1));
+        if (ok && !s->acked && s->tries)
+        {
+            s->acked = 1;
+            a->stats.acked++;
+            if (!any || timebase_diff(s->sent, newest) > 0)
+            {
+                newest = s->sent;
+            }
+            any = true;
+        }
+    }
+
+    /* Missing frames sent before an acknowledged one are lost, not late */
+    if (any)
+    {
+        const uint32_t now = timebase_now();
+        for (i = 0; i < n; i++)
+        {
+            struct arq_slot *s = &a->snd[SLOT(a->snd_base + i)];
+            if (!s->acked && s->tries && !s->fast
+                    && timebase_diff(s->sent, newest) < 0)
+            {
+                s->due = now;
+                s->fast = 1;
+            }
+        }
+    }
+
+    while (a->snd_base != a->snd_next && a->snd[SLOT(a->snd_base)].acked)
+    {
+        struct arq_slot *s = &a->snd[SLOT(a->snd_base)];
+        frame_buf_free(s->buf);
+        s->buf = NULL;
+        a->snd_base++;
+    }
+}
+
+static void rx_frame(struct arq *a, struct at86rf215_rx_pkt *pkt)
+{
+    const size_t fcs = fcs_len(a);
+    if (pkt->radio != a->radio || !pkt->fcs_ok || pkt->len < fcs + 2)
+    {
+        a->stats.dropped++;
+        return;
+    }
+    const size_t len = pkt->len - fcs;
+    if (pkt->psdu[0] == ARQ_TYPE_DATA)
+    {
+        rx_data(a, pkt, len);
+    }
+    else if (pkt->psdu[0] == ARQ_TYPE_ACK && len == ARQ_ACK_LEN)
+    {
+        rx_ack(a, pkt->psdu);
+    }
+    else
+    {
+        a->stats.dropped++;
+    }
+}
+
+/*
+ * Sets up the ARQ on a radio already configured, and puts it in RX with
+ * the RX pipeline armed. deliver receives the payloads of the peer.
+ */
+int arq_init(struct arq *a, struct at86rf215 *h, at86rf215_radio_t radio,
+             arq_deliver_cb_t deliver, void *arg)
+{
+    if (!a || !h || !deliver)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    memset(a, 0, sizeof(*a));
+    a->h = h;
+    a->radio = radio;
+    a->deliver = deliver;
+    a->arg = arg;
+    int ret = airtime_frame_us(&h->priv.bbc[radio], ARQ_ACK_LEN + fcs_len(a),
+                               &a->ack_us);
+    if (ret)
+    {
+        return ret;
+    }
+
+    /* BBC1 registers are at a 0x100 offset from BBC0 */
+    const uint16_t off = radio == AT86RF215_RF09 ? 0 : 0x100;
+    uint8_t val = 0;
+    ret = at86rf215_reg_read_8(h, &val, REG_BBC0_AMCS + off);
+    if (ret)
+    {
+        return ret;
+    }
+    ret = at86rf215_reg_write_8(h, val | AMCS_TX2RX, REG_BBC0_AMCS + off);
+    if (ret)
+    {
+        return ret;
+    }
+    ret = at86rf215_reg_read_8(h, &val, REG_BBC0_IRQM + off);
+    if (ret)
+    {
+        return ret;
+    }
+    ret = at86rf215_reg_write_8(h, val | BIT(AT86RF215_BB_IRQ_TXFE),
+                                REG_BBC0_IRQM + off);
+    if (ret)
+    {
+        return ret;
+    }
+    return at86rf215_rx_start(h, radio, RX_START_TIMEOUT_MS);
+}
+
+/*
+ * Drops the frames held in both directions and restarts the sequence
+ * numbers. The peer should be reset as well.
+ */
+void arq_reset(struct arq *a)
+{
+    uint8_t i;
+    for (i = 0; i < ARQ_WINDOW; i++)
+    {
+        if (a->snd[i].buf)
+        {
+            frame_buf_free(a->snd[i].buf);
+        }
+        if (a->rcv[i])
+        {
+            frame_buf_free(a->rcv[i]);
+        }
+        a->rcv[i] = NULL;
+    }
+    memset(a->snd, 0, sizeof(a->snd));
+    a->snd_base = 0;
+    a->snd_next = 0;
+    a->rcv_base = 0;
+    a->ack_pending = 0;
+}
+
+/*
+ * Queues a payload for transmission. Returns -AT86RF215_INVAL_CONF if the
+ * window or the frame pool is full: arq_poll() frees room as the peer
+ * acknowledges.
+ */
+int arq_send(struct arq *a, const uint8_t *data, size_t len)
+{
+    if (!a || (!data && len))
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    const size_t psdu_len = ARQ_DATA_HDR + len + fcs_len(a);
+    if (psdu_len > AT86RF215_MAX_PDU)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    if (!arq_window_free(a))
+    {
+        return -AT86RF215_INVAL_CONF;
+    }
+    struct arq_slot *s = &a->snd[SLOT(a->snd_next)];
+    int ret = airtime_frame_us(&a->h->priv.bbc[a->radio], psdu_len,
+                               &s->airtime_us);
+    if (ret)
+    {
+        return ret;
+    }
+    struct frame_buf *buf = frame_buf_alloc(psdu_len);
+    if (!buf)
+    {
+        return -AT86RF215_INVAL_CONF;
+    }
+    buf->data[0] = ARQ_TYPE_DATA;
+    buf->data[1] = a->snd_next;
+    memcpy(buf->data + ARQ_DATA_HDR, data, len);
+    buf->len = psdu_len;
+
+    s->buf = buf;
+    s->tries = 0;
+    s->acked = 0;
+    s->fast = 0;
+    a->snd_next++;
+    return AT86RF215_OK;
+}
+
+/* Payloads that arq_send() can still take */
+size_t arq_window_free(const struct arq *a)
+{
+    return ARQ_WINDOW - in_flight(a);
+}
+
+/*
+ * Collects the received frames, then starts at most one transmission: a
+ * pending ACK first, then the oldest frame due, then the oldest frame never
+ * sent. Should be called repeatedly from the main loop. Returns
+ * -AT86RF215_TIMEOUT once a frame went ARQ_MAX_TRIES times unacknowledged,
+ * the link is considered lost then until arq_reset(). A transmission whose
+ * end is not seen in time only costs a try, other errors come from the
+ * driver.
+ */
+int arq_poll(struct arq *a)
+{
+    struct at86rf215_radio *r = &a->h->priv.radios[a->radio];
+    struct at86rf215_rx_pkt *pkt;
+    while (at86rf215_rx_get(a->h, &pkt) == AT86RF215_OK)
+    {
+        rx_frame(a, pkt);
+        at86rf215_rx_release(a->h, pkt);
+    }
+
+    const uint32_t now = timebase_now();
+    if (a->tx_busy)
+    {
+        /* Set by the TXFE IRQ */
+        if (!r->tx_complete)
+        {
+            if ((uint32_t) timebase_diff(now, a->tx_t0) > a->tx_limit)
+            {
+                return tx_recover(a);
+            }
+            return AT86RF215_OK;
+        }
+        a->tx_busy = 0;
+    }
+
+    if (a->ack_pending)
+    {
+        a->ack_pending = 0;
+        return send_ack(a);
+    }
+
+    struct arq_slot *next = NULL;
+    const uint8_t n = in_flight(a);
+    uint8_t i;
+    for (i = 0; i < n; i++)
+    {
+        struct arq_slot *s = &a->snd[SLOT(a->snd_base + i)];
+        if (s->acked)
+        {
+            continue;
+        }
+        if (s->tries && timebase_diff(now, s->due) >= 0)
+        {
+            next = s;
+            break;
+        }
+        if (!s->tries && !next)
+        {
+            next = s;
+        }
+    }
+    if (!next)
+    {
+        return AT86RF215_OK;
+    }
+    if (next->tries >= ARQ_MAX_TRIES)
+    {
+        return -AT86RF215_TIMEOUT;
+    }
+
+    int ret = transmit(a, next->buf->data, next->buf->len, next->airtime_us);
+    if (ret)
+    {
+        return ret;
+    }
+    if (next->tries)
+    {
+        a->stats.retries++;
+        if (next->fast)
+        {
+            a->stats.fast_retries++;
+        }
+    }
+    a->stats.sent++;
+    next->tries++;
+    next->fast = 0;
+    next->sent = now;
+    next->due = now + timebase_us_to_ticks(next->airtime_us + a->ack_us
+                                          + ARQ_ACK_SLACK_US);
+    return AT86RF215_OK;
+}
+
+void arq_get_stats(const struct arq *a, struct arq_stats *stats)
+{
+    if (a && stats)
+    {
+        *stats = a->stats;
+    }
+}
@@ -20,6 +20,9 @@
 #include <at86rf215.h>
 #include <regs.h>
 #include <spi_helper.h>
+#include <frame_pool.h>
+#include <trace.h>
+#include <timebase.h>
 #include <stdbool.h>
 #include <string.h>
 #include <driverlib.h>
@@ -32,10 +35,22 @@
 #include <at86rf215Regs.h>
 
 
-static uint8_t spi_buffer[AT86RF215_MAX_PDU + 2];
+#if (AT86RF215_RX_QUEUE_LEN & (AT86RF215_RX_QUEUE_LEN - 1)) \
+    || AT86RF215_RX_QUEUE_LEN > 32
+#error "AT86RF215_RX_QUEUE_LEN should be a power of 2, up to 32"
+#endif
+#define RX_NONE (0xFF)
+
+/* The frame buffer upload of each radio, and the bytes already queued */
+static SpiJob_t rx_upload_job[2];
+static uint16_t rx_upload_pos[2];
 
 #define INIT_MAGIC_VAL 0x92c2f0e3
 
+/* BBCn_AMCS: CCA with automatic TX, and its outcome */
+#define AMCS_CCATX BIT(1)
+#define AMCS_CCAED BIT(2)
+
 #ifndef max
 #define max(a, b)                                                              \
   ({                                                                           \
@@ -196,11 +211,32 @@ static int supports_mode(struct at86rf215 *h, at86rf215_chpm_t mode)
     return AT86RF215_OK;
 }
 
+/**
+ * Waits for the IRQ line to rise after a reset. The IC raises the WAKEUP IRQ
+ * as soon as it reaches TRXOFF, which is typically much earlier than the
+ * worst case the datasheet lists
+ * @param h the device handle
+ * @return 0 on success or negative error code
+ */
+static int wait_wakeup(struct at86rf215 *h)
+{
+    const uint32_t t0 = cycle_counter_get();
+    while (!at86rf215_get_irq_line(h))
+    {
+        if (cycles_to_us(cycle_counter_get() - t0)
+                > AT86RF215_WAKEUP_TIMEOUT_US)
+        {
+            return -AT86RF215_TIMEOUT;
+        }
+    }
+    return AT86RF215_OK;
+}
+
 /**
  * Resets and initializes the AT86RF215 IC
+ * @note the cycle counter (cycle_counter_init()) should be running, it
+ * bounds the wait for the wake-up IRQ
  * @param h the device handle
- * @param drv clock output driving current
- * @param os clock output selection
  * @return 0 on success or negative error code
  */
 int at86rf215_init(struct at86rf215 *h)
@@ -213,31 +249,31 @@ int at86rf215_init(struct at86rf215 *h)
     memset(&h->priv, 0, sizeof(struct at86rf215_priv));
 
     at86rf215_irq_enable(h, 0);
-    // /* Reset the IC */
+    /* Reset the IC */
     at86rf215_set_rstn(h, 0);
-    at86rf215_delay_us(h, 1000);
+    at86rf215_delay_us(h, AT86RF215_RSTN_PULSE_US);
     at86rf215_set_rstn(h, 1);
-    at86rf215_delay_us(h, 1000);
-
-    uint8_t val = 10;
-    int ret = AT86RF215Read(REG_RF_PN);
 
+    int ret = wait_wakeup(h);
     if (ret)
     {
         return ret;
     }
 
-    //puts("dance");
-    printf("value in reg %x\n",val);
-    fflush(stdout);
-
+    /* RF_PN and RF_VN are contiguous */
+    uint8_t id[2] = { 0x0, 0x0 };
+    ret = at86rf215_reg_read_burst(h, id, REG_RF_PN, 2);
+    if (ret)
+    {
+        return ret;
+    }
 
-    switch (val)
+    switch (id[0])
     {
     case AT86RF215:
     case AT86RF215IQ:
     case AT86RF215M:
-        h->priv.family = (at86rf215_family_t) val;
+        h->priv.family = (at86rf215_family_t) id[0];
         break;
     default:
         GPIO_setAsOutputPin(
@@ -245,104 +281,103 @@ int at86rf215_init(struct at86rf215 *h)
                             GPIO_PIN2);
         return -AT86RF215_UNKNOWN_IC;
     }
-    //
-    // val = 0;
-    // switch (h->clk_drv) {
-    // case AT86RF215_RF_DRVCLKO2:
-    // case AT86RF215_RF_DRVCLKO4:
-    // case AT86RF215_RF_DRVCLKO6:
-    // case AT86RF215_RF_DRVCLKO8:
-    //   val = h->clk_drv << 3;
-    //   break;
-    // default:
-    //   return -AT86RF215_INVAL_PARAM;
-    // }
-    // switch (h->clko_os) {
-    // case AT86RF215_RF_CLKO_OFF:
-    // case AT86RF215_RF_CLKO_26_MHZ:
-    // case AT86RF215_RF_CLKO_32_MHZ:
-    // case AT86RF215_RF_CLKO_16_MHZ:
-    // case AT86RF215_RF_CLKO_8_MHZ:
-    // case AT86RF215_RF_CLKO_4_MHZ:
-    // case AT86RF215_RF_CLKO_2_MHZ:
-    // case AT86RF215_RF_CLKO_1_MHZ:
-    //   val |= h->clko_os;
-    //   break;
-    // }
-    // ret = at86rf215_reg_write_8(h, val, REG_RF_CLKO);
-    // if (ret) {
-    //   return ret;
-    // }
-    //
-    // /* Apply XO settings */
-    // ret = at86rf215_reg_write_8(h, (h->xo_fs << 4) | h->xo_trim, REG_RF_XOC);
-    // if (ret) {
-    //   return ret;
-    // }
-    //
-    // /* Set the RF_CFG */
-    // ret = at86rf215_reg_write_8(h, (h->irqmm << 3) | (h->irqp << 2) | h->pad_drv,
-    //                             REG_RF_CFG);
-    // if (ret) {
-    //   return ret;
-    // }
-    //
-    // /* Set RF09_PADFE and RF24_PADFE */
-    // val = 0;
-    // switch (h->rf_femode_09) {
-    // case AT86RF215_RF_FEMODE0:
-    // case AT86RF215_RF_FEMODE1:
-    // case AT86RF215_RF_FEMODE2:
-    // case AT86RF215_RF_FEMODE3:
-    //   val = h->rf_femode_09 << 6;
-    //   break;
-    // default:
-    //   return -AT86RF215_INVAL_PARAM;
-    // }
-    // ret = at86rf215_reg_write_8(h, val, REG_RF09_PADFE);
-    // if (ret) {
-    //   return ret;
-    // }
-    //
-    // val = 0;
-    // switch (h->rf_femode_24) {
-    // case AT86RF215_RF_FEMODE0:
-    // case AT86RF215_RF_FEMODE1:
-    // case AT86RF215_RF_FEMODE2:
-    // case AT86RF215_RF_FEMODE3:
-    //   val = h->rf_femode_24 << 6;
-    //   break;
-    // default:
-    //   return -AT86RF215_INVAL_PARAM;
-    // }
-    // ret = at86rf215_reg_write_8(h, val, REG_RF24_PADFE);
-    // if (ret) {
-    //   return ret;
-    // }
-    //
-    // /* Get the version of the IC */
-    // ret = at86rf215_reg_read_8(h, &val, REG_RF_VN);
-    // if (ret) {
-    //   return ret;
-    // }
-    // h->priv.version = val;
-    // h->priv.chpm    = AT86RF215_RF_MODE_BBRF;
-    // h->priv.init    = INIT_MAGIC_VAL;
-    //
-    // /*Enable the IRQs that are necessary for the driver */
-    // at86rf215_set_bbc_irq_mask(h, AT86RF215_RF09, BIT(4));
-    // at86rf215_set_bbc_irq_mask(h, AT86RF215_RF24, BIT(4));
-    // at86rf215_set_radio_irq_mask(h, AT86RF215_RF09, BIT(1));
-    // at86rf215_set_radio_irq_mask(h, AT86RF215_RF24, BIT(1));
-    //
-    // /* Assert any active IRQ */
-    // at86rf215_reg_read_8(h, &val, REG_RF09_IRQS);
-    // at86rf215_reg_read_8(h, &val, REG_RF24_IRQS);
-    // at86rf215_reg_read_8(h, &val, REG_BBC0_IRQS);
-    // at86rf215_reg_read_8(h, &val, REG_BBC1_IRQS);
-    //
-    // at86rf215_irq_enable(h, 1);
-    return AT86RF215_OK;
+
+    uint8_t val = 0;
+    switch (h->clk_drv)
+    {
+    case AT86RF215_RF_DRVCLKO2:
+    case AT86RF215_RF_DRVCLKO4:
+    case AT86RF215_RF_DRVCLKO6:
+    case AT86RF215_RF_DRVCLKO8:
+        val = h->clk_drv << 3;
+        break;
+    default:
+        return -AT86RF215_INVAL_PARAM;
+    }
+    switch (h->clko_os)
+    {
+    case AT86RF215_RF_CLKO_OFF:
+    case AT86RF215_RF_CLKO_26_MHZ:
+    case AT86RF215_RF_CLKO_32_MHZ:
+    case AT86RF215_RF_CLKO_16_MHZ:
+    case AT86RF215_RF_CLKO_8_MHZ:
+    case AT86RF215_RF_CLKO_4_MHZ:
+    case AT86RF215_RF_CLKO_2_MHZ:
+    case AT86RF215_RF_CLKO_1_MHZ:
+        val |= h->clko_os;
+        break;
+    default:
+        return -AT86RF215_INVAL_PARAM;
+    }
+
+    /* RF_CFG, RF_CLKO, RF_BMDVC and RF_XOC are contiguous */
+    uint8_t cfg[4];
+    cfg[0] = (h->irqmm << 3) | (h->irqp << 2) | h->pad_drv;
+    cfg[1] = val;
+    ret = at86rf215_reg_read_8(h, &cfg[2], REG_RF_BMDVC);
+    if (ret)
+    {
+        return ret;
+    }
+    cfg[3] = (h->xo_fs << 4) | h->xo_trim;
+    ret = at86rf215_reg_write_burst(h, cfg, REG_RF_CFG, sizeof(cfg));
+    if (ret)
+    {
+        return ret;
+    }
+
+    /* Set RF09_PADFE and RF24_PADFE */
+    switch (h->rf_femode_09)
+    {
+    case AT86RF215_RF_FEMODE0:
+    case AT86RF215_RF_FEMODE1:
+    case AT86RF215_RF_FEMODE2:
+    case AT86RF215_RF_FEMODE3:
+        break;
+    default:
+        return -AT86RF215_INVAL_PARAM;
+    }
+    ret = at86rf215_reg_write_8(h, h->rf_femode_09 << 6, REG_RF09_PADFE);
+    if (ret)
+    {
+        return ret;
+    }
+
+    switch (h->rf_femode_24)
+    {
+    case AT86RF215_RF_FEMODE0:
+    case AT86RF215_RF_FEMODE1:
+    case AT86RF215_RF_FEMODE2:
+    case AT86RF215_RF_FEMODE3:
+        break;
+    default:
+        return -AT86RF215_INVAL_PARAM;
+    }
+    ret = at86rf215_reg_write_8(h, h->rf_femode_24 << 6, REG_RF24_PADFE);
+    if (ret)
+    {
+        return ret;
+    }
+
+    h->priv.version = id[1];
+    h->priv.chpm    = AT86RF215_RF_MODE_BBRF;
+    h->priv.init    = INIT_MAGIC_VAL;
+
+    /*Enable the IRQs that are necessary for the driver */
+    at86rf215_set_bbc_irq_mask(h, AT86RF215_RF09, BIT(4));
+    at86rf215_set_bbc_irq_mask(h, AT86RF215_RF24, BIT(4));
+    at86rf215_set_radio_irq_mask(h, AT86RF215_RF09, BIT(1));
+    at86rf215_set_radio_irq_mask(h, AT86RF215_RF24, BIT(1));
+
+    /* Acknowledge any active IRQ, the WAKEUP included */
+    uint8_t irqs[AT86RF215_IRQ_SRC_NUM];
+    ret = at86rf215_reg_read_burst(h, irqs, REG_RF09_IRQS,
+                                   AT86RF215_IRQ_SRC_NUM);
+    if (ret)
+    {
+        return ret;
+    }
+    return at86rf215_irq_enable(h, 1);
 }
 
 /**
@@ -548,17 +583,27 @@ __attribute__((weak)) int at86rf215_set_rstn(struct at86rf215 *h,
  * Controls the state of the SELN pin
  * @param h the device handle
  * @param enable set to 1 to set the SELN pin to high, 0 to set it to low
- * @return 0 on success or negative error code
+ * @return 0 on success or negative error code. From interrupt context,
+ * -AT86RF215_BUS_BUSY if the bus was taken by the preempted code
  */
 __attribute__((weak)) int at86rf215_set_seln(struct at86rf215 *h,
                                               uint8_t enable)
 {
+    /*
+     * The SELN window is the unit of bus ownership: queued SPI jobs stay off
+     * the bus until SELN is released again.
+     */
     if (enable)
     {
         GPIO_setOutputHighOnPin(GPIO_PORT_P3, GPIO_PIN0); //pin = 0x0001 --->gpio '0'
+        SpiBusUnlock();
     }
     else
     {
+        if (!SpiBusLock())
+        {
+            return -AT86RF215_BUS_BUSY;
+        }
         GPIO_setOutputLowOnPin(GPIO_PORT_P3, GPIO_PIN0);
     }
     return AT86RF215_OK;
@@ -600,19 +645,6 @@ __attribute__((weak))  size_t at86rf215_get_time_ms(struct at86rf215 *h)
  * @return 0 on success or negative error code
  */
 
-// ---- Set your CS pin here ----
-#define AT86_CS_PORT     GPIO_PORT_P3
-#define AT86_CS_PIN      GPIO_PIN0
-
-static inline void cs_assert(void)
-{
-    GPIO_setOutputLowOnPin(AT86_CS_PORT, AT86_CS_PIN);
-}
-static inline void cs_deassert(void)
-{
-    GPIO_setOutputHighOnPin(AT86_CS_PORT, AT86_CS_PIN);
-}
-
 // Blocking xfer of one byte on eUSCI_B0
 static inline uint8_t spi_xfer_u8(uint8_t tx)
 {
@@ -638,26 +670,25 @@ __attribute__((weak)) int at86rf215_spi_read(struct at86rf215 *h, uint8_t *out,
         return -AT86RF215_INVAL_PARAM;
     }
 
-    // Assert CS
-    cs_assert();
-
+    /*
+     * SELN is driven by the caller through at86rf215_set_seln(), so several
+     * read/write calls can share a single transaction.
+     *
+     * Full duplex: the MISO bytes are captured from the first clocked byte,
+     * so out[0..tx_len-1] hold the response to the command/address phase.
+     * Bytes past tx_len are clocked out as 0x00.
+     */
     size_t i;
-
-    // Phase 1: send command/address/etc. (discard RX)
-    for ( i = 0; i < tx_len; ++i)
-    {
-        (void) SpiInOut_IQRadio(in[i]);
-    }
-    i=0;
-    // Phase 2: read response by clocking dummy bytes (0x00)
-    for (i = 0; i < rx_len; ++i)
+    const size_t n = max(tx_len, rx_len);
+    for (i = 0; i < n; ++i)
     {
-        out[i] = SpiInOut_IQRadio(0x00);
+        uint8_t miso = SpiInOut_IQRadio(i < tx_len ? in[i] : 0x00);
+        if (i < rx_len)
+        {
+            out[i] = miso;
+        }
     }
 
-    // Deassert CS
-    cs_deassert();
-
     return 0;
 }
 
@@ -678,15 +709,12 @@ __attribute__((weak)) int at86rf215_spi_write(struct at86rf215 *h,
         return -AT86RF215_INVAL_PARAM;
     }
 
-    cs_assert();
     size_t i;
     for (i = 0; i < len; i++)
     {
         SpiInOut_IQRadio(in[i]); // transmit each byte, ignore RX
     }
 
-    cs_deassert();
-
     return 0;
 }
 
@@ -725,6 +753,7 @@ int at86rf215_reg_read_8(struct at86rf215 *h, uint8_t *out, uint16_t reg)
     //   return ret;
     // }
     *out = miso[2];
+    trace_put(TRACE_REG_READ, *out, reg);
     at86rf215_irq_enable(h, 1);
     return at86rf215_set_seln(h, 1);
 }
@@ -765,7 +794,53 @@ int at86rf215_reg_read_32(struct at86rf215 *h, uint32_t *out, uint16_t reg)
         return ret;
     }
     *out = (miso[2] << 24) | (miso[3] << 16) | (miso[4] << 8) | miso[5];
+    trace_put(TRACE_BURST_READ, 4, reg);
+    at86rf215_irq_enable(h, 1);
+    return at86rf215_set_seln(h, 1);
+}
+
+/**
+ * Reads \p len consecutive registers starting from \p reg using a single
+ * SPI transaction
+ * @note internally the function uses the at86rf215_set_seln() and
+ * at86rf215_spi_read() to accomplish the SPI transaction. Developers should
+ * provide a proper implementation of those functions.
+ *
+ * @param h the device handle
+ * @param out buffer to hold the register values. Should be at least \p len
+ * bytes
+ * @param reg the first register to read
+ * @param len the number of registers to read
+ * @return 0 on success or negative error code
+ */
+int at86rf215_reg_read_burst(struct at86rf215 *h, uint8_t *out, uint16_t reg,
+                             size_t len)
+{
+    if (!out || len == 0)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    int ret = 0;
+    ret = at86rf215_set_seln(h, 0);
+    if (ret)
+    {
+        return ret;
+    }
+    at86rf215_irq_enable(h, 0);
+    /* Address phase first, its MISO bytes carry no data */
+    const uint8_t mosi[2] = { (reg >> 8) & 0x3F, reg & 0xFF };
+    ret = at86rf215_spi_read(h, NULL, mosi, 2, 0);
+    if (ret == 0)
+    {
+        ret = at86rf215_spi_read(h, out, NULL, 0, len);
+    }
+    trace_put(TRACE_BURST_READ, TRACE_LEN8(len), reg);
     at86rf215_irq_enable(h, 1);
+    if (ret)
+    {
+        at86rf215_set_seln(h, 1);
+        return ret;
+    }
     return at86rf215_set_seln(h, 1);
 }
 
@@ -799,6 +874,7 @@ int at86rf215_reg_write_8(struct at86rf215 *h, const uint8_t in, uint16_t reg)
         at86rf215_irq_enable(h, 1);
         return ret;
     }
+    trace_put(TRACE_REG_WRITE, in, reg);
     at86rf215_irq_enable(h, 1);
     return at86rf215_set_seln(h, 1);
 }
@@ -834,10 +910,169 @@ int at86rf215_reg_write_16(struct at86rf215 *h, const uint16_t in, uint16_t reg)
         at86rf215_irq_enable(h, 1);
         return ret;
     }
+    trace_put(TRACE_BURST_WRITE, 2, reg);
+    at86rf215_irq_enable(h, 1);
+    return at86rf215_set_seln(h, 1);
+}
+
+/**
+ * Writes \p len consecutive registers starting from \p reg using a single
+ * SPI transaction
+ *
+ * @note internally the function uses the at86rf215_set_seln() and
+ * at86rf215_spi_write() to accomplish the SPI transaction. Developers should
+ * provide a proper implementation of those functions.
+ *
+ * @param h the device handle
+ * @param in the register values
+ * @param reg the first register to write
+ * @param len the number of registers to write
+ * @return 0 on success or negative error code
+ */
+int at86rf215_reg_write_burst(struct at86rf215 *h, const uint8_t *in,
+                              uint16_t reg, size_t len)
+{
+    if (!in || len == 0)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    int ret = 0;
+    ret = at86rf215_set_seln(h, 0);
+    if (ret)
+    {
+        return ret;
+    }
+    at86rf215_irq_enable(h, 0);
+    /* Construct properly the MOSI buffer */
+    uint8_t mosi[2] = { (reg >> 8) | 0x80, reg & 0xFF };
+    ret = at86rf215_spi_write(h, mosi, 2);
+    if (ret == 0)
+    {
+        ret = at86rf215_spi_write(h, in, len);
+    }
+    trace_put(TRACE_BURST_WRITE, TRACE_LEN8(len), reg);
     at86rf215_irq_enable(h, 1);
+    if (ret)
+    {
+        at86rf215_set_seln(h, 1);
+        return ret;
+    }
     return at86rf215_set_seln(h, 1);
 }
 
+/* Length of the run of contiguous registers starting at img[i] */
+static size_t image_run(const struct at86rf215_reg_val *img, size_t n,
+                        size_t i)
+{
+    size_t len = 1;
+    while (i + len < n && len < AT86RF215_REG_IMAGE_RUN
+            && img[i + len].reg == img[i].reg + len)
+    {
+        len++;
+    }
+    return len;
+}
+
+static int image_check(struct at86rf215 *h, const struct at86rf215_reg_val *img,
+                       size_t n)
+{
+    size_t i;
+    int ret = ready(h);
+    if (ret)
+    {
+        return ret;
+    }
+    if (!img || n == 0)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    /* Checked up front, a bad image should not be half applied */
+    for (i = 1; i < n; i++)
+    {
+        if (img[i].reg <= img[i - 1].reg)
+        {
+            return -AT86RF215_INVAL_PARAM;
+        }
+    }
+    return AT86RF215_OK;
+}
+
+/**
+ * Writes a register image. Each run of contiguous registers goes out with a
+ * single burst, so a full configuration takes a few SPI transactions
+ * instead of a read-modify-write per field.
+ * @param h the device handle
+ * @param img the image, sorted by ascending register
+ * @param n the number of entries of the image
+ * @return 0 on success or negative error code
+ */
+int at86rf215_reg_image_apply(struct at86rf215 *h,
+                              const struct at86rf215_reg_val *img, size_t n)
+{
+    uint8_t run[AT86RF215_REG_IMAGE_RUN];
+    size_t i, j, len;
+    int ret = image_check(h, img, n);
+    if (ret)
+    {
+        return ret;
+    }
+    for (i = 0; i < n; i += len)
+    {
+        len = image_run(img, n, i);
+        for (j = 0; j < len; j++)
+        {
+            run[j] = img[i + j].val;
+            /* Keep track of the chip mode, as at86rf215_set_mode() does */
+            if (img[i + j].reg == REG_RF_IQIFC1)
+            {
+                h->priv.chpm = (at86rf215_chpm_t) ((run[j] >> 4) & 0x7);
+            }
+        }
+        ret = at86rf215_reg_write_burst(h, run, img[i].reg, len);
+        if (ret)
+        {
+            return ret;
+        }
+    }
+    return AT86RF215_OK;
+}
+
+/**
+ * Fills the values of a register image with the current register contents.
+ * Useful to produce the image of a configuration made through the regular
+ * API, for later use with at86rf215_reg_image_apply().
+ * @param h the device handle
+ * @param img the image, sorted by ascending register. Only the values are
+ * modified
+ * @param n the number of entries of the image
+ * @return 0 on success or negative error code
+ */
+int at86rf215_reg_image_capture(struct at86rf215 *h,
+                                struct at86rf215_reg_val *img, size_t n)
+{
+    uint8_t run[AT86RF215_REG_IMAGE_RUN];
+    size_t i, j, len;
+    int ret = image_check(h, img, n);
+    if (ret)
+    {
+        return ret;
+    }
+    for (i = 0; i < n; i += len)
+    {
+        len = image_run(img, n, i);
+        ret = at86rf215_reg_read_burst(h, run, img[i].reg, len);
+        if (ret)
+        {
+            return ret;
+        }
+        for (j = 0; j < len; j++)
+        {
+            img[i + j].val = run[j];
+        }
+    }
+    return AT86RF215_OK;
+}
+
 /**
  * Retrieve the RF state of the transceiver
  * @param h the device handle
@@ -959,6 +1194,7 @@ int at86rf215_set_trxoff(struct at86rf215 *h, at86rf215_radio_t radio,
             return -AT86RF215_TIMEOUT;
         }
         at86rf215_set_cmd(h, AT86RF215_CMD_RF_TRXOFF, radio);
+        at86rf215_get_state(h, &state, radio);
     }
     return AT86RF215_OK;
 }
@@ -1405,21 +1641,55 @@ int at86rf215_set_freq(struct at86rf215 *h, at86rf215_radio_t radio,
     {
         return ret;
     }
-    /* The radio should be in fine freq mode to set the frequency */
-    if (radio == AT86RF215_RF09)
+    struct at86rf215_retune t;
+    ret = at86rf215_retune_freq(h, radio, freq, &t);
+    if (ret)
     {
-        uint32_t x = 0;
-        if (h->priv.radios[AT86RF215_RF09].cm == AT86RF215_CM_FINE_RES_04)
-        {
-            if (freq < 389500000 || freq > 510000000)
-            {
-                return -AT86RF215_INVAL_PARAM;
-            }
-            x = ((freq - 377e6) * (1 << 16)) / 6.5e6;
-        }
-        else if (h->priv.radios[AT86RF215_RF09].cm == AT86RF215_CM_FINE_RES_09)
-        {
-            if (freq < 779000000 || freq > 1020000000)
+        return ret;
+    }
+    return at86rf215_retune(h, radio, &t);
+}
+
+/**
+ * Precomputes the CCF0L, CCF0H, CNL and CNM register values for a center
+ * frequency, so the frontend can later be retuned with a single SPI burst
+ * @note the RF frontend should be in Fine Resolution mode. Otherwise the
+ * -AT86RF215_INVAL_CONF error code is returned
+ *
+ * @param h the device handle
+ * @param radio the RF frontend
+ * @param freq the center frequency in Hz
+ * @param t pointer to hold the register values
+ * @return 0 on success or negative error code
+ */
+int at86rf215_retune_freq(struct at86rf215 *h, at86rf215_radio_t radio,
+                          uint32_t freq, struct at86rf215_retune *t)
+{
+    int ret = radio_ready(h, radio);
+    if (ret)
+    {
+        return ret;
+    }
+    if (!t)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    /* The radio should be in fine freq mode to set the frequency */
+    uint32_t x = 0;
+    const at86rf215_cm_t cm = h->priv.radios[radio].cm;
+    if (radio == AT86RF215_RF09)
+    {
+        if (cm == AT86RF215_CM_FINE_RES_04)
+        {
+            if (freq < 389500000 || freq > 510000000)
+            {
+                return -AT86RF215_INVAL_PARAM;
+            }
+            x = ((freq - 377e6) * (1 << 16)) / 6.5e6;
+        }
+        else if (cm == AT86RF215_CM_FINE_RES_09)
+        {
+            if (freq < 779000000 || freq > 1020000000)
             {
                 return -AT86RF215_INVAL_PARAM;
             }
@@ -1429,33 +1699,10 @@ int at86rf215_set_freq(struct at86rf215 *h, at86rf215_radio_t radio,
         {
             return -AT86RF215_INVAL_CONF;
         }
-        /* Apply the frequency setting */
-        ret = at86rf215_reg_write_8(h, (x >> 16) & 0xFF, REG_RF09_CCF0H);
-        if (ret)
-        {
-            return ret;
-        }
-        ret = at86rf215_reg_write_8(h, (x >> 8) & 0xFF, REG_RF09_CCF0L);
-        if (ret)
-        {
-            return ret;
-        }
-        ret = at86rf215_reg_write_8(h, x & 0xFF, REG_RF09_CNL);
-        if (ret)
-        {
-            return ret;
-        }
-        ret = at86rf215_reg_write_8(h, h->priv.radios[radio].cm << 6,
-                                    REG_RF09_CNM);
-        if (ret)
-        {
-            return ret;
-        }
     }
     else
     {
-        uint32_t x = 0;
-        if (h->priv.radios[AT86RF215_RF24].cm == AT86RF215_CM_FINE_RES_24)
+        if (cm == AT86RF215_CM_FINE_RES_24)
         {
             if (freq < 2400000000 || freq > 2486000000)
             {
@@ -1467,32 +1714,74 @@ int at86rf215_set_freq(struct at86rf215 *h, at86rf215_radio_t radio,
         {
             return -AT86RF215_INVAL_CONF;
         }
-        /* Apply the frequency setting */
-        ret = at86rf215_reg_write_8(h, (x >> 16) & 0xFF, REG_RF24_CCF0H);
-        if (ret)
-        {
-            return ret;
-        }
-        ret = at86rf215_reg_write_8(h, (x >> 8) & 0xFF, REG_RF24_CCF0L);
-        if (ret)
-        {
-            return ret;
-        }
-        ret = at86rf215_reg_write_8(h, x & 0xFF, REG_RF24_CNL);
-        if (ret)
-        {
-            return ret;
-        }
-        ret = at86rf215_reg_write_8(h, h->priv.radios[radio].cm << 6,
-                                    REG_RF24_CNM);
-        if (ret)
-        {
-            return ret;
-        }
     }
+    t->regs[0] = (x >> 8) & 0xFF;
+    t->regs[1] = (x >> 16) & 0xFF;
+    t->regs[2] = x & 0xFF;
+    t->regs[3] = cm << 6;
+    return AT86RF215_OK;
+}
+
+/**
+ * Precomputes the register values of an IEEE channel, so the frontend can
+ * later be retuned with a single SPI burst. The channel center frequency
+ * currently programmed is kept.
+ * @note the RF frontend should be in IEEE compliant channel mode
+ *
+ * @param h the device handle
+ * @param radio the RF frontend
+ * @param channel channel index
+ * @param t pointer to hold the register values
+ * @return 0 on success or negative error code
+ */
+int at86rf215_retune_channel(struct at86rf215 *h, at86rf215_radio_t radio,
+                             uint16_t channel, struct at86rf215_retune *t)
+{
+    int ret = radio_ready(h, radio);
+    if (ret)
+    {
+        return ret;
+    }
+    if (!t || channel > 0x1FF)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    if (h->priv.radios[radio].cm != AT86RF215_CM_IEEE)
+    {
+        return -AT86RF215_INVAL_CONF;
+    }
+    const uint16_t off = radio == AT86RF215_RF09 ? 0 : 0x100;
+    ret = at86rf215_reg_read_burst(h, t->regs, REG_RF09_CCF0L + off, 2);
+    if (ret)
+    {
+        return ret;
+    }
+    t->regs[2] = channel & 0xFF;
+    t->regs[3] = (AT86RF215_CM_IEEE << 6) | ((channel >> 8) & 0x1);
     return AT86RF215_OK;
 }
 
+/**
+ * Retunes the RF frontend with a single 4-byte burst to CCF0L..CNM. The new
+ * setting takes effect with the CNM write, which is the last one.
+ * @param h the device handle
+ * @param radio the RF frontend
+ * @param t the values from at86rf215_retune_freq() or
+ * at86rf215_retune_channel()
+ * @return 0 on success or negative error code
+ */
+int at86rf215_retune(struct at86rf215 *h, at86rf215_radio_t radio,
+                     const struct at86rf215_retune *t)
+{
+    if (!t)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    const uint16_t reg =
+            radio == AT86RF215_RF09 ? REG_RF09_CCF0L : REG_RF24_CCF0L;
+    return at86rf215_reg_write_burst(h, t->regs, reg, sizeof(t->regs));
+}
+
 /**
  * Enable/disable the AT86RF215 IRQ line
  * @note Especially for bare metal applications (no-OS), race conditions may
@@ -1513,15 +1802,13 @@ __attribute__((weak)) int at86rf215_irq_enable(struct at86rf215 *h,
             return -AT86RF215_INVAL_PARAM;
         }
 
+        /*
+         * The IRQ line is a level that stays high until the IRQS registers
+         * are read, so an edge latched while masked must not be cleared: it
+         * would be the last one. The rising edge is selected once at start.
+         */
         if (enable)
         {
-            // Rising edge: AT86RF215 IRQ is active-high pulse/level
-            GPIO_interruptEdgeSelect(GPIO_PORT_P2, GPIO_PIN3,
-            GPIO_LOW_TO_HIGH_TRANSITION);
-
-            // Clear any stale flags before enabling
-            GPIO_clearInterruptFlag(GPIO_PORT_P2, GPIO_PIN3);
-
             // Enable pin interrupt + NVIC for its port
             GPIO_enableInterrupt(GPIO_PORT_P2, GPIO_PIN3);
             Interrupt_enableInterrupt(INT_PORT2);
@@ -1532,15 +1819,24 @@ __attribute__((weak)) int at86rf215_irq_enable(struct at86rf215 *h,
             GPIO_disableInterrupt(GPIO_PORT_P2, GPIO_PIN3);
             // Optional: keep NVIC enabled if other pins on this port use IRQs
             // Interrupt_disableInterrupt(AT86RF215_IRQ_NVIC);
-
-            // Clear flag to avoid a queued ISR after re-enable
-            GPIO_clearInterruptFlag(GPIO_PORT_P2, GPIO_PIN3);
         }
 
         return AT86RF215_OK;
     }
 }
 
+/**
+ * Reads the level of the AT86RF215 IRQ line, whether the IRQ is enabled or
+ * not. Used to catch the wake-up IRQ during at86rf215_init()
+ * @param h the device handle
+ * @return 1 if the IRQ is asserted, 0 otherwise
+ */
+__attribute__((weak)) int at86rf215_get_irq_line(struct at86rf215 *h)
+{
+    (void) h;
+    return GPIO_getInputPinValue(GPIO_PORT_P2, GPIO_PIN3) ? 1 : 0;
+}
+
 /**
  * Get the PLL lock status for the corresponding RF frontend
  * @param h the device handle
@@ -1667,7 +1963,8 @@ int at86rf215_get_rssi(struct at86rf215 *h, at86rf215_radio_t radio,
     {
         return -AT86RF215_INVAL_VAL;
     }
-    *rssi = val;
+    /* Two's complement dBm */
+    *rssi = (int8_t) val;
     return AT86RF215_OK;
 }
 
@@ -1702,7 +1999,8 @@ int at86rf215_get_edv(struct at86rf215 *h, at86rf215_radio_t radio, float *edv)
     {
         return -AT86RF215_INVAL_VAL;
     }
-    *edv = val;
+    /* Two's complement dBm */
+    *edv = (int8_t) val;
     return AT86RF215_OK;
 }
 
@@ -1852,6 +2150,15 @@ int at86rf215_set_agc_control(struct at86rf215 *h, at86rf215_radio_t radio,
     return AT86RF215_OK;
 }
 
+/**
+ * @brief Sets the RX gain control word (AGCS.GCW)
+ * @note the value is taken into account only while the AGC is disabled
+ *
+ * @param h the device handle
+ * @param radio the RF frontend
+ * @param gain the gain control word, 0 (minimum) to 23 (maximum gain)
+ * @return 0 on success or an appropriate negative error code
+ */
 int at86rf215_set_agc_gain(struct at86rf215 *h, at86rf215_radio_t radio,
                            uint8_t gain)
 {
@@ -1861,7 +2168,7 @@ int at86rf215_set_agc_gain(struct at86rf215 *h, at86rf215_radio_t radio,
         return ret;
     }
 
-    if (!gain)
+    if (gain > 23)
     {
         return -AT86RF215_INVAL_PARAM;
     }
@@ -1880,10 +2187,9 @@ int at86rf215_set_agc_gain(struct at86rf215 *h, at86rf215_radio_t radio,
     {
         return ret;
     }
+    /* Keep the target level in AGCS.TGT */
     val &= 0xE0;
     val |= (gain & 0x1F);
-    // FIXME
-    val |= 0x3 << 4;
     ret = at86rf215_reg_write_8(h, val, reg);
     if (ret)
     {
@@ -1932,6 +2238,150 @@ int at86rf215_get_agc_gain(struct at86rf215 *h, at86rf215_radio_t radio,
     return AT86RF215_OK;
 }
 
+/**
+ * Stores the current AGC gain of the radio in the gain cache
+ * @param h the device handle
+ * @param radio the RF frontend
+ * @param key the channel key
+ * @return 0 on success or an appropriate negative error code
+ */
+int at86rf215_agc_cache_store(struct at86rf215 *h, at86rf215_radio_t radio,
+                              uint32_t key)
+{
+    size_t i;
+    uint8_t gcw = 0;
+    int ret = at86rf215_get_agc_gain(h, radio, &gcw);
+    if (ret)
+    {
+        return ret;
+    }
+    struct at86rf215_agc_cache *c = &h->priv.agc_cache[radio];
+    struct at86rf215_agc_cache_entry *e = NULL;
+    for (i = 0; i < AT86RF215_AGC_CACHE_SIZE; i++)
+    {
+        if (c->e[i].valid && c->e[i].key == key)
+        {
+            e = &c->e[i];
+            break;
+        }
+    }
+    if (!e)
+    {
+        e = &c->e[c->victim];
+        c->victim = (c->victim + 1) % AT86RF215_AGC_CACHE_SIZE;
+    }
+    e->key = key;
+    e->gcw = gcw;
+    e->valid = 1;
+    return AT86RF215_OK;
+}
+
+/**
+ * Preloads the cached AGC gain of a channel. The AGC is held, the gain word
+ * written and the AGC released again, so it tracks from the cached value
+ * instead of settling from scratch.
+ * @param h the device handle
+ * @param radio the RF frontend
+ * @param key the channel key
+ * @return 0 on success, -AT86RF215_NO_DATA if the channel is not cached or
+ * other appropriate negative error code
+ */
+int at86rf215_agc_cache_apply(struct at86rf215 *h, at86rf215_radio_t radio,
+                              uint32_t key)
+{
+    size_t i;
+    int ret = radio_ready(h, radio);
+    if (ret)
+    {
+        return ret;
+    }
+    struct at86rf215_agc_cache *c = &h->priv.agc_cache[radio];
+    const struct at86rf215_agc_cache_entry *e = NULL;
+    for (i = 0; i < AT86RF215_AGC_CACHE_SIZE; i++)
+    {
+        if (c->e[i].valid && c->e[i].key == key)
+        {
+            e = &c->e[i];
+            break;
+        }
+    }
+    if (!e)
+    {
+        c->misses++;
+        return -AT86RF215_NO_DATA;
+    }
+    c->hits++;
+
+    uint8_t agcc = 0;
+    ret = at86rf215_reg_read_8(h, &agcc,
+                               radio == AT86RF215_RF09 ? REG_RF09_AGCC : REG_RF24_AGCC);
+    if (ret)
+    {
+        return ret;
+    }
+    /* Freeze and disable, load GCW, then release with the initial state */
+    ret = at86rf215_set_agc_control(h, radio, 1, 0);
+    if (ret)
+    {
+        return ret;
+    }
+    ret = at86rf215_set_agc_gain(h, radio, e->gcw);
+    if (ret)
+    {
+        return ret;
+    }
+    return at86rf215_set_agc_control(h, radio, 0, agcc & 0x1);
+}
+
+/**
+ * Retunes the RF frontend like at86rf215_set_freq(), going through the AGC
+ * gain cache: the gain of the channel being left is stored and the gain of
+ * the new channel is preloaded, if known.
+ * @param h the device handle
+ * @param radio the RF frontend
+ * @param freq the center frequency in Hz, also used as the cache key
+ * @return 0 on success or an appropriate negative error code
+ */
+int at86rf215_set_freq_cached(struct at86rf215 *h, at86rf215_radio_t radio,
+                              uint32_t freq)
+{
+    int ret = radio_ready(h, radio);
+    if (ret)
+    {
+        return ret;
+    }
+    struct at86rf215_agc_cache *c = &h->priv.agc_cache[radio];
+    struct at86rf215_retune t;
+    ret = at86rf215_retune_freq(h, radio, freq, &t);
+    if (ret)
+    {
+        return ret;
+    }
+    if (c->cur_valid)
+    {
+        ret = at86rf215_agc_cache_store(h, radio, c->cur_key);
+        if (ret)
+        {
+            return ret;
+        }
+    }
+    c->cur_valid = 0;
+    ret = at86rf215_retune(h, radio, &t);
+    if (ret)
+    {
+        return ret;
+    }
+    c->cur_key = freq;
+    c->cur_valid = 1;
+    ret = at86rf215_agc_cache_apply(h, radio, freq);
+    if (ret == -AT86RF215_NO_DATA)
+    {
+        /* First visit, the AGC settles normally */
+        return AT86RF215_OK;
+    }
+    return ret;
+}
+
 int at86rf215_set_aux_settings(struct at86rf215 *h, at86rf215_radio_t radio,
                                const struct at86rf215_aux_conf *cnf)
 {
@@ -2004,6 +2454,63 @@ static void handle_rf_irq(struct at86rf215 *h, at86rf215_radio_t radio,
     {
         r->trxready = 1;
     }
+    if (rfn_irqs & BIT(AT86RF215_RF_IRQ_EDC))
+    {
+        r->edc_time = h->priv.irq_time;
+        r->edc_done = 1;
+    }
+}
+
+static void irq_stats_update(struct at86rf215 *h)
+{
+#if AT86RF215_IRQ_STATS
+    struct at86rf215_irq_stats *s = &h->priv.irq_stats;
+    if (!h->priv.irq_stamped)
+    {
+        return;
+    }
+    h->priv.irq_stamped = 0;
+    uint32_t us = cycles_to_us(cycle_counter_get() - h->priv.irq_stamp);
+    uint32_t bin = 0;
+    if (us)
+    {
+        bin = 32 - __builtin_clz(us);
+    }
+    if (bin >= AT86RF215_IRQ_HIST_BINS)
+    {
+        bin = AT86RF215_IRQ_HIST_BINS - 1;
+    }
+    s->hist[bin]++;
+    s->count++;
+    if (us > s->max_us)
+    {
+        s->max_us = us;
+    }
+#else
+    (void) h;
+#endif
+}
+
+static void irq_dispatch(struct at86rf215 *h, const uint8_t *irqs)
+{
+    size_t src;
+    for (src = 0; src < AT86RF215_IRQ_SRC_NUM; src++)
+    {
+        /* RF09 and BBC0 belong to the sub-1 GHz radio */
+        const at86rf215_radio_t radio = (src & 0x1) ?
+                AT86RF215_RF24 : AT86RF215_RF09;
+        uint8_t pending = irqs[src];
+        while (pending)
+        {
+            const uint8_t bit = __builtin_ctz(pending);
+            const struct at86rf215_irq_entry *e = &h->priv.irq_tbl[src][bit];
+            pending &= pending - 1;
+            if (e->fn)
+            {
+                e->fn(h, radio, e->arg);
+            }
+        }
+    }
 }
 
 /**
@@ -2028,40 +2535,162 @@ int at86rf215_irq_callback(struct at86rf215 *h)
      * the manual says that it should
      */
     uint8_t irqs[4] = { 0x0, 0x0, 0x0, 0x0 };
+#if AT86RF215_IRQ_BURST
+    /* The IRQS registers are contiguous, fetch all of them at once */
+    ret = at86rf215_reg_read_burst(h, irqs, REG_RF09_IRQS,
+                                   AT86RF215_IRQ_SRC_NUM);
+    if (ret)
+    {
+        return ret;
+    }
+#else
     at86rf215_reg_read_8(h, &irqs[0], REG_RF09_IRQS);
     at86rf215_reg_read_8(h, &irqs[1], REG_RF24_IRQS);
     at86rf215_reg_read_8(h, &irqs[2], REG_BBC0_IRQS);
     at86rf215_reg_read_8(h, &irqs[3], REG_BBC1_IRQS);
+#endif
+
+    h->priv.irq_time =
+            h->priv.irq_stamped ? h->priv.irq_stamp : cycle_counter_get();
+    /*
+     * The capture dates the edge of the IRQ line, i.e. the first event that
+     * raised it. Only trusted if that is the single event pending.
+     */
+    const uint32_t events = irqs[0] | (irqs[1] << 8) | (irqs[2] << 16)
+            | ((uint32_t) irqs[3] << 24);
+    if (__builtin_popcount(events) != 1)
+    {
+        h->priv.irq_captured = 0;
+    }
+    irq_stats_update(h);
+    trace_put(TRACE_IRQ_RF, irqs[0], irqs[1]);
+    trace_put(TRACE_IRQ_BB, irqs[2], irqs[3]);
 
     handle_rf_irq(h, AT86RF215_RF09, irqs[0]);
     handle_rf_irq(h, AT86RF215_RF24, irqs[1]);
     handle_bb_irq(h, AT86RF215_RF09, irqs[2]);
     handle_bb_irq(h, AT86RF215_RF24, irqs[3]);
 
+    irq_dispatch(h, irqs);
+    h->priv.irq_captured = 0;
+
     return at86rf215_irq_user_callback(h, irqs[0], irqs[1], irqs[2], irqs[3]);
 }
 
 /**
- * @brief Clears all pending IRQs
+ * Registers a handler for a single IRQ bit. The handler is called from
+ * at86rf215_irq_callback() after the driver internal handling, in the
+ * RF09, RF24, BBC0, BBC1 and LSB first order.
+ * @note the bit should also be enabled with at86rf215_set_radio_irq_mask()
+ * or at86rf215_set_bbc_irq_mask()
  *
  * @param h the device handle
+ * @param src the IRQ status register
+ * @param bit the bit of the status register.
+ * @see at86rf215_rf_irq_t, at86rf215_bb_irq_t
+ * @param fn the handler. Set to NULL to unregister
+ * @param arg user argument passed to the handler
  * @return 0 on success or negative error code
  */
-int at86rf215_irq_clear(struct at86rf215 *h)
+int at86rf215_irq_register(struct at86rf215 *h, at86rf215_irq_src_t src,
+                           uint8_t bit, at86rf215_irq_handler_t fn, void *arg)
 {
-    int ret = ready(h);
-    if (ret)
+    if (!h || src >= AT86RF215_IRQ_SRC_NUM || bit > 7)
     {
-        return ret;
+        return -AT86RF215_INVAL_PARAM;
     }
+    struct at86rf215_irq_entry *e = &h->priv.irq_tbl[src][bit];
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    e->fn = fn;
+    e->arg = arg;
+    __set_PRIMASK(primask);
+    return AT86RF215_OK;
+}
 
-    /*
-     * Read and acknowledge all IRQ sources
-     * NOTE: Block mode did not acknowledged the triggered IRQs, even if
-     * the manual says that it should
-     */
-    uint8_t irqs;
-    at86rf215_reg_read_8(h, &irqs, REG_RF09_IRQS);
+/**
+ * Records the time the IRQ pin was asserted. Should be called first thing
+ * from the GPIO ISR, before at86rf215_irq_callback()
+ * @param h the device handle
+ * @param cycles the cycle counter value at the ISR entry
+ */
+void at86rf215_irq_stamp(struct at86rf215 *h, uint32_t cycles)
+{
+    h->priv.irq_stamp = cycles;
+    h->priv.irq_stamped = 1;
+}
+
+/**
+ * Records the timer capture of the IRQ pin edge, for boards that route the
+ * IRQ line to a timer capture input. Should be called from the capture ISR,
+ * before at86rf215_irq_callback(). RX frames get it as their RXFS time.
+ * @param h the device handle
+ * @param ticks the captured timer value
+ */
+void at86rf215_irq_capture(struct at86rf215 *h, uint32_t ticks)
+{
+    h->priv.irq_capture = ticks;
+    h->priv.irq_captured = 1;
+}
+
+/**
+ * Returns a snapshot of the IRQ latency statistics
+ * @param h the device handle
+ * @param stats pointer to hold the statistics
+ * @return 0 on success or negative error code
+ */
+int at86rf215_irq_get_stats(struct at86rf215 *h, struct at86rf215_irq_stats *stats)
+{
+    if (!h || !stats)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memcpy(stats, &h->priv.irq_stats, sizeof(*stats));
+    __set_PRIMASK(primask);
+    return AT86RF215_OK;
+}
+
+/**
+ * Clears the IRQ latency statistics
+ * @param h the device handle
+ * @return 0 on success or negative error code
+ */
+int at86rf215_irq_reset_stats(struct at86rf215 *h)
+{
+    if (!h)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(&h->priv.irq_stats, 0, sizeof(h->priv.irq_stats));
+    __set_PRIMASK(primask);
+    return AT86RF215_OK;
+}
+
+/**
+ * @brief Clears all pending IRQs
+ *
+ * @param h the device handle
+ * @return 0 on success or negative error code
+ */
+int at86rf215_irq_clear(struct at86rf215 *h)
+{
+    int ret = ready(h);
+    if (ret)
+    {
+        return ret;
+    }
+
+    /*
+     * Read and acknowledge all IRQ sources
+     * NOTE: Block mode did not acknowledged the triggered IRQs, even if
+     * the manual says that it should
+     */
+    uint8_t irqs;
+    at86rf215_reg_read_8(h, &irqs, REG_RF09_IRQS);
     at86rf215_reg_read_8(h, &irqs, REG_RF24_IRQS);
     at86rf215_reg_read_8(h, &irqs, REG_BBC0_IRQS);
     at86rf215_reg_read_8(h, &irqs, REG_BBC1_IRQS);
@@ -2244,7 +2873,8 @@ static int bb_conf_mrfsk(struct at86rf215 *h, at86rf215_radio_t radio,
         break;
     case AT86RF215_4FSK:
         /* Check for 4FSK restrictions (h >= 1, BT = 2) */
-        if (conf->fsk.bt != 2 || conf->fsk.midx < AT86RF215_MIDX_3)
+        if (conf->fsk.bt != AT86RF215_FSK_BT_20
+                || conf->fsk.midx < AT86RF215_MIDX_3)
         {
             return -AT86RF215_INVAL_CONF;
         }
@@ -2253,6 +2883,7 @@ static int bb_conf_mrfsk(struct at86rf215 *h, at86rf215_radio_t radio,
         {
             return -AT86RF215_INVAL_CONF;
         }
+        break;
     default:
         return -AT86RF215_INVAL_PARAM;
     }
@@ -2698,200 +3329,1049 @@ int at86rf215_rx_frame(struct at86rf215 *h, at86rf215_radio_t radio,
     {
         return ret;
     }
-    if (!psdu)
+    if (!psdu)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+
+    ret = at86rf215_set_seln(h, 0);
+    if (ret)
+    {
+        return ret;
+    }
+    at86rf215_irq_enable(h, 0);
+    /* Construct properly the MOSI buffer */
+    const uint16_t reg =
+            radio == AT86RF215_RF09 ? REG_BBC0_FBRXS : REG_BBC1_FBRXS;
+    uint8_t mosi[2] = { (reg >> 8) & 0x3F, reg & 0xFF };
+    /* Both phases share the SELN window, the data land directly in psdu */
+    ret = at86rf215_spi_read(h, NULL, mosi, 2, 0);
+    if (ret == 0 && len)
+    {
+        ret = at86rf215_spi_read(h, psdu, NULL, 0, len);
+    }
+    at86rf215_irq_enable(h, 1);
+    at86rf215_set_seln(h, 1);
+    return ret;
+}
+
+static int tx_supported(struct at86rf215 *h, at86rf215_radio_t radio,
+                        const uint8_t *psdu)
+{
+    int ret = supports_rf(h, radio);
+    if (ret)
+    {
+        return ret;
+    }
+    if (!psdu)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+
+    /*
+     * In order to transmit the frame, the corresponding baseband core should
+     * be enabled
+     */
+    if (h->priv.chpm == AT86RF215_RF_MODE_RF)
+    {
+        return -AT86RF215_INVAL_CHPM;
+    }
+    if (radio == AT86RF215_RF09)
+    {
+        if (h->priv.chpm == AT86RF215_RF_MODE_BBRF09)
+        {
+            return -AT86RF215_INVAL_CHPM;
+        }
+    }
+    else
+    {
+        if (h->priv.chpm == AT86RF215_RF_MODE_BBRF24)
+        {
+            return -AT86RF215_INVAL_CHPM;
+        }
+    }
+    return AT86RF215_OK;
+}
+
+/**
+ * Transmits a frame using the configured baseband core mode
+ * @note the chip mode should ensure that the corresponding baseband core
+ * is enabled
+ * @param h the device handle
+ * @param radio the RF fronted
+ * @param psdu the data to send
+ * @param len the number of bytes to send
+ * @return 0 on success or negative error code
+ */
+int at86rf215_tx_frame(struct at86rf215 *h, at86rf215_radio_t radio,
+                       const uint8_t *psdu, size_t len, size_t timeout_ms)
+{
+    size_t deadline = at86rf215_get_time_ms(h) + timeout_ms;
+    int ret = tx_supported(h, radio, psdu);
+    if (ret)
+    {
+        return ret;
+    }
+
+    /*
+     * Write at least once the TXPREP so we are sure that we can start the
+     * transmission
+     */
+    at86rf215_rf_state_t state = AT86RF215_STATE_RF_TRANSITION;
+    while (state != AT86RF215_STATE_RF_TXPREP)
+    {
+        if (at86rf215_get_time_ms(h) > deadline)
+        {
+            return -AT86RF215_TIMEOUT;
+        }
+        at86rf215_set_cmd(h, AT86RF215_CMD_RF_TXPREP, radio);
+        at86rf215_delay_us(h, 100);
+        at86rf215_get_state(h, &state, radio);
+    }
+
+    ret = write_tx_buffer(h, radio, psdu, len);
+    if (ret)
+    {
+        return ret;
+    }
+
+    struct at86rf215_radio *r = &h->priv.radios[radio];
+    r->tx_complete = 0;
+
+    /* Data are on the buffer. Issue the TX cmd to send them */
+    ret = at86rf215_set_cmd(h, AT86RF215_CMD_RF_TX, radio);
+    if (ret)
+    {
+        return ret;
+    }
+    /* Wait for the transfer to complete */
+    while (r->tx_complete == 0)
+    {
+        if (at86rf215_get_time_ms(h) > deadline)
+        {
+            return -AT86RF215_TIMEOUT;
+        }
+        at86rf215_delay_us(h, 100);
+    }
+    return AT86RF215_OK;
+}
+
+/**
+ * Uploads a frame to the TX frame buffer without changing the radio state,
+ * so the transmission can later start with a single TX command, e.g. from a
+ * timer ISR.
+ * @note the chip mode should ensure that the corresponding baseband core
+ * is enabled
+ * @param h the device handle
+ * @param radio the RF fronted
+ * @param psdu the data to send
+ * @param len the number of bytes to send
+ * @return 0 on success or negative error code
+ */
+int at86rf215_tx_preload(struct at86rf215 *h, at86rf215_radio_t radio,
+                         const uint8_t *psdu, size_t len)
+{
+    int ret = tx_supported(h, radio, psdu);
+    if (ret)
+    {
+        return ret;
+    }
+    ret = write_tx_buffer(h, radio, psdu, len);
+    if (ret)
+    {
+        return ret;
+    }
+    h->priv.radios[radio].tx_complete = 0;
+    return AT86RF215_OK;
+}
+
+/**
+ * Transmits a frame held in a frame pool block. The ownership of the block
+ * passes to the driver, it is released when the function returns,
+ * regardless of the outcome.
+ * @param h the device handle
+ * @param radio the RF fronted
+ * @param buf the frame, buf->len bytes are sent
+ * @param timeout_ms timeout in milisceconds
+ * @return 0 on success or negative error code
+ */
+int at86rf215_tx_buf(struct at86rf215 *h, at86rf215_radio_t radio,
+                     struct frame_buf *buf, size_t timeout_ms)
+{
+    if (!buf)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    int ret = at86rf215_tx_frame(h, radio, buf->data, buf->len, timeout_ms);
+    frame_buf_free(buf);
+    return ret;
+}
+
+/* True once the timebase passed deadline */
+static bool lbt_expired(uint32_t deadline)
+{
+    return timebase_diff(timebase_now(), deadline) > 0;
+}
+
+/*
+ * The timed part of at86rf215_lbt_tx(), with the CCA already configured.
+ * Polls without sleeping, the whole sequence lasts a few hundreds of us.
+ * deadline is a timebase tick.
+ */
+static int lbt_run(struct at86rf215 *h, at86rf215_radio_t radio,
+                   uint32_t deadline, struct at86rf215_lbt *lbt)
+{
+    struct at86rf215_radio *r = &h->priv.radios[radio];
+    const uint16_t off = radio == AT86RF215_RF09 ? 0 : 0x100;
+    at86rf215_rf_state_t state = AT86RF215_STATE_RF_TRANSITION;
+    int ret = at86rf215_get_state(h, &state, radio);
+    if (ret)
+    {
+        return ret;
+    }
+    while (state != AT86RF215_STATE_RF_RX)
+    {
+        if (lbt_expired(deadline))
+        {
+            return -AT86RF215_TIMEOUT;
+        }
+        /* A TXPREP in progress would be turned into a TX */
+        if (state != AT86RF215_STATE_RF_TRANSITION)
+        {
+            at86rf215_set_cmd(h, AT86RF215_CMD_RF_RX, radio);
+        }
+        at86rf215_get_state(h, &state, radio);
+    }
+
+    r->edc_done = 0;
+    r->tx_complete = 0;
+    const uint32_t t0 = cycle_counter_get();
+    /* In RX with CCATX set, this starts the measurement, not the frame */
+    ret = at86rf215_set_cmd(h, AT86RF215_CMD_RF_TX, radio);
+    if (ret)
+    {
+        return ret;
+    }
+    while (!r->edc_done)
+    {
+        if (lbt_expired(deadline))
+        {
+            return -AT86RF215_TIMEOUT;
+        }
+    }
+    const uint32_t t_edc = r->edc_time;
+    lbt->cca_us = cycles_to_us(t_edc - t0);
+
+    uint8_t amcs = 0;
+    uint8_t edv = 0;
+    ret = at86rf215_reg_read_8(h, &amcs, REG_BBC0_AMCS + off);
+    if (ret)
+    {
+        return ret;
+    }
+    ret = at86rf215_reg_read_8(h, &edv, REG_RF09_EDV + off);
+    if (ret)
+    {
+        return ret;
+    }
+    lbt->edv = (int8_t) edv;
+    if (amcs & AMCS_CCAED)
+    {
+        /* The transceiver stayed in RX */
+        lbt->busy = 1;
+        return -AT86RF215_CHANNEL_BUSY;
+    }
+
+    /* A short frame may be over before TX is ever observed */
+    while (state != AT86RF215_STATE_RF_TX && !r->tx_complete)
+    {
+        if (lbt_expired(deadline))
+        {
+            return -AT86RF215_TIMEOUT;
+        }
+        at86rf215_get_state(h, &state, radio);
+    }
+    lbt->turnaround_us = cycles_to_us(cycle_counter_get() - t_edc);
+
+    while (!r->tx_complete)
+    {
+        if (lbt_expired(deadline))
+        {
+            return -AT86RF215_TIMEOUT;
+        }
+    }
+    lbt->total_us = cycles_to_us(cycle_counter_get() - t0);
+    return AT86RF215_OK;
+}
+
+/**
+ * Transmits a frame if the channel is found clear. The frame is uploaded
+ * first, then the TX command is issued in RX with BBCn_AMCS.CCATX set: the
+ * chip performs the energy measurement and, only if it stays below the
+ * threshold, moves on to TXPREP and TX by itself. The CCA outcome is taken
+ * from the EDC IRQ.
+ * @note the radio is put in RX if needed, and left in RX when the channel
+ * is busy. The EDC IRQ should not be used by a running scan.
+ * @param h the device handle
+ * @param radio the RF fronted
+ * @param psdu the data to send
+ * @param len the number of bytes to send
+ * @param thr the busy threshold in dBm
+ * @param edd the measurement duration. @see AT86RF215_EDD
+ * @param timeout_ms timeout in milisceconds, counted on the timebase, so
+ * timebase_init() should have been called
+ * @param res if not NULL, filled with the CCA outcome and its timings
+ * @return 0 on success, -AT86RF215_CHANNEL_BUSY if the frame was held back
+ * by the CCA or another negative error code
+ */
+int at86rf215_lbt_tx(struct at86rf215 *h, at86rf215_radio_t radio,
+                     const uint8_t *psdu, size_t len, int8_t thr, uint8_t edd,
+                     size_t timeout_ms, struct at86rf215_lbt *res)
+{
+    struct at86rf215_lbt lbt = { 0 };
+    const uint32_t deadline = timebase_now()
+            + timebase_us_to_ticks(timeout_ms * 1000);
+    int ret = at86rf215_tx_preload(h, radio, psdu, len);
+    if (ret)
+    {
+        return ret;
+    }
+    const uint16_t off = radio == AT86RF215_RF09 ? 0 : 0x100;
+
+    /* EDC and EDD are contiguous */
+    uint8_t ed_saved[2];
+    uint8_t irqm_saved = 0;
+    uint8_t amcs_saved = 0;
+    ret = at86rf215_reg_read_burst(h, ed_saved, REG_RF09_EDC + off, 2);
+    if (!ret)
+    {
+        ret = at86rf215_reg_read_8(h, &irqm_saved, REG_RF09_IRQM + off);
+    }
+    if (!ret)
+    {
+        ret = at86rf215_reg_read_8(h, &amcs_saved, REG_BBC0_AMCS + off);
+    }
+    if (ret)
+    {
+        return ret;
+    }
+
+    /* The measurement is triggered by the TX command, not by EDC */
+    uint8_t ed[2] = { AT86RF215_EDM_AUTO, edd };
+    ret = at86rf215_reg_write_burst(h, ed, REG_RF09_EDC + off, 2);
+    if (!ret)
+    {
+        ret = at86rf215_reg_write_8(h, (uint8_t) thr, REG_BBC0_AMEDT + off);
+    }
+    if (!ret)
+    {
+        ret = at86rf215_reg_write_8(h, irqm_saved | BIT(AT86RF215_RF_IRQ_EDC),
+                                    REG_RF09_IRQM + off);
+    }
+    if (!ret)
+    {
+        ret = at86rf215_reg_write_8(h, amcs_saved | AMCS_CCATX,
+                                    REG_BBC0_AMCS + off);
+    }
+    if (!ret)
+    {
+        ret = lbt_run(h, radio, deadline, &lbt);
+    }
+
+    /* EDD first, a saved continuous mode restarts on the EDC write */
+    at86rf215_reg_write_8(h, amcs_saved, REG_BBC0_AMCS + off);
+    at86rf215_reg_write_8(h, irqm_saved, REG_RF09_IRQM + off);
+    at86rf215_reg_write_8(h, ed_saved[1], REG_RF09_EDD + off);
+    at86rf215_reg_write_8(h, ed_saved[0], REG_RF09_EDC + off);
+    if (res)
+    {
+        *res = lbt;
+    }
+    return ret;
+}
+
+/**
+ * @brief Sets the transceiver in RX mode
+ *
+ * @param h the device handle
+ * @param radio the RF fronted
+ * @param timeout_ms timeout in milisceconds
+ * @return 0 on success or negative error code
+ */
+int at86rf215_rx(struct at86rf215 *h, at86rf215_radio_t radio,
+                 size_t timeout_ms)
+{
+    size_t deadline = at86rf215_get_time_ms(h) + timeout_ms;
+    int ret = supports_rf(h, radio);
+    if (ret)
+    {
+        return ret;
+    }
+
+    /*
+     * In order to transmit the frame, the corresponding baseband core should
+     * be enabled
+     */
+    if (h->priv.chpm == AT86RF215_RF_MODE_RF)
+    {
+        return -AT86RF215_INVAL_CHPM;
+    }
+    if (radio == AT86RF215_RF09)
+    {
+        if (h->priv.chpm == AT86RF215_RF_MODE_BBRF09)
+        {
+            return -AT86RF215_INVAL_CHPM;
+        }
+    }
+    else
+    {
+        if (h->priv.chpm == AT86RF215_RF_MODE_BBRF24)
+        {
+            return -AT86RF215_INVAL_CHPM;
+        }
+    }
+
+    at86rf215_rf_state_t state;
+    ret = at86rf215_get_state(h, &state, radio);
+    if (ret)
+    {
+        return ret;
+    }
+
+    while (state != AT86RF215_STATE_RF_TRXOFF
+            && state != AT86RF215_STATE_RF_TXPREP)
+    {
+        at86rf215_delay_us(h, 100);
+        if (at86rf215_get_time_ms(h) > deadline)
+        {
+            return -AT86RF215_TIMEOUT;
+        }
+
+        /*
+         * If the radio was in the TRXOFF state request again the TXPREP state
+         */
+        if (state == AT86RF215_STATE_RF_TRXOFF)
+        {
+            at86rf215_set_cmd(h, AT86RF215_CMD_RF_TXPREP, radio);
+            at86rf215_delay_us(h, 100);
+        }
+        at86rf215_get_state(h, &state, radio);
+    }
+
+    at86rf215_delay_us(h, 100);
+
+    /* Go to RX state*/
+    while (state != AT86RF215_STATE_RF_RX)
+    {
+        if (at86rf215_get_time_ms(h) > deadline)
+        {
+            return -AT86RF215_TIMEOUT;
+        }
+        at86rf215_set_cmd(h, AT86RF215_CMD_RF_RX, radio);
+        at86rf215_delay_us(h, 100);
+        at86rf215_get_state(h, &state, radio);
+    }
+    return AT86RF215_OK;
+}
+
+static void rx_pipe_init(struct at86rf215_rx_pipe *p)
+{
+    memset(p, 0, sizeof(struct at86rf215_rx_pipe));
+    p->free_mask = (AT86RF215_RX_QUEUE_LEN == 32) ?
+            0xFFFFFFFF : ((1UL << AT86RF215_RX_QUEUE_LEN) - 1);
+    p->active[AT86RF215_RF09] = RX_NONE;
+    p->active[AT86RF215_RF24] = RX_NONE;
+    p->ready = 1;
+}
+
+static uint8_t rx_desc_alloc(struct at86rf215_rx_pipe *p)
+{
+    uint8_t idx = RX_NONE;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (p->free_mask)
+    {
+        idx = __builtin_ctz(p->free_mask);
+        p->free_mask &= ~(1UL << idx);
+    }
+    __set_PRIMASK(primask);
+    return idx;
+}
+
+/*
+ * Queues the next chunk of the frame buffer upload. Between chunks the
+ * SPI engine serves the higher priority jobs, the IRQ status reads first.
+ */
+static bool rx_upload_next(struct at86rf215 *h, at86rf215_radio_t radio)
+{
+    const struct at86rf215_rx_pkt *pkt =
+            &h->priv.rx.pkts[h->priv.rx.active[radio]];
+    const uint16_t fb = (radio == AT86RF215_RF09 ? REG_BBC0_FBRXS : REG_BBC1_FBRXS)
+            + rx_upload_pos[radio];
+    uint16_t n = pkt->len - rx_upload_pos[radio];
+    if (n > AT86RF215_RX_UPLOAD_CHUNK)
+    {
+        n = AT86RF215_RX_UPLOAD_CHUNK;
+    }
+    SpiJob_t *job = &rx_upload_job[radio];
+    job->hdr[0] = (fb >> 8) & 0x3F;
+    job->hdr[1] = fb & 0xFF;
+    job->rx = pkt->psdu + rx_upload_pos[radio];
+    job->len = n;
+    rx_upload_pos[radio] += n;
+    return SpiJobSubmit(job);
+}
+
+/* Runs from the SPI engine ISR, after each chunk of the upload */
+static void rx_upload_done(SpiJob_t *job)
+{
+    struct at86rf215 *h = (struct at86rf215 *) job->arg;
+    struct at86rf215_rx_pipe *p = &h->priv.rx;
+    const at86rf215_radio_t radio =
+            job == &rx_upload_job[AT86RF215_RF09] ?
+                    AT86RF215_RF09 : AT86RF215_RF24;
+
+    if (rx_upload_pos[radio] < p->pkts[p->active[radio]].len)
+    {
+        if (!rx_upload_next(h, radio))
+        {
+            at86rf215_rx_release(h, &p->pkts[p->active[radio]]);
+            p->active[radio] = RX_NONE;
+            p->stats.spi_err++;
+        }
+        return;
+    }
+
+    /* The frame is complete in memory */
+    p->ring[p->head & (AT86RF215_RX_QUEUE_LEN - 1)] = p->active[radio];
+    p->active[radio] = RX_NONE;
+    /* Publish the slot before the index */
+    __DMB();
+    p->head++;
+    p->stats.frames++;
+}
+
+/* RXFS handler, latches the timer capture of its IRQ edge for the frame */
+static void rx_frame_start(struct at86rf215 *h, at86rf215_radio_t radio,
+                           void *arg)
+{
+    struct at86rf215_radio *r = &h->priv.radios[radio];
+    (void) arg;
+    r->rxfs_capture = h->priv.irq_capture;
+    r->rxfs_valid = h->priv.irq_captured;
+}
+
+/*
+ * RXFE handler. Fetches the frame length and the metadata, re-arms the
+ * receiver and queues the frame buffer upload. The upload runs at SPI speed,
+ * well ahead of the next frame that will overwrite the RX frame buffer.
+ */
+static void rx_frame_end(struct at86rf215 *h, at86rf215_radio_t radio,
+                         void *arg)
+{
+    struct at86rf215_rx_pipe *p = &h->priv.rx;
+    /* BBC1 and RF24 registers are at a 0x100 offset from BBC0 and RF09 */
+    const uint16_t off = radio == AT86RF215_RF09 ? 0 : 0x100;
+    uint8_t fl[2];
+    uint8_t pc;
+    uint8_t ed[4];
+    (void) arg;
+
+    if (at86rf215_reg_read_burst(h, fl, REG_BBC0_RXFLL + off, 2)
+            || at86rf215_reg_read_8(h, &pc, REG_BBC0_PC + off)
+            || at86rf215_reg_read_burst(h, ed, REG_RF09_RSSI + off, 4))
+    {
+        p->stats.spi_err++;
+        at86rf215_set_cmd(h, AT86RF215_CMD_RF_RX, radio);
+        return;
+    }
+
+    const uint16_t len = ((fl[1] & 0x07) << 8) | fl[0];
+    if (p->active[radio] != RX_NONE)
+    {
+        /* The frame buffer is already overwritten, keep the current upload */
+        p->stats.overrun++;
+        at86rf215_set_cmd(h, AT86RF215_CMD_RF_RX, radio);
+        return;
+    }
+    const uint8_t idx = len ? rx_desc_alloc(p) : RX_NONE;
+    struct frame_buf *buf = idx != RX_NONE ? frame_buf_alloc(len) : NULL;
+    if (!buf)
+    {
+        if (idx != RX_NONE)
+        {
+            at86rf215_rx_release(h, &p->pkts[idx]);
+        }
+        p->stats.no_buf++;
+        at86rf215_set_cmd(h, AT86RF215_CMD_RF_RX, radio);
+        return;
+    }
+
+    struct at86rf215_rx_pkt *pkt = &p->pkts[idx];
+    buf->len = len;
+    pkt->buf = buf;
+    pkt->psdu = buf->data;
+    pkt->radio = radio;
+    pkt->len = len;
+    pkt->rssi = (int8_t) ed[0];
+    pkt->edv = (int8_t) ed[3];
+    pkt->fcs_ok = (pc >> 5) & 0x1;
+    pkt->timestamp = h->priv.irq_time;
+    pkt->rx_start = h->priv.radios[radio].rxfs_capture;
+    pkt->rx_start_valid = h->priv.radios[radio].rxfs_valid;
+    h->priv.radios[radio].rxfs_valid = 0;
+    p->active[radio] = idx;
+
+    /*
+     * Re-arm first. Any blocking register access issued after the submission
+     * would have to wait for the whole upload.
+     */
+    at86rf215_set_cmd(h, AT86RF215_CMD_RF_RX, radio);
+
+    const uint16_t fb = radio == AT86RF215_RF09 ? REG_BBC0_FBRXS : REG_BBC1_FBRXS;
+    SpiJob_t *job = &rx_upload_job[radio];
+    job->client = SPI_CLIENT_IQRADIO;
+    job->prio = SPI_PRIO_BULK;
+    job->cs_port = GPIO_PORT_P3; /* same SELN as at86rf215_set_seln() */
+    job->cs_pin = GPIO_PIN0;
+    job->hdr_len = 2;
+    job->tx = NULL;
+    job->done = rx_upload_done;
+    job->arg = h;
+    rx_upload_pos[radio] = 0;
+    /* Stamped when queued, the transfer itself completes later */
+    trace_put(TRACE_BURST_READ, TRACE_LEN8(len), fb);
+    if (!rx_upload_next(h, radio))
+    {
+        p->active[radio] = RX_NONE;
+        at86rf215_rx_release(h, pkt);
+        p->stats.spi_err++;
+    }
+}
+
+/**
+ * Arms the interrupt driven RX pipeline of a radio, without changing the
+ * radio state. Frames are delivered once the radio enters RX.
+ * @note at86rf215_irq_callback() should be called from the IRQ pin ISR
+ *
+ * @param h the device handle
+ * @param radio the RF fronted
+ * @return 0 on success or negative error code
+ */
+int at86rf215_rx_arm(struct at86rf215 *h, at86rf215_radio_t radio)
+{
+    int ret = supports_rf(h, radio);
+    if (ret)
+    {
+        return ret;
+    }
+    struct at86rf215_rx_pipe *p = &h->priv.rx;
+    if (!p->ready)
+    {
+        rx_pipe_init(p);
+    }
+
+    const at86rf215_irq_src_t src =
+            radio == AT86RF215_RF09 ? AT86RF215_IRQ_SRC_BBC0 : AT86RF215_IRQ_SRC_BBC1;
+    ret = at86rf215_irq_register(h, src, AT86RF215_BB_IRQ_RXFE, rx_frame_end,
+                                 NULL);
+    if (ret)
+    {
+        return ret;
+    }
+    /* RXFS only dates the frame, through the capture of its IRQ edge */
+    ret = at86rf215_irq_register(h, src, AT86RF215_BB_IRQ_RXFS, rx_frame_start,
+                                 NULL);
+    if (ret)
+    {
+        return ret;
+    }
+
+    const uint16_t reg = radio == AT86RF215_RF09 ? REG_BBC0_IRQM : REG_BBC1_IRQM;
+    uint8_t mask = 0;
+    ret = at86rf215_reg_read_8(h, &mask, reg);
+    if (ret)
+    {
+        return ret;
+    }
+    return at86rf215_reg_write_8(h,
+                                 mask | BIT(AT86RF215_BB_IRQ_RXFE)
+                                         | BIT(AT86RF215_BB_IRQ_RXFS),
+                                 reg);
+}
+
+/**
+ * Starts the interrupt driven RX pipeline of a radio and puts it in RX.
+ * Received frames are collected with at86rf215_rx_get() and should be
+ * returned to the pool with at86rf215_rx_release().
+ * @note at86rf215_irq_callback() should be called from the IRQ pin ISR
+ *
+ * @param h the device handle
+ * @param radio the RF fronted
+ * @param timeout_ms timeout in milisceconds for the RX state transition
+ * @return 0 on success or negative error code
+ */
+int at86rf215_rx_start(struct at86rf215 *h, at86rf215_radio_t radio,
+                       size_t timeout_ms)
+{
+    int ret = at86rf215_rx_arm(h, radio);
+    if (ret)
+    {
+        return ret;
+    }
+    return at86rf215_rx(h, radio, timeout_ms);
+}
+
+/**
+ * Stops the RX pipeline of a radio. Frames already queued can still be
+ * collected. The radio state is not changed.
+ * @param h the device handle
+ * @param radio the RF fronted
+ * @return 0 on success or negative error code
+ */
+int at86rf215_rx_stop(struct at86rf215 *h, at86rf215_radio_t radio)
+{
+    int ret = supports_rf(h, radio);
+    if (ret)
+    {
+        return ret;
+    }
+    const uint16_t reg = radio == AT86RF215_RF09 ? REG_BBC0_IRQM : REG_BBC1_IRQM;
+    uint8_t mask = 0;
+    ret = at86rf215_reg_read_8(h, &mask, reg);
+    if (ret)
     {
-        return -AT86RF215_INVAL_PARAM;
+        return ret;
     }
-
-    ret = at86rf215_set_seln(h, 0);
+    ret = at86rf215_reg_write_8(h,
+                                mask & ~(BIT(AT86RF215_BB_IRQ_RXFE)
+                                        | BIT(AT86RF215_BB_IRQ_RXFS)),
+                                reg);
     if (ret)
     {
         return ret;
     }
-    at86rf215_irq_enable(h, 0);
-    /* Construct properly the MOSI buffer */
-    const uint16_t reg =
-            radio == AT86RF215_RF09 ? REG_BBC0_FBRXS : REG_BBC1_FBRXS;
-    uint8_t mosi[2] = { (reg >> 8) & 0x3F, reg & 0xFF };
-    ret = at86rf215_spi_read(h, spi_buffer, mosi, 2, len + 2);
-    at86rf215_irq_enable(h, 1);
-    at86rf215_set_seln(h, 1);
-    memcpy(psdu, spi_buffer + 2, len);
-    return ret;
+    const at86rf215_irq_src_t src =
+            radio == AT86RF215_RF09 ? AT86RF215_IRQ_SRC_BBC0 : AT86RF215_IRQ_SRC_BBC1;
+    at86rf215_irq_register(h, src, AT86RF215_BB_IRQ_RXFS, NULL, NULL);
+    return at86rf215_irq_register(h, src, AT86RF215_BB_IRQ_RXFE, NULL, NULL);
 }
 
 /**
- * Transmits a frame using the configured baseband core mode
- * @note the chip mode should ensure that the corresponding baseband core
- * is enabled
+ * Retrieves the oldest received frame. Should be called by a single reader.
  * @param h the device handle
- * @param radio the RF fronted
- * @param psdu the data to send
- * @param len the number of bytes to send
+ * @param pkt pointer to hold the frame. The frame is owned by the caller
+ * until it is passed to at86rf215_rx_release()
+ * @return 0 on success, -AT86RF215_NO_DATA if no frame is pending or other
+ * negative error code
+ */
+int at86rf215_rx_get(struct at86rf215 *h, struct at86rf215_rx_pkt **pkt)
+{
+    if (!h || !pkt)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    struct at86rf215_rx_pipe *p = &h->priv.rx;
+    if (!p->ready || p->tail == p->head)
+    {
+        return -AT86RF215_NO_DATA;
+    }
+    /* Read the slot only after the index that published it */
+    __DMB();
+    *pkt = &p->pkts[p->ring[p->tail & (AT86RF215_RX_QUEUE_LEN - 1)]];
+    p->tail++;
+    return AT86RF215_OK;
+}
+
+/**
+ * Returns a frame obtained by at86rf215_rx_get() to the pipeline and drops
+ * the pipeline reference of its frame pool block
+ * @param h the device handle
+ * @param pkt the frame
  * @return 0 on success or negative error code
  */
-int at86rf215_tx_frame(struct at86rf215 *h, at86rf215_radio_t radio,
-                       const uint8_t *psdu, size_t len, size_t timeout_ms)
+int at86rf215_rx_release(struct at86rf215 *h, struct at86rf215_rx_pkt *pkt)
 {
-    size_t deadline = at86rf215_get_time_ms(h) + timeout_ms;
-    int ret = supports_rf(h, radio);
-    if (ret)
+    if (!h || !pkt)
     {
-        return ret;
+        return -AT86RF215_INVAL_PARAM;
     }
-    if (!psdu)
+    struct at86rf215_rx_pipe *p = &h->priv.rx;
+    if (pkt < p->pkts || pkt >= p->pkts + AT86RF215_RX_QUEUE_LEN)
     {
         return -AT86RF215_INVAL_PARAM;
     }
+    const uint32_t idx = pkt - p->pkts;
+    frame_buf_free(pkt->buf);
+    pkt->buf = NULL;
+    pkt->psdu = NULL;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    p->free_mask |= 1UL << idx;
+    __set_PRIMASK(primask);
+    return AT86RF215_OK;
+}
 
-    /*
-     * In order to transmit the frame, the corresponding baseband core should
-     * be enabled
-     */
-    if (h->priv.chpm == AT86RF215_RF_MODE_RF)
+/**
+ * Returns a snapshot of the RX pipeline statistics
+ * @param h the device handle
+ * @param stats pointer to hold the statistics
+ * @return 0 on success or negative error code
+ */
+int at86rf215_rx_get_stats(struct at86rf215 *h, struct at86rf215_rx_stats *stats)
+{
+    if (!h || !stats)
     {
-        return -AT86RF215_INVAL_CHPM;
+        return -AT86RF215_INVAL_PARAM;
     }
-    if (radio == AT86RF215_RF09)
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memcpy(stats, &h->priv.rx.stats, sizeof(*stats));
+    __set_PRIMASK(primask);
+    return AT86RF215_OK;
+}
+
+static void scan_finish(struct at86rf215 *h, struct at86rf215_scan *s)
+{
+    const uint16_t off = s->radio == AT86RF215_RF09 ? 0 : 0x100;
+    const at86rf215_irq_src_t src =
+            s->radio == AT86RF215_RF09 ? AT86RF215_IRQ_SRC_RF09 : AT86RF215_IRQ_SRC_RF24;
+    at86rf215_irq_register(h, src, AT86RF215_RF_IRQ_EDC, NULL, NULL);
+    at86rf215_reg_write_8(h, s->irqm_saved, REG_RF09_IRQM + off);
+    at86rf215_reg_write_8(h, s->edd_saved, REG_RF09_EDD + off);
+    at86rf215_reg_write_8(h, s->edc_saved, REG_RF09_EDC + off);
+    s->elapsed_us = cycles_to_us(cycle_counter_get() - s->t_start);
+    s->running = 0;
+}
+
+/*
+ * EDC handler of a running scan. Collects the measurement, moves to the next
+ * channel when needed and triggers the next single measurement.
+ */
+static void scan_edc(struct at86rf215 *h, at86rf215_radio_t radio, void *arg)
+{
+    struct at86rf215_scan *s = (struct at86rf215_scan *) arg;
+    const uint16_t off = radio == AT86RF215_RF09 ? 0 : 0x100;
+    uint8_t val = 127;
+
+    if (!s->running)
     {
-        if (h->priv.chpm == AT86RF215_RF_MODE_BBRF09)
-        {
-            return -AT86RF215_INVAL_CHPM;
-        }
+        return;
     }
-    else
+    at86rf215_reg_read_8(h, &val, REG_RF09_EDV + off);
+    if (val != 127)
     {
-        if (h->priv.chpm == AT86RF215_RF_MODE_BBRF24)
+        struct at86rf215_scan_chan *c = &s->chans[s->cur];
+        const int8_t edv = (int8_t) val;
+        int bin = (edv - AT86RF215_SCAN_HIST_MIN) / AT86RF215_SCAN_HIST_STEP + 1;
+        if (edv < AT86RF215_SCAN_HIST_MIN)
         {
-            return -AT86RF215_INVAL_CHPM;
+            bin = 0;
+        }
+        else if (bin >= AT86RF215_SCAN_HIST_BINS)
+        {
+            bin = AT86RF215_SCAN_HIST_BINS - 1;
+        }
+        c->hist[bin]++;
+        c->edv_sum += edv;
+        if (c->samples == 0 || edv > c->edv_max)
+        {
+            c->edv_max = edv;
+        }
+        c->samples++;
+        if (edv > s->busy_thr)
+        {
+            c->busy++;
         }
     }
 
-    /*
-     * Write at least once the TXPREP so we are sure that we can start the
-     * transmission
-     */
-    at86rf215_rf_state_t state = AT86RF215_STATE_RF_TRANSITION;
-    while (state != AT86RF215_STATE_RF_TXPREP)
+    if (++s->cur_n >= s->per_chan)
     {
-        if (at86rf215_get_time_ms(h) > deadline)
+        s->cur_n = 0;
+        if (++s->cur >= s->nchans)
         {
-            return -AT86RF215_TIMEOUT;
+            s->cur = 0;
+            if (s->sweeps && ++s->sweep_n >= s->sweeps)
+            {
+                scan_finish(h, s);
+                return;
+            }
+        }
+        if (s->nchans > 1)
+        {
+            at86rf215_retune(h, radio, &s->chans[s->cur].tune);
         }
-        at86rf215_set_cmd(h, AT86RF215_CMD_RF_TXPREP, radio);
-        at86rf215_delay_us(h, 100);
-        at86rf215_get_state(h, &state, radio);
     }
+    at86rf215_reg_write_8(h, AT86RF215_EDM_SINGLE, REG_RF09_EDC + off);
+}
 
-    ret = write_tx_buffer(h, radio, psdu, len);
+/**
+ * Starts an energy detection scan over the channel list of \p scan. Every
+ * channel visit takes scan->per_chan single measurements of scan->edd
+ * duration. The statistics of the channels are cleared.
+ *
+ * The scan is driven by the EDC IRQ: the next measurement and the burst
+ * retune are issued from the IRQ context, the CPU is free in between.
+ * The EDC, EDD and IRQ mask registers are restored when the scan ends.
+ *
+ * @note the radio should be in RX state and at86rf215_irq_callback() should
+ * be called from the IRQ pin ISR
+ * @note the automatic EDC mode measures only during frame reception, so the
+ * single measurement mode is used
+ *
+ * @param h the device handle
+ * @param scan the scan. Should stay valid until the scan ends
+ * @return 0 on success or negative error code
+ */
+int at86rf215_scan_start(struct at86rf215 *h, struct at86rf215_scan *scan)
+{
+    size_t i;
+    if (!scan || !scan->chans || !scan->nchans || !scan->per_chan)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    int ret = radio_ready(h, scan->radio);
     if (ret)
     {
         return ret;
     }
+    const uint16_t off = scan->radio == AT86RF215_RF09 ? 0 : 0x100;
+    const at86rf215_irq_src_t src =
+            scan->radio == AT86RF215_RF09 ? AT86RF215_IRQ_SRC_RF09 : AT86RF215_IRQ_SRC_RF24;
 
-    struct at86rf215_radio *r = &h->priv.radios[radio];
-    r->tx_complete = 0;
+    for (i = 0; i < scan->nchans; i++)
+    {
+        struct at86rf215_scan_chan *c = &scan->chans[i];
+        c->samples = 0;
+        c->busy = 0;
+        c->edv_sum = 0;
+        c->edv_max = -127;
+        memset(c->hist, 0, sizeof(c->hist));
+    }
+    scan->cur = 0;
+    scan->cur_n = 0;
+    scan->sweep_n = 0;
+    scan->elapsed_us = 0;
 
-    /* Data are on the buffer. Issue the TX cmd to send them */
-    ret = at86rf215_set_cmd(h, AT86RF215_CMD_RF_TX, radio);
+    /* EDC and EDD are contiguous */
+    uint8_t ed[2];
+    ret = at86rf215_reg_read_burst(h, ed, REG_RF09_EDC + off, 2);
     if (ret)
     {
         return ret;
     }
-    /* Wait for the transfer to complete */
-    while (r->tx_complete == 0)
+    scan->edc_saved = ed[0];
+    scan->edd_saved = ed[1];
+    ret = at86rf215_reg_read_8(h, &scan->irqm_saved, REG_RF09_IRQM + off);
+    if (ret)
     {
-        if (at86rf215_get_time_ms(h) > deadline)
-        {
-            return -AT86RF215_TIMEOUT;
-        }
-        at86rf215_delay_us(h, 100);
+        return ret;
     }
-    return AT86RF215_OK;
-}
 
-/**
- * @brief Sets the transceiver in RX mode
- *
- * @param h the device handle
- * @param radio the RF fronted
- * @param timeout_ms timeout in milisceconds
- * @return 0 on success or negative error code
- */
-int at86rf215_rx(struct at86rf215 *h, at86rf215_radio_t radio,
-                 size_t timeout_ms)
-{
-    size_t deadline = at86rf215_get_time_ms(h) + timeout_ms;
-    int ret = supports_rf(h, radio);
+    /* Stop any measurement in progress before touching EDD */
+    ed[0] = AT86RF215_EDM_OFF;
+    ed[1] = scan->edd;
+    ret = at86rf215_reg_write_burst(h, ed, REG_RF09_EDC + off, 2);
     if (ret)
     {
         return ret;
     }
-
-    /*
-     * In order to transmit the frame, the corresponding baseband core should
-     * be enabled
-     */
-    if (h->priv.chpm == AT86RF215_RF_MODE_RF)
+    ret = at86rf215_retune(h, scan->radio, &scan->chans[0].tune);
+    if (ret)
     {
-        return -AT86RF215_INVAL_CHPM;
+        return ret;
     }
-    if (radio == AT86RF215_RF09)
+    ret = at86rf215_irq_register(h, src, AT86RF215_RF_IRQ_EDC, scan_edc, scan);
+    if (ret)
     {
-        if (h->priv.chpm == AT86RF215_RF_MODE_BBRF09)
-        {
-            return -AT86RF215_INVAL_CHPM;
-        }
+        return ret;
     }
-    else
+    ret = at86rf215_reg_write_8(h, scan->irqm_saved | BIT(AT86RF215_RF_IRQ_EDC),
+                                REG_RF09_IRQM + off);
+    if (ret)
     {
-        if (h->priv.chpm == AT86RF215_RF_MODE_BBRF24)
-        {
-            return -AT86RF215_INVAL_CHPM;
-        }
+        at86rf215_irq_register(h, src, AT86RF215_RF_IRQ_EDC, NULL, NULL);
+        return ret;
     }
 
-    at86rf215_rf_state_t state;
-    ret = at86rf215_get_state(h, &state, radio);
+    scan->t_start = cycle_counter_get();
+    scan->running = 1;
+    ret = at86rf215_reg_write_8(h, AT86RF215_EDM_SINGLE, REG_RF09_EDC + off);
     if (ret)
     {
-        return ret;
+        scan_finish(h, scan);
     }
+    return ret;
+}
 
-    while (state != AT86RF215_STATE_RF_TRXOFF
-            && state != AT86RF215_STATE_RF_TXPREP)
+/**
+ * Stops a running scan. The collected statistics are kept.
+ * @param h the device handle
+ * @param scan the scan
+ * @return 0 on success or negative error code
+ */
+int at86rf215_scan_stop(struct at86rf215 *h, struct at86rf215_scan *scan)
+{
+    if (!h || !scan)
     {
-        at86rf215_delay_us(h, 100);
-        if (at86rf215_get_time_ms(h) > deadline)
-        {
-            return -AT86RF215_TIMEOUT;
-        }
-
-        /*
-         * If the radio was in the TRXOFF state request again the TXPREP state
-         */
-        if (state == AT86RF215_STATE_RF_TRXOFF)
-        {
-            at86rf215_set_cmd(h, AT86RF215_CMD_RF_TXPREP, radio);
-            at86rf215_delay_us(h, 100);
-        }
-        at86rf215_get_state(h, &state, radio);
+        return -AT86RF215_INVAL_PARAM;
     }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const uint8_t running = scan->running;
+    scan->running = 0;
+    __set_PRIMASK(primask);
+    if (running)
+    {
+        scan_finish(h, scan);
+    }
+    return AT86RF215_OK;
+}
 
-    at86rf215_delay_us(h, 100);
-
-    /* Go to RX state*/
-    while (state != AT86RF215_STATE_RF_RX)
+/**
+ * Selects the clearest channel of a scan: the one with the fewest busy
+ * samples, ties broken by the lowest average energy
+ * @param scan the scan
+ * @param idx pointer to hold the index of the channel in the list
+ * @return 0 on success, -AT86RF215_NO_DATA if no channel has valid samples
+ * or other negative error code
+ */
+int at86rf215_scan_best(const struct at86rf215_scan *scan, size_t *idx)
+{
+    size_t i;
+    int found = 0;
+    if (!scan || !scan->chans || !idx)
     {
-        if (at86rf215_get_time_ms(h) > deadline)
+        return -AT86RF215_INVAL_PARAM;
+    }
+    for (i = 0; i < scan->nchans; i++)
+    {
+        const struct at86rf215_scan_chan *c = &scan->chans[i];
+        if (c->samples == 0)
         {
-            return -AT86RF215_TIMEOUT;
+            continue;
         }
-        at86rf215_set_cmd(h, AT86RF215_CMD_RF_RX, radio);
-        at86rf215_delay_us(h, 100);
-        at86rf215_get_state(h, &state, radio);
+        if (found)
+        {
+            const struct at86rf215_scan_chan *b = &scan->chans[*idx];
+            /* Compare busy ratios and averages without divisions */
+            const uint32_t lhs = (uint32_t) c->busy * b->samples;
+            const uint32_t rhs = (uint32_t) b->busy * c->samples;
+            if (lhs > rhs)
+            {
+                continue;
+            }
+            if (lhs == rhs
+                    && (int64_t) c->edv_sum * b->samples
+                            >= (int64_t) b->edv_sum * c->samples)
+            {
+                continue;
+            }
+        }
+        *idx = i;
+        found = 1;
     }
-    return AT86RF215_OK;
+    return found ? AT86RF215_OK : -AT86RF215_NO_DATA;
 }
 
 /**
@@ -2979,13 +4459,49 @@ int at86rf215_iq_conf(struct at86rf215 *h, at86rf215_radio_t radio,
     return AT86RF215_OK;
 }
 
+/**
+ * Enables or disables the embedded control of the transmitter over the I/Q
+ * interface. With EEC set, the LSB of the I word keys the transmitter: a 0 to
+ * 1 transition starts TX from TXPREP and a 1 to 0 transition returns to
+ * TXPREP, so the baseband controls each frame with sample accuracy and no
+ * SPI command. The LSB of the Q word should be kept 0.
+ * @note the setting is common to both RF frontends
+ * @note the radio should be left in TXPREP for the baseband to key it
+ *
+ * @param h the device handle
+ * @param enable 1 to enable the embedded control, 0 to disable it
+ * @return 0 on success or negative error code
+ */
+int at86rf215_set_iq_eec(struct at86rf215 *h, uint8_t enable)
+{
+    uint8_t val = 0;
+    int ret = ready(h);
+    if (ret)
+    {
+        return ret;
+    }
+    ret = at86rf215_reg_read_8(h, &val, REG_RF_IQIFC0);
+    if (ret)
+    {
+        return ret;
+    }
+    val = enable ? (val | BIT(0)) : (val & ~BIT(0));
+    return at86rf215_reg_write_8(h, val, REG_RF_IQIFC0);
+}
+
 ///// ***************************************external functions***********************************************////////////
 ///
 ///
 
-void AT86RF215Write(uint16_t addr, uint8_t data)
+/*
+ * The legacy accessors run only with the bus to themselves. When the
+ * preempted code holds it (see SpiBusLock()) the access is dropped,
+ * traced, and the buffer functions return -AT86RF215_BUS_BUSY. A read
+ * through AT86RF215Read() then gives 0.
+ */
+int AT86RF215Write(uint16_t addr, uint8_t data)
 {
-    AT86RF215WriteBuffer(addr, &data, 1);
+    return AT86RF215WriteBuffer(addr, &data, 1);
 }
 
 uint8_t AT86RF215Read(uint16_t addr)
@@ -2996,13 +4512,18 @@ uint8_t AT86RF215Read(uint16_t addr)
     return data;
 }
 
-void AT86RF215WriteBuffer(uint16_t addr, uint8_t *buffer, uint8_t size)
+int AT86RF215WriteBuffer(uint16_t addr, uint8_t *buffer, uint8_t size)
 {
     uint8_t i;
 
     uint8_t addr0 = ((addr >> 8) & 0x3F) | 0x80;
     uint8_t addr1 = addr & 0xFF;
 
+    if (!SpiBusLock())
+    {
+        trace_put(TRACE_BUS_BUSY, 0, addr);
+        return -AT86RF215_BUS_BUSY;
+    }
     GPIO_setOutputLowOnPin(GPIO_PORT_P3, GPIO_PIN0);
 
     SpiInOut_IQRadio(addr0);
@@ -3012,16 +4533,36 @@ void AT86RF215WriteBuffer(uint16_t addr, uint8_t *buffer, uint8_t size)
     {
         SpiInOut_IQRadio(buffer[i]);
     }
+    if (size == 1)
+    {
+        trace_put(TRACE_REG_WRITE, buffer[0], addr);
+    }
+    else
+    {
+        trace_put(TRACE_BURST_WRITE, size, addr);
+    }
 
     GPIO_setOutputHighOnPin(GPIO_PORT_P3, GPIO_PIN0);
+    SpiBusUnlock();
+    return AT86RF215_OK;
 }
 
-void AT86RF215ReadBuffer(uint16_t addr, uint8_t *buffer, uint8_t size)
+int AT86RF215ReadBuffer(uint16_t addr, uint8_t *buffer, uint8_t size)
 {
     uint8_t i;
     uint8_t addr0 = (addr >> 8) & 0x3F;
     uint8_t addr1 = addr & 0xFF;
 
+    if (!SpiBusLock())
+    {
+        /* Taken by the preempted code, see SpiBusLock() */
+        for (i = 0; i < size; i++)
+        {
+            buffer[i] = 0;
+        }
+        trace_put(TRACE_BUS_BUSY, 1, addr);
+        return -AT86RF215_BUS_BUSY;
+    }
     GPIO_setOutputLowOnPin(GPIO_PORT_P3, GPIO_PIN0); //driving low the sel pin to inc
 
 //sending two command bytes to indicate if it is a read or write operation to the slave
@@ -3033,8 +4574,18 @@ void AT86RF215ReadBuffer(uint16_t addr, uint8_t *buffer, uint8_t size)
     {
         buffer[i] = SpiInOut_IQRadio(0);
     }
+    if (size == 1)
+    {
+        trace_put(TRACE_REG_READ, buffer[0], addr);
+    }
+    else
+    {
+        trace_put(TRACE_BURST_READ, size, addr);
+    }
 
     GPIO_setOutputHighOnPin(GPIO_PORT_P3, GPIO_PIN0);
+    SpiBusUnlock();
+    return AT86RF215_OK;
 }
 
 
@@ -3141,7 +4692,7 @@ void AT86RF215TxSetIQ(uint32_t freq)
 
 
          struct at86rf215_iq_conf conf =
-              { .eec = 0, // use internal clock .cmv1v2 = 1, // 1.2 V CM ref
+              { .eec = AT86RF215_IQ_EEC, // use internal clock .cmv1v2 = 1, // 1.2 V CM ref
                 .cmv = AT86RF215_LVDS_CMV200, // 200 mV swing
                 .drv = AT86RF215_LVDS_DRV2, // mid drive
                 .extlb = 0 ,// no loopback .skedrv = 0, // default 1 - to test lvds interface using loopback
@@ -3562,11 +5113,15 @@ void AT86RF215_TX_Alt01_Test(void)
 
     // 3) Payload 0101...
     enum { N = 127 };
-    uint8_t frame[N]; memset(frame, 0x66, N);
+    struct frame_buf *frame = frame_buf_alloc(N);
+    if (!frame)
+        return;
+    memset(frame->data, 0x66, N);
 
     AT86RF215Write(REG_BBC0_TXFLL, (uint8_t)(N & 0xFF));
     AT86RF215Write(REG_BBC0_TXFLH, (uint8_t)(N >> 8));
-    AT86RF215WriteBuffer(REG_BBC0_FBTXS, frame, (uint8_t)N);   // burst to 0x2800
+    AT86RF215WriteBuffer(REG_BBC0_FBTXS, frame->data, (uint8_t)N);   // burst to 0x2800
+    frame_buf_free(frame);
 
     // 4) Tune and transmit
     AT86RF215SetChannel(910000000);          // or regional ISM if OTA
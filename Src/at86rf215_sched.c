@@ -0,0 +1,381 @@
+/*
+ * at86rf215_sched.c
+ *
+ * Dual radio scheduler
+ */
+#include <at86rf215_sched.h>
+#include <regs.h>
+#include <spi_helper.h>
+#include <airtime.h>
+
+/* Steps of the work at the head of a radio queue */
+enum
+{
+    STEP_START = 0,
+    STEP_TX_WAIT_PREP,
+    STEP_TX_LOAD,
+    STEP_TX_WAIT_END,
+    STEP_RX_WAIT,
+    STEP_SCAN_WAIT
+};
+
+/* RF24 and BBC1 registers are at a 0x100 offset from RF09 and BBC0 */
+static uint16_t reg_off(at86rf215_radio_t radio)
+{
+    return radio == AT86RF215_RF09 ? 0 : 0x100;
+}
+
+static bool timed_out(const struct at86rf215_radio *r,
+                      const struct at86rf215_work *w)
+{
+    return w->timeout_us
+            && cycles_to_us(cycle_counter_get() - r->work_t0) > w->timeout_us;
+}
+
+static void work_complete(struct at86rf215 *h, at86rf215_radio_t radio,
+                          int status)
+{
+    struct at86rf215_radio *r = &h->priv.radios[radio];
+    struct at86rf215_work *w = r->work_head;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    r->work_head = w->next;
+    if (!r->work_head)
+    {
+        r->work_tail = NULL;
+    }
+    __set_PRIMASK(primask);
+
+    r->work_step = STEP_START;
+    if (w->type == AT86RF215_WORK_TX)
+    {
+        frame_buf_free(w->buf);
+        w->buf = NULL;
+    }
+    w->next = NULL;
+    w->status = status;
+    w->state = AT86RF215_WORK_DONE;
+    if (w->done)
+    {
+        w->done(h, w);
+    }
+}
+
+static int step_tx(struct at86rf215 *h, at86rf215_radio_t radio,
+                   struct at86rf215_work *w)
+{
+    struct at86rf215_radio *r = &h->priv.radios[radio];
+    const uint16_t off = reg_off(radio);
+    at86rf215_rf_state_t state;
+    int ret;
+
+    switch (r->work_step)
+    {
+    case STEP_START:
+        ret = airtime_frame_us(&h->priv.bbc[radio], w->buf->len,
+                               &w->airtime_us);
+        if (w->freq_hz)
+        {
+            /* Unregulated frequencies do not need the airtime */
+            if (duty_cycle_band(w->freq_hz) >= 0 && ret)
+            {
+                return ret;
+            }
+            if (duty_cycle_available_us(w->freq_hz, at86rf215_get_time_ms(h))
+                    < w->airtime_us)
+            {
+                return AT86RF215_OK;
+            }
+        }
+        r->work_pos = 0;
+        r->work_step = STEP_TX_WAIT_PREP;
+        return at86rf215_set_cmd(h, AT86RF215_CMD_RF_TXPREP, radio);
+    case STEP_TX_WAIT_PREP:
+        ret = at86rf215_get_state(h, &state, radio);
+        if (ret)
+        {
+            return ret;
+        }
+        if (state == AT86RF215_STATE_RF_TRXOFF)
+        {
+            return at86rf215_set_cmd(h, AT86RF215_CMD_RF_TXPREP, radio);
+        }
+        if (state == AT86RF215_STATE_RF_TXPREP)
+        {
+            /* TXFLL and TXFLH are contiguous */
+            const uint8_t fl[2] = { w->buf->len & 0xFF, (w->buf->len >> 8) & 0x07 };
+            r->work_step = STEP_TX_LOAD;
+            return at86rf215_reg_write_burst(h, fl, REG_BBC0_TXFLL + off, 2);
+        }
+        return AT86RF215_OK;
+    case STEP_TX_LOAD:
+        if (r->work_pos < w->buf->len)
+        {
+            const uint16_t fb = radio == AT86RF215_RF09 ? REG_BBC0_FBTXS : REG_BBC1_FBTXS;
+            uint16_t n = w->buf->len - r->work_pos;
+            if (n > AT86RF215_SCHED_CHUNK)
+            {
+                n = AT86RF215_SCHED_CHUNK;
+            }
+            ret = at86rf215_reg_write_burst(h, w->buf->data + r->work_pos,
+                                            fb + r->work_pos, n);
+            r->work_pos += n;
+            return ret;
+        }
+        r->tx_complete = 0;
+        r->work_step = STEP_TX_WAIT_END;
+        if (w->freq_hz)
+        {
+            duty_cycle_charge(w->freq_hz, w->airtime_us,
+                              at86rf215_get_time_ms(h));
+        }
+        return at86rf215_set_cmd(h, AT86RF215_CMD_RF_TX, radio);
+    case STEP_TX_WAIT_END:
+        /* Set by the TXFE IRQ */
+        if (r->tx_complete)
+        {
+            work_complete(h, radio, AT86RF215_OK);
+        }
+        return AT86RF215_OK;
+    default:
+        return -AT86RF215_INVAL_VAL;
+    }
+}
+
+static int step_rx(struct at86rf215 *h, at86rf215_radio_t radio,
+                   struct at86rf215_work *w)
+{
+    struct at86rf215_radio *r = &h->priv.radios[radio];
+    at86rf215_rf_state_t state;
+    int ret;
+    (void) w;
+
+    switch (r->work_step)
+    {
+    case STEP_START:
+        ret = at86rf215_rx_arm(h, radio);
+        if (ret)
+        {
+            return ret;
+        }
+        r->work_step = STEP_RX_WAIT;
+        return at86rf215_set_cmd(h, AT86RF215_CMD_RF_RX, radio);
+    case STEP_RX_WAIT:
+        ret = at86rf215_get_state(h, &state, radio);
+        if (ret)
+        {
+            return ret;
+        }
+        switch (state)
+        {
+        case AT86RF215_STATE_RF_RX:
+            work_complete(h, radio, AT86RF215_OK);
+            return AT86RF215_OK;
+        case AT86RF215_STATE_RF_TRXOFF:
+            /* RX is entered through TXPREP */
+            return at86rf215_set_cmd(h, AT86RF215_CMD_RF_TXPREP, radio);
+        case AT86RF215_STATE_RF_TXPREP:
+            return at86rf215_set_cmd(h, AT86RF215_CMD_RF_RX, radio);
+        default:
+            return AT86RF215_OK;
+        }
+    default:
+        return -AT86RF215_INVAL_VAL;
+    }
+}
+
+static int step_scan(struct at86rf215 *h, at86rf215_radio_t radio,
+                     struct at86rf215_work *w)
+{
+    struct at86rf215_radio *r = &h->priv.radios[radio];
+    int ret;
+
+    switch (r->work_step)
+    {
+    case STEP_START:
+        if (!w->scan || w->scan->radio != radio)
+        {
+            return -AT86RF215_INVAL_PARAM;
+        }
+        ret = at86rf215_scan_start(h, w->scan);
+        if (ret)
+        {
+            return ret;
+        }
+        r->work_step = STEP_SCAN_WAIT;
+        return AT86RF215_OK;
+    case STEP_SCAN_WAIT:
+        if (!w->scan->running)
+        {
+            work_complete(h, radio, AT86RF215_OK);
+        }
+        return AT86RF215_OK;
+    default:
+        return -AT86RF215_INVAL_VAL;
+    }
+}
+
+/* Runs one bounded step of the work at the head of the radio queue */
+static void radio_step(struct at86rf215 *h, at86rf215_radio_t radio)
+{
+    struct at86rf215_radio *r = &h->priv.radios[radio];
+    struct at86rf215_work *w = r->work_head;
+    int ret;
+
+    if (!w)
+    {
+        return;
+    }
+    if (w->state != AT86RF215_WORK_ACTIVE)
+    {
+        w->state = AT86RF215_WORK_ACTIVE;
+        r->work_step = STEP_START;
+        r->work_t0 = cycle_counter_get();
+    }
+
+    switch (w->type)
+    {
+    case AT86RF215_WORK_TX:
+        ret = step_tx(h, radio, w);
+        break;
+    case AT86RF215_WORK_RX:
+        ret = step_rx(h, radio, w);
+        break;
+    case AT86RF215_WORK_SCAN:
+        ret = step_scan(h, radio, w);
+        break;
+    default:
+        ret = -AT86RF215_INVAL_PARAM;
+        break;
+    }
+
+    /* The work may have just completed, r->work_head moved on then */
+    if (r->work_head != w)
+    {
+        return;
+    }
+    if (ret)
+    {
+        work_complete(h, radio, ret);
+    }
+    else if (timed_out(r, w))
+    {
+        if (w->type == AT86RF215_WORK_SCAN)
+        {
+            at86rf215_scan_stop(h, w->scan);
+        }
+        work_complete(h, radio, -AT86RF215_TIMEOUT);
+    }
+}
+
+/**
+ * Prepares the scheduler. Enables the TXFE IRQ of the baseband cores, that
+ * completes the TX work.
+ * @param h the device handle
+ * @return 0 on success or negative error code
+ */
+int at86rf215_sched_init(struct at86rf215 *h)
+{
+    size_t i;
+    if (!h)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    for (i = 0; i < 2; i++)
+    {
+        struct at86rf215_radio *r = &h->priv.radios[i];
+        r->work_head = NULL;
+        r->work_tail = NULL;
+        r->work_step = STEP_START;
+
+        uint8_t mask = 0;
+        int ret = at86rf215_reg_read_8(h, &mask, REG_BBC0_IRQM + reg_off(i));
+        if (ret)
+        {
+            return ret;
+        }
+        ret = at86rf215_reg_write_8(h, mask | BIT(AT86RF215_BB_IRQ_TXFE),
+                                    REG_BBC0_IRQM + reg_off(i));
+        if (ret)
+        {
+            return ret;
+        }
+    }
+    return AT86RF215_OK;
+}
+
+/**
+ * Queues work for a radio. Works of the same radio run in order, works of
+ * different radios run concurrently. Safe from interrupt context.
+ * @param h the device handle
+ * @param radio the RF frontend
+ * @param w the work
+ * @return 0 on success or negative error code
+ */
+int at86rf215_sched_submit(struct at86rf215 *h, at86rf215_radio_t radio,
+                           struct at86rf215_work *w)
+{
+    if (!h || !w || (radio != AT86RF215_RF09 && radio != AT86RF215_RF24))
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    if (w->type == AT86RF215_WORK_TX && !w->buf)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    if (w->type == AT86RF215_WORK_SCAN && !w->scan)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    struct at86rf215_radio *r = &h->priv.radios[radio];
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (w->state == AT86RF215_WORK_QUEUED || w->state == AT86RF215_WORK_ACTIVE)
+    {
+        __set_PRIMASK(primask);
+        return -AT86RF215_INVAL_PARAM;
+    }
+    w->next = NULL;
+    w->status = AT86RF215_OK;
+    w->state = AT86RF215_WORK_QUEUED;
+    if (r->work_tail)
+    {
+        r->work_tail->next = w;
+    }
+    else
+    {
+        r->work_head = w;
+    }
+    r->work_tail = w;
+    __set_PRIMASK(primask);
+    return AT86RF215_OK;
+}
+
+/**
+ * Advances each radio by one step, alternating which one goes first.
+ * Should be called repeatedly from the main loop.
+ * @param h the device handle
+ */
+void at86rf215_sched_poll(struct at86rf215 *h)
+{
+    static uint8_t first = AT86RF215_RF09;
+    if (!h)
+    {
+        return;
+    }
+    radio_step(h, (at86rf215_radio_t) first);
+    radio_step(h, (at86rf215_radio_t) (first ^ 1));
+    first ^= 1;
+}
+
+/**
+ * @param h the device handle
+ * @return true if no radio has pending work
+ */
+bool at86rf215_sched_idle(struct at86rf215 *h)
+{
+    return !h->priv.radios[AT86RF215_RF09].work_head
+            && !h->priv.radios[AT86RF215_RF24].work_head;
+}
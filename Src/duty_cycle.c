@@ -0,0 +1,205 @@
+/*
+ * duty_cycle.c
+ *
+ * Sliding window airtime budgets per sub-band
+ */
+#include <duty_cycle.h>
+
+struct record
+{
+    uint32_t end_ms;        /* last symbol on air */
+    uint32_t us;
+};
+
+struct band
+{
+    uint32_t lo_hz;
+    uint32_t hi_hz;
+    uint32_t window_ms;
+    uint32_t budget_us;
+    uint32_t used_us;       /* sum of the records */
+    uint8_t  head;          /* oldest record */
+    uint8_t  count;
+    struct record rec[DUTY_CYCLE_RECORDS];
+    struct duty_cycle_stats stats;
+};
+
+static struct band bands[DUTY_CYCLE_BANDS];
+static uint8_t nbands = 0;
+
+void duty_cycle_init(void)
+{
+    nbands = 0;
+}
+
+/*
+ * Registers a sub-band [lo_hz, hi_hz] limited to ppm parts per million of
+ * any window_ms long period, e.g. 10000 ppm over 3600000 ms for 1% per hour.
+ * Returns the band index or -1 if the table is full or the band invalid.
+ */
+int duty_cycle_band_add(uint32_t lo_hz, uint32_t hi_hz, uint32_t ppm,
+                        uint32_t window_ms)
+{
+    if (nbands >= DUTY_CYCLE_BANDS || lo_hz > hi_hz || !window_ms
+            || ppm > 1000000)
+    {
+        return -1;
+    }
+    struct band *b = &bands[nbands];
+    b->lo_hz = lo_hz;
+    b->hi_hz = hi_hz;
+    b->window_ms = window_ms;
+    b->budget_us = ((uint64_t) window_ms * ppm) / 1000;
+    b->used_us = 0;
+    b->head = 0;
+    b->count = 0;
+    b->stats = (struct duty_cycle_stats) { 0 };
+    b->stats.budget_us = b->budget_us;
+    return nbands++;
+}
+
+/* The sub-band holding freq_hz, -1 if it is not regulated */
+int duty_cycle_band(uint32_t freq_hz)
+{
+    uint8_t i;
+    for (i = 0; i < nbands; i++)
+    {
+        if (freq_hz >= bands[i].lo_hz && freq_hz <= bands[i].hi_hz)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static struct record *rec_at(struct band *b, uint8_t i)
+{
+    return &b->rec[(b->head + i) % DUTY_CYCLE_RECORDS];
+}
+
+/* Drops the records that left the window */
+static void expire(struct band *b, uint32_t now_ms)
+{
+    while (b->count)
+    {
+        const struct record *r = rec_at(b, 0);
+        if ((int32_t) (now_ms - r->end_ms) < (int32_t) b->window_ms)
+        {
+            break;
+        }
+        b->used_us -= r->us;
+        b->head = (b->head + 1) % DUTY_CYCLE_RECORDS;
+        b->count--;
+    }
+}
+
+static struct band *lookup(uint32_t freq_hz, uint32_t now_ms)
+{
+    const int i = duty_cycle_band(freq_hz);
+    if (i < 0)
+    {
+        return NULL;
+    }
+    expire(&bands[i], now_ms);
+    return &bands[i];
+}
+
+/*
+ * Airtime that can be sent right now on freq_hz without exceeding the
+ * limit. DUTY_CYCLE_UNLIMITED if the frequency is not regulated.
+ */
+uint32_t duty_cycle_available_us(uint32_t freq_hz, uint32_t now_ms)
+{
+    const struct band *b = lookup(freq_hz, now_ms);
+    if (!b)
+    {
+        return DUTY_CYCLE_UNLIMITED;
+    }
+    return b->used_us < b->budget_us ? b->budget_us - b->used_us : 0;
+}
+
+/* Whether a frame of airtime_us fits in the budget left */
+bool duty_cycle_allowed(uint32_t freq_hz, uint32_t airtime_us,
+                        uint32_t now_ms)
+{
+    if (duty_cycle_available_us(freq_hz, now_ms) >= airtime_us)
+    {
+        return true;
+    }
+    bands[duty_cycle_band(freq_hz)].stats.denied++;
+    return false;
+}
+
+/*
+ * Milliseconds until a frame of airtime_us fits, 0 if it does already.
+ * DUTY_CYCLE_UNLIMITED if it never will, being longer than the budget.
+ */
+uint32_t duty_cycle_wait_ms(uint32_t freq_hz, uint32_t airtime_us,
+                            uint32_t now_ms)
+{
+    struct band *b = lookup(freq_hz, now_ms);
+    if (!b || b->used_us + airtime_us <= b->budget_us)
+    {
+        return 0;
+    }
+    if (airtime_us > b->budget_us)
+    {
+        return DUTY_CYCLE_UNLIMITED;
+    }
+    /* The oldest records leave the window first */
+    const uint32_t need = b->used_us + airtime_us - b->budget_us;
+    uint32_t freed = 0;
+    uint8_t i;
+    for (i = 0; i < b->count; i++)
+    {
+        const struct record *r = rec_at(b, i);
+        freed += r->us;
+        if (freed >= need)
+        {
+            return r->end_ms + b->window_ms - now_ms;
+        }
+    }
+    return DUTY_CYCLE_UNLIMITED;
+}
+
+/*
+ * Records a transmission of airtime_us starting at now_ms. Frequencies
+ * outside of the registered sub-bands are not accounted.
+ */
+void duty_cycle_charge(uint32_t freq_hz, uint32_t airtime_us, uint32_t now_ms)
+{
+    struct band *b = lookup(freq_hz, now_ms);
+    if (!b)
+    {
+        return;
+    }
+    if (b->count == DUTY_CYCLE_RECORDS)
+    {
+        struct record *oldest = rec_at(b, 0);
+        struct record *next = rec_at(b, 1);
+        next->us += oldest->us;
+        b->head = (b->head + 1) % DUTY_CYCLE_RECORDS;
+        b->count--;
+        b->stats.merges++;
+    }
+    struct record *r = rec_at(b, b->count);
+    r->end_ms = now_ms + (airtime_us + 999) / 1000;
+    r->us = airtime_us;
+    b->count++;
+    b->used_us += airtime_us;
+    b->stats.frames++;
+}
+
+/* Returns false for an unknown band */
+bool duty_cycle_stats(int band, uint32_t now_ms,
+                      struct duty_cycle_stats *stats)
+{
+    if (band < 0 || band >= nbands || !stats)
+    {
+        return false;
+    }
+    expire(&bands[band], now_ms);
+    *stats = bands[band].stats;
+    stats->used_us = bands[band].used_us;
+    return true;
+}
@@ -0,0 +1,476 @@
+/*
+ * frag.c
+ *
+ * Fragmentation with streamed upload and in-place reassembly
+ */
+#include <frag.h>
+#include <airtime.h>
+#include <timebase.h>
+#include <regs.h>
+#include <string.h>
+
+#if FRAG_MAX_FRAGS > 32
+#error "FRAG_MAX_FRAGS should fit the 32-bit fragment mask"
+#endif
+
+enum
+{
+    STEP_START = 0,
+    STEP_WAIT_PREP,
+    STEP_LOAD,
+    STEP_WAIT_END
+};
+
+/* Bound of the TXPREP transition, and slack on top of a fragment airtime */
+#define TXPREP_TIMEOUT_US   1000
+#define TX_SLACK_US         1000
+
+static size_t fcs_len(struct at86rf215 *h, at86rf215_radio_t radio)
+{
+    return airtime_fcs_len(&h->priv.bbc[radio]);
+}
+
+/* Frame pool blocks able to take a frame of len bytes, in use or not */
+static size_t pool_blocks(size_t len)
+{
+    size_t c;
+    size_t n = 0;
+    struct frame_pool_stats st;
+    for (c = 0; c < frame_pool_num_classes(); c++)
+    {
+        if (frame_pool_get_stats(c, &st) == AT86RF215_OK && st.size >= len)
+        {
+            n += st.total;
+        }
+    }
+    return n;
+}
+
+static void finish(struct frag_tx *t, int status)
+{
+    t->status = status;
+    t->busy = 0;
+}
+
+/*
+ * Sends the message gathered from iov as fragments of up to frag_len
+ * payload bytes, from frag_tx_poll(). The list and the data it points to
+ * should stay valid while t->busy is set. Returns -AT86RF215_INVAL_PARAM
+ * for a message that a receiver with the same frame pool could not hold.
+ */
+int frag_tx_start(struct frag_tx *t, struct at86rf215 *h,
+                  at86rf215_radio_t radio, const struct frag_iov *iov,
+                  size_t iovcnt, uint16_t frag_len, uint8_t msg_id)
+{
+    size_t i;
+    if (!t || !h || !iov || !iovcnt || !frag_len)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    if (FRAG_HDR_LEN + frag_len + fcs_len(h, radio) > AT86RF215_MAX_PDU)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    uint32_t total = 0;
+    for (i = 0; i < iovcnt; i++)
+    {
+        if (!iov[i].base && iov[i].len)
+        {
+            return -AT86RF215_INVAL_PARAM;
+        }
+        total += iov[i].len;
+    }
+    const uint32_t nfrags = (total + frag_len - 1) / frag_len;
+    if (!total || total > FRAG_MAX_TOTAL || nfrags > FRAG_MAX_FRAGS)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    if (nfrags + FRAG_RX_RESERVE
+            > pool_blocks(FRAG_HDR_LEN + frag_len + fcs_len(h, radio)))
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    if (t->busy)
+    {
+        return -AT86RF215_INVAL_CONF;
+    }
+    t->h = h;
+    t->radio = radio;
+    t->iov = iov;
+    t->iovcnt = iovcnt;
+    t->total = total;
+    t->frag_len = frag_len;
+    t->msg_id = msg_id;
+    t->status = AT86RF215_OK;
+    t->step = STEP_START;
+    t->index = 0;
+    t->offset = 0;
+    t->cur_iov = 0;
+    t->cur_off = 0;
+    t->busy = 1;
+    return AT86RF215_OK;
+}
+
+/* Writes the next n bytes of the source list to the frame buffer at pos */
+static int upload(struct frag_tx *t, uint16_t fb, uint16_t pos, size_t n)
+{
+    while (n)
+    {
+        const struct frag_iov *v = &t->iov[t->cur_iov];
+        size_t k = v->len - t->cur_off;
+        if (!k)
+        {
+            t->cur_iov++;
+            t->cur_off = 0;
+            continue;
+        }
+        if (k > n)
+        {
+            k = n;
+        }
+        int ret = at86rf215_reg_write_burst(t->h, v->base + t->cur_off,
+                                            fb + pos, k);
+        if (ret)
+        {
+            return ret;
+        }
+        t->cur_off += k;
+        pos += k;
+        n -= k;
+    }
+    return AT86RF215_OK;
+}
+
+/*
+ * Uploads the header and the lead of the fragment, starts it and uploads
+ * the rest while the SHR is on air. Runs to the end of the upload, so the
+ * upload cannot fall behind the transmission.
+ */
+static int load_and_send(struct frag_tx *t)
+{
+    struct at86rf215_radio *r = &t->h->priv.radios[t->radio];
+    const uint16_t off = t->radio == AT86RF215_RF09 ? 0 : 0x100;
+    const uint16_t fb =
+            t->radio == AT86RF215_RF09 ? REG_BBC0_FBTXS : REG_BBC1_FBTXS;
+    uint32_t plen = t->total - t->offset;
+    if (plen > t->frag_len)
+    {
+        plen = t->frag_len;
+    }
+    const uint16_t psdu_len = FRAG_HDR_LEN + plen + fcs_len(t->h, t->radio);
+    uint32_t airtime_us = 0;
+    int ret = airtime_frame_us(&t->h->priv.bbc[t->radio], psdu_len,
+                               &airtime_us);
+    if (ret)
+    {
+        return ret;
+    }
+
+    /* TXFLL and TXFLH are contiguous */
+    const uint8_t fl[2] = { psdu_len & 0xFF, (psdu_len >> 8) & 0x07 };
+    ret = at86rf215_reg_write_burst(t->h, fl, REG_BBC0_TXFLL + off, 2);
+    if (ret)
+    {
+        return ret;
+    }
+    const uint8_t hdr[FRAG_HDR_LEN] = {
+            FRAG_TYPE, t->msg_id, t->index,
+            t->offset & 0xFF, (t->offset >> 8) & 0xFF, (t->offset >> 16) & 0xFF,
+            t->total & 0xFF, (t->total >> 8) & 0xFF, (t->total >> 16) & 0xFF };
+    ret = at86rf215_reg_write_burst(t->h, hdr, fb, FRAG_HDR_LEN);
+    if (ret)
+    {
+        return ret;
+    }
+    const uint32_t lead = plen < FRAG_LEAD ? plen : FRAG_LEAD;
+    ret = upload(t, fb, FRAG_HDR_LEN, lead);
+    if (ret)
+    {
+        return ret;
+    }
+
+    r->tx_complete = 0;
+    ret = at86rf215_set_cmd(t->h, AT86RF215_CMD_RF_TX, t->radio);
+    if (ret)
+    {
+        return ret;
+    }
+    t->t0 = timebase_now();
+    t->limit = timebase_us_to_ticks(airtime_us + TX_SLACK_US);
+    ret = upload(t, fb, FRAG_HDR_LEN + lead, plen - lead);
+    if (ret)
+    {
+        return ret;
+    }
+    t->offset += plen;
+    t->index++;
+    return AT86RF215_OK;
+}
+
+/*
+ * Advances the transmission by one step. Should be called repeatedly from
+ * the main loop while t->busy is set. Returns the error that ended the
+ * transmission, t->status keeps it as well.
+ */
+int frag_tx_poll(struct frag_tx *t)
+{
+    at86rf215_rf_state_t state;
+    int ret = AT86RF215_OK;
+    if (!t || !t->busy)
+    {
+        return AT86RF215_OK;
+    }
+    struct at86rf215_radio *r = &t->h->priv.radios[t->radio];
+    const bool late = (uint32_t) timebase_diff(timebase_now(), t->t0)
+            > t->limit;
+
+    switch (t->step)
+    {
+    case STEP_START:
+        t->t0 = timebase_now();
+        t->limit = timebase_us_to_ticks(TXPREP_TIMEOUT_US);
+        t->step = STEP_WAIT_PREP;
+        ret = at86rf215_set_cmd(t->h, AT86RF215_CMD_RF_TXPREP, t->radio);
+        break;
+    case STEP_WAIT_PREP:
+        ret = at86rf215_get_state(t->h, &state, t->radio);
+        if (!ret && state == AT86RF215_STATE_RF_TXPREP)
+        {
+            t->step = STEP_LOAD;
+        }
+        else if (!ret && late)
+        {
+            ret = -AT86RF215_TIMEOUT;
+        }
+        break;
+    case STEP_LOAD:
+        ret = load_and_send(t);
+        t->step = STEP_WAIT_END;
+        break;
+    case STEP_WAIT_END:
+        /* Set by the TXFE IRQ, the radio is back in TXPREP */
+        if (r->tx_complete)
+        {
+            if (t->offset == t->total)
+            {
+                finish(t, AT86RF215_OK);
+                return AT86RF215_OK;
+            }
+            t->step = STEP_LOAD;
+        }
+        else if (late)
+        {
+            ret = -AT86RF215_TIMEOUT;
+        }
+        break;
+    default:
+        ret = -AT86RF215_INVAL_VAL;
+        break;
+    }
+    if (ret)
+    {
+        finish(t, ret);
+    }
+    return ret;
+}
+
+/* Stops after the fragment on air, if any. The peer expires the rest */
+void frag_tx_cancel(struct frag_tx *t)
+{
+    if (t && t->busy)
+    {
+        finish(t, -AT86RF215_TIMEOUT);
+    }
+}
+
+void frag_rx_init(struct frag_rx *r, frag_deliver_cb_t deliver, void *arg)
+{
+    memset(r, 0, sizeof(*r));
+    r->deliver = deliver;
+    r->arg = arg;
+}
+
+static void slot_release(struct frag_rx_slot *s)
+{
+    uint8_t i;
+    for (i = 0; i < FRAG_MAX_FRAGS; i++)
+    {
+        if (s->bufs[i])
+        {
+            frame_buf_free(s->bufs[i]);
+            s->bufs[i] = NULL;
+        }
+    }
+    s->used = 0;
+}
+
+static struct frag_rx_slot *slot_get(struct frag_rx *r, uint8_t msg_id,
+                                     uint32_t total)
+{
+    struct frag_rx_slot *s;
+    struct frag_rx_slot *oldest = NULL;
+    struct frag_rx_slot *unused = NULL;
+    for (s = r->slots; s < r->slots + FRAG_RX_SLOTS; s++)
+    {
+        if (!s->used)
+        {
+            unused = unused ? unused : s;
+            continue;
+        }
+        if (s->msg_id == msg_id)
+        {
+            if (s->total == total)
+            {
+                return s;
+            }
+            /* The id was reused for another message */
+            r->stats.evicted++;
+            slot_release(s);
+            unused = s;
+            break;
+        }
+        if (!oldest || timebase_diff(s->last, oldest->last) < 0)
+        {
+            oldest = s;
+        }
+    }
+    if (!unused)
+    {
+        r->stats.evicted++;
+        slot_release(oldest);
+        unused = oldest;
+    }
+    unused->used = 1;
+    unused->msg_id = msg_id;
+    unused->total = total;
+    unused->rcvd = 0;
+    unused->mask = 0;
+    unused->nfrags = 0;
+    unused->flen = 0;
+    return unused;
+}
+
+static void deliver(struct frag_rx *r, struct frag_rx_slot *s)
+{
+    uint8_t i;
+    size_t n = 0;
+    for (i = 0; i < s->nfrags; i++)
+    {
+        if (s->bufs[i])
+        {
+            r->iov[n].base = s->bufs[i]->data + FRAG_HDR_LEN;
+            r->iov[n].len = s->lens[i];
+            n++;
+        }
+    }
+    r->stats.messages++;
+    if (r->deliver)
+    {
+        r->deliver(r, r->iov, n, s->total, r->arg);
+    }
+    slot_release(s);
+}
+
+/*
+ * Takes a frame from the RX pipeline. Returns false if it is not a
+ * fragment, the caller handles it then. Otherwise keeps a reference to its
+ * block and delivers the message once complete. The caller releases the
+ * frame with at86rf215_rx_release() in both cases.
+ */
+bool frag_rx_input(struct frag_rx *r, struct at86rf215 *h,
+                   struct at86rf215_rx_pkt *pkt)
+{
+    const size_t fcs = fcs_len(h, pkt->radio);
+    if (!pkt->fcs_ok || pkt->len < FRAG_HDR_LEN + fcs
+            || pkt->psdu[0] != FRAG_TYPE)
+    {
+        return false;
+    }
+    const uint8_t *p = pkt->psdu;
+    const uint8_t index = p[2];
+    const uint32_t offset = p[3] | (p[4] << 8) | ((uint32_t) p[5] << 16);
+    const uint32_t total = p[6] | (p[7] << 8) | ((uint32_t) p[8] << 16);
+    const uint32_t plen = pkt->len - FRAG_HDR_LEN - fcs;
+    if (index >= FRAG_MAX_FRAGS || !plen || offset + plen > total)
+    {
+        r->stats.malformed++;
+        return true;
+    }
+    /*
+     * All fragments but the last are full sized, so each offset follows
+     * from the index and the fragment size. Fragments that agree on the
+     * size cover disjoint ranges, and rcvd reaching total means no gap.
+     */
+    const bool last = offset + plen == total;
+    uint32_t flen = plen;
+    if (last && index)
+    {
+        flen = offset / index;
+    }
+    if (offset != index * flen || plen > flen || flen > AT86RF215_MAX_PDU)
+    {
+        r->stats.malformed++;
+        return true;
+    }
+
+    frag_rx_expire(r);
+    struct frag_rx_slot *s = slot_get(r, p[1], total);
+    if (s->flen && s->flen != flen)
+    {
+        /* Another layout under the same id and size, drop both */
+        r->stats.malformed++;
+        slot_release(s);
+        return true;
+    }
+    if (s->mask & (1UL << index))
+    {
+        r->stats.dups++;
+        return true;
+    }
+    /*
+     * The block of pkt is already counted in use, see FRAG_RX_RESERVE; a
+     * fragment completing the message gives its blocks back right away.
+     */
+    const bool completes = s->rcvd + plen == total;
+    if ((!last && (total + plen - 1) / plen + FRAG_RX_RESERVE > pool_blocks(pkt->len))
+            || (!completes
+                    && frame_pool_free_blocks(AT86RF215_MAX_PDU) < FRAG_RX_RESERVE))
+    {
+        r->stats.too_large++;
+        slot_release(s);
+        return true;
+    }
+    frame_buf_ref(pkt->buf);
+    s->bufs[index] = pkt->buf;
+    s->lens[index] = plen;
+    s->mask |= 1UL << index;
+    s->flen = flen;
+    s->rcvd += plen;
+    s->last = timebase_now();
+    if (index >= s->nfrags)
+    {
+        s->nfrags = index + 1;
+    }
+    r->stats.fragments++;
+    if (s->rcvd == s->total)
+    {
+        deliver(r, s);
+    }
+    return true;
+}
+
+/* Drops the partial messages idle for FRAG_RX_TIMEOUT_US */
+void frag_rx_expire(struct frag_rx *r)
+{
+    const uint32_t now = timebase_now();
+    const uint32_t timeout = timebase_us_to_ticks(FRAG_RX_TIMEOUT_US);
+    struct frag_rx_slot *s;
+    for (s = r->slots; s < r->slots + FRAG_RX_SLOTS; s++)
+    {
+        if (s->used && (uint32_t) timebase_diff(now, s->last) > timeout)
+        {
+            r->stats.expired++;
+            slot_release(s);
+        }
+    }
+}
@@ -0,0 +1,186 @@
+/*
+ * frame_pool.c
+ *
+ * Fixed-block frame buffer pool
+ */
+#include <frame_pool.h>
+#include <msp.h>
+
+/* Blocks are word aligned so they can be handed to the DMA as is */
+#define FP_BLOCK(size)          (((size) + 3u) & ~3u)
+#define FP_ARENA(size, num)     + FP_BLOCK(size) * (num)
+#define FP_COUNT(size, num)     + (num)
+#define FP_SIZE(size, num)      (size),
+#define FP_TOTAL(size, num)     (num),
+#define FP_ONE(size, num)       + 1
+
+#define FP_NUM_CLASSES  (0 FRAME_POOL_CLASSES(FP_ONE))
+#define FP_NUM_BUFS     (0 FRAME_POOL_CLASSES(FP_COUNT))
+
+static const uint16_t cls_size[FP_NUM_CLASSES] = { FRAME_POOL_CLASSES(FP_SIZE) };
+static const uint16_t cls_total[FP_NUM_CLASSES] = { FRAME_POOL_CLASSES(FP_TOTAL) };
+
+static uint32_t arena[(0 FRAME_POOL_CLASSES(FP_ARENA)) / sizeof(uint32_t)];
+static struct frame_buf bufs[FP_NUM_BUFS];
+
+static struct frame_buf *free_list[FP_NUM_CLASSES];
+static struct frame_pool_stats stats[FP_NUM_CLASSES];
+static volatile uint8_t initialized = 0;
+
+/*
+ * Carves the arena into the block classes. Called implicitly by the first
+ * allocation, calling it again releases every block.
+ */
+void frame_pool_init(void)
+{
+    size_t c, i;
+    size_t b = 0;
+    uint8_t *mem = (uint8_t *) arena;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (c = 0; c < FP_NUM_CLASSES; c++)
+    {
+        free_list[c] = NULL;
+        stats[c].size = cls_size[c];
+        stats[c].total = cls_total[c];
+        stats[c].in_use = 0;
+        stats[c].high_water = 0;
+        stats[c].fails = 0;
+        for (i = 0; i < cls_total[c]; i++, b++)
+        {
+            bufs[b].data = mem;
+            bufs[b].size = cls_size[c];
+            bufs[b].len = 0;
+            bufs[b].cls = c;
+            bufs[b].refs = 0;
+            bufs[b].next = free_list[c];
+            free_list[c] = &bufs[b];
+            mem += FP_BLOCK(cls_size[c]);
+        }
+    }
+    initialized = 1;
+    __set_PRIMASK(primask);
+}
+
+/*
+ * Returns a block of at least len bytes with a single reference, or NULL if
+ * every class that fits is exhausted. Safe from interrupt context.
+ */
+struct frame_buf *frame_buf_alloc(size_t len)
+{
+    size_t c;
+    struct frame_buf *buf = NULL;
+
+    if (!initialized)
+    {
+        frame_pool_init();
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (c = 0; c < FP_NUM_CLASSES; c++)
+    {
+        if (cls_size[c] < len)
+        {
+            continue;
+        }
+        buf = free_list[c];
+        if (buf)
+        {
+            free_list[c] = buf->next;
+            buf->next = NULL;
+            buf->len = 0;
+            buf->refs = 1;
+            if (++stats[c].in_use > stats[c].high_water)
+            {
+                stats[c].high_water = stats[c].in_use;
+            }
+            break;
+        }
+    }
+    if (!buf)
+    {
+        /* Account the miss to the best fitting class */
+        for (c = 0; c < FP_NUM_CLASSES; c++)
+        {
+            if (cls_size[c] >= len)
+            {
+                stats[c].fails++;
+                break;
+            }
+        }
+    }
+    __set_PRIMASK(primask);
+    return buf;
+}
+
+/* Adds a reference, each one needs its own frame_buf_free() */
+void frame_buf_ref(struct frame_buf *buf)
+{
+    if (!buf)
+    {
+        return;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    buf->refs++;
+    __set_PRIMASK(primask);
+}
+
+/* Drops a reference, the block returns to its class with the last one */
+void frame_buf_free(struct frame_buf *buf)
+{
+    if (!buf)
+    {
+        return;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (buf->refs && --buf->refs == 0)
+    {
+        buf->next = free_list[buf->cls];
+        free_list[buf->cls] = buf;
+        stats[buf->cls].in_use--;
+    }
+    __set_PRIMASK(primask);
+}
+
+size_t frame_pool_num_classes(void)
+{
+    return FP_NUM_CLASSES;
+}
+
+int frame_pool_get_stats(size_t cls, struct frame_pool_stats *out)
+{
+    if (cls >= FP_NUM_CLASSES || !out)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *out = stats[cls];
+    __set_PRIMASK(primask);
+    return AT86RF215_OK;
+}
+
+/*
+ * Free blocks that frame_buf_alloc(len) could return, for the users that
+ * hold blocks for long and must leave room to the RX pipeline
+ */
+size_t frame_pool_free_blocks(size_t len)
+{
+    size_t c;
+    size_t n = 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (c = 0; c < FP_NUM_CLASSES; c++)
+    {
+        if (cls_size[c] >= len)
+        {
+            n += stats[c].total - stats[c].in_use;
+        }
+    }
+    __set_PRIMASK(primask);
+    return n;
+}
@@ -0,0 +1,444 @@
+/*
+ * iq_link.c
+ *
+ * LVDS I/Q interface health counters and sync loss recovery
+ */
+#include <iq_link.h>
+#include <regs.h>
+#include <spi_helper.h>
+
+/* Status bits of RF_IQIFC0..2 */
+#define IQIFC0_SF       BIT(6)
+#define IQIFC1_FAILSF   BIT(7)
+#define IQIFC2_SYNC     BIT(7)
+
+/*
+ * Start and recovery steps. REC_PREP waits for the TRXRDY of TXPREP,
+ * REC_VALID for the FPGA samples valid edge after its release, REC_SYNC for
+ * the link to report sync after TX was entered on that edge.
+ */
+typedef enum
+{
+    REC_IDLE = 0,
+    REC_START,
+    REC_PREP,
+    REC_VALID,
+    REC_SYNC
+} rec_state_t;
+
+static struct iq_link_stats stats;
+/* Time in sync is accumulated in cycles, from sync_t0 while synced */
+static uint64_t sync_cycles = 0;
+static uint32_t sync_t0 = 0;
+
+static at86rf215_radio_t link_radio = AT86RF215_RF09;
+static volatile bool recovery_enabled = false;
+static volatile rec_state_t rec_state = REC_IDLE;
+/* Sync failure that started the recovery, and start of the current attempt */
+static uint32_t rec_t0 = 0;
+static uint32_t rec_attempt_t0 = 0;
+static uint32_t rec_us = 0;
+/* FPGA released, waiting for samples valid */
+static uint32_t release_t = 0;
+
+/*
+ * RFn_CMD = TX on the samples valid edge. Queued rather than a blocking
+ * write: the edge may preempt a transaction in flight on the bus.
+ */
+static const uint8_t tx_cmd = AT86RF215_CMD_RF_TX;
+static SpiJob_t tx_job;
+static uint32_t tx_edge = 0;
+
+/*
+ * Takes in the RF_IQIFC0..2 values, read with a single burst. IRQs held off
+ * or interrupt context.
+ */
+static void update(const uint8_t *iqifc, uint32_t now)
+{
+    const uint8_t synced = (iqifc[2] & IQIFC2_SYNC) ? 1 : 0;
+    const uint8_t failsafe = (iqifc[1] & IQIFC1_FAILSF) ? 1 : 0;
+
+    if (stats.synced && !synced)
+    {
+        sync_cycles += now - sync_t0;
+    }
+    else if (!stats.synced && synced)
+    {
+        sync_t0 = now;
+    }
+    if (failsafe && !stats.failsafe_active)
+    {
+        stats.failsafe++;
+    }
+    stats.synced = synced;
+    stats.failsafe_active = failsafe;
+}
+
+static int read_iqifc(struct at86rf215 *h, uint8_t *iqifc)
+{
+    /* RF_IQIFC0, RF_IQIFC1 and RF_IQIFC2 are contiguous */
+    return at86rf215_reg_read_burst(h, iqifc, REG_RF_IQIFC0, 3);
+}
+
+/*
+ * First half of the recovery: stops the transmitter and holds the FPGA in
+ * reset, then asks for TXPREP. The rest happens on TRXRDY, no fixed waits.
+ * The state is set before each command, since the register accessors let
+ * the radio IRQ in between.
+ */
+static void recover_start(struct at86rf215 *h, uint32_t t0, bool retry)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!recovery_enabled || (rec_state != REC_IDLE && !retry))
+    {
+        __set_PRIMASK(primask);
+        return;
+    }
+    rec_state = REC_START;
+    if (!retry)
+    {
+        rec_t0 = t0;
+    }
+    rec_attempt_t0 = cycle_counter_get();
+    stats.recovering = 1;
+    __set_PRIMASK(primask);
+
+    iq_link_fpga_hold(true);
+    at86rf215_set_cmd(h, AT86RF215_CMD_RF_TRXOFF, link_radio);
+    rec_state = REC_PREP;
+    /* On failure TRXRDY never comes and the attempt times out */
+    at86rf215_set_cmd(h, AT86RF215_CMD_RF_TXPREP, link_radio);
+}
+
+static void iqifsf_handler(struct at86rf215 *h, at86rf215_radio_t radio,
+                           void *arg)
+{
+    uint8_t iqifc[3] = { 0x0, 0x0, 0x0 };
+    (void) radio;
+    (void) arg;
+
+    const uint32_t now = h->priv.irq_time;
+    stats.sync_fail++;
+    stats.last_fail = now;
+    if (read_iqifc(h, iqifc))
+    {
+        /* The IRQ alone says the link lost sync */
+        iqifc[0] = IQIFC0_SF;
+        iqifc[1] = stats.failsafe_active ? IQIFC1_FAILSF : 0;
+        iqifc[2] = 0;
+    }
+    update(iqifc, now);
+    /* Failures while recovering are expected, the FPGA is held in reset */
+    recover_start(h, now, false);
+}
+
+static void trxrdy_handler(struct at86rf215 *h, at86rf215_radio_t radio,
+                           void *arg)
+{
+    (void) h;
+    (void) radio;
+    (void) arg;
+
+    if (rec_state != REC_PREP)
+    {
+        return;
+    }
+    /* TX follows on samples valid, see iq_link_samples_valid() */
+    rec_state = REC_VALID;
+    release_t = cycle_counter_get();
+    iq_link_fpga_hold(false);
+}
+
+static void trxerr_handler(struct at86rf215 *h, at86rf215_radio_t radio,
+                           void *arg)
+{
+    (void) h;
+    (void) radio;
+    (void) arg;
+    stats.tx_err++;
+}
+
+/*
+ * Starts tracking the I/Q link of a radio: hooks the IQIFSF, TRXRDY and
+ * TRXERR IRQs and enables them, then samples the current link state.
+ */
+int iq_link_init(struct at86rf215 *h, at86rf215_radio_t radio)
+{
+    const at86rf215_irq_src_t src =
+            radio == AT86RF215_RF09 ? AT86RF215_IRQ_SRC_RF09 : AT86RF215_IRQ_SRC_RF24;
+    const uint16_t irqm = radio == AT86RF215_RF09 ? REG_RF09_IRQM : REG_RF24_IRQM;
+    uint8_t mask = 0;
+
+    if (!h || (radio != AT86RF215_RF09 && radio != AT86RF215_RF24))
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    link_radio = radio;
+    rec_state = REC_IDLE;
+    iq_link_reset();
+    int ret = at86rf215_irq_register(h, src, AT86RF215_RF_IRQ_IQIFSF,
+                                     iqifsf_handler, NULL);
+    if (ret)
+    {
+        return ret;
+    }
+    ret = at86rf215_irq_register(h, src, AT86RF215_RF_IRQ_TRXRDY,
+                                 trxrdy_handler, NULL);
+    if (ret)
+    {
+        return ret;
+    }
+    ret = at86rf215_irq_register(h, src, AT86RF215_RF_IRQ_TRXERR,
+                                 trxerr_handler, NULL);
+    if (ret)
+    {
+        return ret;
+    }
+    ret = at86rf215_reg_read_8(h, &mask, irqm);
+    if (ret)
+    {
+        return ret;
+    }
+    ret = at86rf215_reg_write_8(h,
+                                mask | BIT(AT86RF215_RF_IRQ_IQIFSF)
+                                        | BIT(AT86RF215_RF_IRQ_TRXRDY)
+                                        | BIT(AT86RF215_RF_IRQ_TRXERR),
+                                irqm);
+    if (ret)
+    {
+        return ret;
+    }
+    return iq_link_refresh(h);
+}
+
+/*
+ * Samples the link state with a single burst. Only needed when the link
+ * (re)gains sync, e.g. after entering TX, since that raises no IRQ.
+ */
+int iq_link_refresh(struct at86rf215 *h)
+{
+    uint8_t iqifc[3];
+    int ret = read_iqifc(h, iqifc);
+    if (ret)
+    {
+        return ret;
+    }
+    const uint32_t now = cycle_counter_get();
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    update(iqifc, now);
+    __set_PRIMASK(primask);
+    return AT86RF215_OK;
+}
+
+/*
+ * Snapshot of the counters, without any SPI transaction. Should be called
+ * more often than the cycle counter wraps for in_sync_ms to stay exact.
+ */
+void iq_link_get(struct iq_link_stats *out)
+{
+    if (!out)
+    {
+        return;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (stats.synced)
+    {
+        /* Folded in here too, so a long sync does not wrap the counter */
+        const uint32_t now = cycle_counter_get();
+        sync_cycles += now - sync_t0;
+        sync_t0 = now;
+    }
+    *out = stats;
+    out->in_sync_ms = sync_cycles / (cycle_counter_mhz * 1000);
+    __set_PRIMASK(primask);
+}
+
+/* Clears the counters, the observed link state is kept */
+void iq_link_reset(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    stats.sync_fail = 0;
+    stats.failsafe = 0;
+    stats.tx_err = 0;
+    stats.last_fail = 0;
+    stats.recoveries = 0;
+    stats.recover_timeouts = 0;
+    stats.recover_last_us = 0;
+    stats.recover_max_us = 0;
+    stats.recover_sum_us = 0;
+    stats.start_tx_max_cycles = 0;
+    sync_cycles = 0;
+    sync_t0 = cycle_counter_get();
+    __set_PRIMASK(primask);
+}
+
+/*
+ * Lets an IQIFSF IRQ restart the I/Q path by itself: TRXOFF with the FPGA
+ * held in reset, TXPREP, TX on TRXRDY and the FPGA released.
+ */
+void iq_link_set_recovery(bool enable)
+{
+    recovery_enabled = enable;
+}
+
+/*
+ * Starts the I/Q transmission with the radio in TXPREP: the FPGA is pulsed
+ * through reset and TX is commanded on its samples valid edge, so the first
+ * sample the radio sends is a valid one. Waits at most
+ * IQ_LINK_START_TIMEOUT_US for the edge. iq_link_init() should come first.
+ */
+int iq_link_start(struct at86rf215 *h)
+{
+    if (!h)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (rec_state != REC_IDLE)
+    {
+        __set_PRIMASK(primask);
+        return -AT86RF215_INVAL_CONF;
+    }
+    rec_state = REC_START;
+    __set_PRIMASK(primask);
+
+    iq_link_fpga_hold(true);
+    /* Long enough for the FPGA to see it, and to drop samples valid */
+    const uint32_t hold_t = cycle_counter_get();
+    const uint32_t hold_cycles = ((uint64_t) IQ_LINK_FPGA_RESET_CLOCKS
+            * cycle_counter_mhz * 1000000 + IQ_LINK_FPGA_CLK_HZ - 1)
+            / IQ_LINK_FPGA_CLK_HZ;
+    while (cycle_counter_get() - hold_t < hold_cycles)
+        ;
+    rec_state = REC_VALID;
+    release_t = cycle_counter_get();
+    iq_link_fpga_hold(false);
+    while (rec_state == REC_VALID)
+    {
+        if (cycles_to_us(cycle_counter_get() - release_t) > IQ_LINK_START_TIMEOUT_US)
+        {
+            rec_state = REC_IDLE;
+            return -AT86RF215_TIMEOUT;
+        }
+    }
+    return AT86RF215_OK;
+}
+
+/* The TX command is on the radio, from the EUSCIB0 ISR */
+static void tx_cmd_done(SpiJob_t *job)
+{
+    (void) job;
+    const uint32_t tx_cycles = cycle_counter_get() - tx_edge;
+    stats.start_tx_cycles = tx_cycles;
+    if (tx_cycles > stats.start_tx_max_cycles)
+    {
+        stats.start_tx_max_cycles = tx_cycles;
+    }
+}
+
+/*
+ * The FPGA samples valid edge, to be called by the board GPIO ISR with the
+ * cycle counter at its entry. Edges outside a start or recovery are ignored.
+ * The TX command is queued as an SPI job, start_tx_cycles is taken when it
+ * completes.
+ */
+void iq_link_samples_valid(struct at86rf215 *h, uint32_t cycles)
+{
+    (void) h;
+    if (rec_state != REC_VALID)
+    {
+        return;
+    }
+    const uint16_t reg = link_radio == AT86RF215_RF09 ? REG_RF09_CMD : REG_RF24_CMD;
+    tx_job.client = SPI_CLIENT_IQRADIO;
+    tx_job.prio = SPI_PRIO_IRQ;
+    tx_job.cs_port = GPIO_PORT_P3; /* same SELN as at86rf215_set_seln() */
+    tx_job.cs_pin = GPIO_PIN0;
+    tx_job.hdr[0] = 0x80 | ((reg >> 8) & 0x3F);
+    tx_job.hdr[1] = reg & 0xFF;
+    tx_job.hdr_len = 2;
+    tx_job.tx = &tx_cmd;
+    tx_job.rx = NULL;
+    tx_job.len = 1;
+    tx_job.done = tx_cmd_done;
+    tx_job.arg = NULL;
+    tx_edge = cycles;
+    if (!SpiJobSubmit(&tx_job))
+    {
+        /* Still in flight from the previous edge */
+        return;
+    }
+
+    stats.last_start = cycles;
+    stats.start_valid_us = cycles_to_us(cycles - release_t);
+    if (stats.recovering)
+    {
+        /* The outage ends here, the sync check only confirms it */
+        rec_us = cycles_to_us(cycle_counter_get() - rec_t0);
+        rec_state = REC_SYNC;
+    }
+    else
+    {
+        rec_state = REC_IDLE;
+    }
+}
+
+/*
+ * Completes a recovery once the link reports sync again, and restarts the
+ * attempts that overran IQ_LINK_RECOVER_TIMEOUT_US. Sync acquisition raises
+ * no IRQ, so this should be called periodically while stats.recovering is
+ * set; it costs no SPI transaction otherwise.
+ */
+int iq_link_poll(struct at86rf215 *h)
+{
+    const rec_state_t state = rec_state;
+    if (state == REC_IDLE)
+    {
+        return AT86RF215_OK;
+    }
+    if (state == REC_SYNC)
+    {
+        int ret = iq_link_refresh(h);
+        if (ret)
+        {
+            return ret;
+        }
+        if (stats.synced)
+        {
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            stats.recoveries++;
+            stats.recover_last_us = rec_us;
+            stats.recover_sum_us += rec_us;
+            if (rec_us > stats.recover_max_us)
+            {
+                stats.recover_max_us = rec_us;
+            }
+            stats.recovering = 0;
+            rec_state = REC_IDLE;
+            __set_PRIMASK(primask);
+            return AT86RF215_OK;
+        }
+    }
+    if (cycles_to_us(cycle_counter_get() - rec_attempt_t0)
+            > IQ_LINK_RECOVER_TIMEOUT_US)
+    {
+        stats.recover_timeouts++;
+        recover_start(h, rec_t0, true);
+    }
+    return AT86RF215_OK;
+}
+
+/*
+ * Holds the FPGA I/Q stream in reset while the radio is taken out of TX.
+ * The board should provide it, the default does nothing.
+ */
+__attribute__((weak)) void iq_link_fpga_hold(bool hold)
+{
+    (void) hold;
+}
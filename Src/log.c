@@ -0,0 +1,201 @@
+/*
+ * log.c
+ *
+ * Deferred binary logger, drained by DMA CH4 into eUSCI_A2
+ */
+#include <log.h>
+#include <msp.h>
+#include <driverlib.h>
+#include <string.h>
+#include <spi_helper.h>
+
+#if LOG_RING_SIZE & (LOG_RING_SIZE - 1)
+#error "LOG_RING_SIZE should be a power of 2"
+#endif
+
+#define LOG_DMA_CH          4
+/* uDMA basic mode moves at most 1024 items per request */
+#define LOG_DMA_MAX_XFER    1024
+/* Sync, id, length, the time delta and the arguments, 5 bytes per varint */
+#define LOG_FRAME_MAX       (3 + 5 * (1 + LOG_MAX_ARGS))
+
+static uint8_t ring[LOG_RING_SIZE];
+static volatile uint32_t head = 0;      /* written by log_write() */
+static volatile uint32_t tail = 0;      /* advanced by the DMA ISR */
+static volatile uint16_t inflight = 0;  /* bytes handed to the DMA */
+static uint32_t last_cycles = 0;
+static volatile uint32_t dropped = 0;
+static uint32_t dropped_reported = 0;
+static volatile uint8_t initialized = 0;
+
+static size_t put_varint(uint8_t *p, uint32_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80)
+    {
+        p[n++] = (v & 0x7F) | 0x80;
+        v >>= 7;
+    }
+    p[n++] = v;
+    return n;
+}
+
+/* Hands the next contiguous part of the ring to the DMA. IRQs held off */
+static void kick(void)
+{
+    if (inflight || head == tail)
+    {
+        return;
+    }
+    const uint32_t off = tail & (LOG_RING_SIZE - 1);
+    uint32_t n = head - tail;
+    if (n > LOG_RING_SIZE - off)
+    {
+        n = LOG_RING_SIZE - off;
+    }
+    if (n > LOG_DMA_MAX_XFER)
+    {
+        n = LOG_DMA_MAX_XFER;
+    }
+    inflight = n;
+    DMA_setChannelTransfer(UDMA_PRI_SELECT | DMA_CH4_EUSCIA2TX,
+            UDMA_MODE_BASIC, &ring[off],
+            (void *) UART_getTransmitBufferAddressForDMA(EUSCI_A2_BASE), n);
+    DMA_enableChannel(LOG_DMA_CH);
+}
+
+/* Frames a message and copies it into the ring. IRQs held off */
+static bool put_frame(log_id_t id, size_t nargs, const uint32_t *args)
+{
+    uint8_t f[LOG_FRAME_MAX];
+    size_t i, n = 3;
+
+    const uint32_t us = cycles_to_us(cycle_counter_get() - last_cycles);
+    n += put_varint(&f[n], us);
+    for (i = 0; i < nargs; i++)
+    {
+        n += put_varint(&f[n], args[i]);
+    }
+    f[0] = LOG_SYNC;
+    f[1] = id;
+    f[2] = n - 3;
+
+    if (LOG_RING_SIZE - (head - tail) < n)
+    {
+        return false;
+    }
+    const uint32_t off = head & (LOG_RING_SIZE - 1);
+    const size_t first = n < LOG_RING_SIZE - off ? n : LOG_RING_SIZE - off;
+    memcpy(&ring[off], f, first);
+    memcpy(ring, &f[first], n - first);
+    head += n;
+    /* Carry the sub-microsecond remainder over to the next frame */
+    last_cycles += us_to_cycles(us);
+    return true;
+}
+
+/*
+ * Sets up eUSCI_A2 at LOG_BAUD and DMA CH4. Should be called after
+ * SpiJobInit(), which enables the DMA and owns its control table.
+ */
+void log_init(void)
+{
+    /* Divider for SMCLK, oversampling whenever the clock allows it */
+    const uint32_t n = CS_getSMCLK() / LOG_BAUD;
+    eUSCI_UART_Config cfg = {
+        EUSCI_A_UART_CLOCKSOURCE_SMCLK,
+        n >= 16 ? n / 16 : n,                       // UCBRx
+        n >= 16 ? n % 16 : 0,                       // UCBRFx
+        0,                                          // UCBRSx
+        EUSCI_A_UART_NO_PARITY,
+        EUSCI_A_UART_LSB_FIRST,
+        EUSCI_A_UART_ONE_STOP_BIT,
+        EUSCI_A_UART_MODE,
+        n >= 16 ? EUSCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION
+                : EUSCI_A_UART_LOW_FREQUENCY_BAUDRATE_GENERATION
+    };
+
+    GPIO_setAsPeripheralModuleFunctionOutputPin(GPIO_PORT_P3, GPIO_PIN3,
+                                                GPIO_PRIMARY_MODULE_FUNCTION);
+    UART_initModule(EUSCI_A2_BASE, &cfg);
+    UART_enableModule(EUSCI_A2_BASE);
+
+    DMA_assignChannel(DMA_CH4_EUSCIA2TX);
+    DMA_disableChannelAttribute(DMA_CH4_EUSCIA2TX, UDMA_ATTR_ALL);
+    DMA_setChannelControl(UDMA_PRI_SELECT | DMA_CH4_EUSCIA2TX,
+            UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE | UDMA_ARB_1);
+    DMA_assignInterrupt(DMA_INT2, LOG_DMA_CH);
+    DMA_clearInterruptFlag(LOG_DMA_CH);
+    /* Below the radio, the log can always wait */
+    Interrupt_setPriority(INT_DMA_INT2, 0x80);
+    DMA_enableInterrupt(DMA_INT2);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    head = 0;
+    tail = 0;
+    inflight = 0;
+    dropped = 0;
+    dropped_reported = 0;
+    last_cycles = cycle_counter_get();
+    initialized = 1;
+    __set_PRIMASK(primask);
+}
+
+/*
+ * Queues a message. Never waits: when the ring is full the message is
+ * dropped and counted, the count goes out with the next message that fits.
+ * Safe from interrupt context. Returns false if the message was dropped.
+ */
+bool log_write(log_id_t id, size_t nargs, const uint32_t *args)
+{
+    bool ok = false;
+    if (!initialized || id >= LOG_ID_NUM || nargs > LOG_MAX_ARGS
+            || (nargs && !args))
+    {
+        return false;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (dropped != dropped_reported)
+    {
+        const uint32_t lost = dropped - dropped_reported;
+        if (put_frame(LOG_DROPPED, 1, &lost))
+        {
+            dropped_reported += lost;
+        }
+    }
+    if (dropped == dropped_reported)
+    {
+        ok = put_frame(id, nargs, args);
+    }
+    if (!ok)
+    {
+        dropped++;
+    }
+    kick();
+    __set_PRIMASK(primask);
+    return ok;
+}
+
+/* True once every queued byte has been handed to the UART */
+bool log_idle(void)
+{
+    return head == tail;
+}
+
+/* Messages dropped since log_init() */
+uint32_t log_dropped(void)
+{
+    return dropped;
+}
+
+/* DMA_INT2 fires when CH4 has moved the bytes given by kick() */
+void DMA_INT2_IRQHandler(void)
+{
+    DMA_clearInterruptFlag(LOG_DMA_CH);
+    tail += inflight;
+    inflight = 0;
+    kick();
+}
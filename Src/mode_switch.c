@@ -0,0 +1,244 @@
+/*
+ * mode_switch.c
+ *
+ * Profile switching by register deltas
+ */
+#include <mode_switch.h>
+#include <timebase.h>
+#include <stdbool.h>
+#include <string.h>
+
+/*
+ * The registers of to that from does not give, or gives with another
+ * value. Both images are sorted.
+ */
+static int delta_build(const struct profile *from, const struct profile *to,
+                       struct at86rf215_reg_val *delta, size_t *n)
+{
+    size_t i = 0, j;
+    *n = 0;
+    for (j = 0; j < to->n; j++)
+    {
+        while (i < from->n && from->img[i].reg < to->img[j].reg)
+        {
+            i++;
+        }
+        if (i < from->n && from->img[i].reg == to->img[j].reg
+                && from->img[i].val == to->img[j].val)
+        {
+            continue;
+        }
+        if (*n == MODE_SWITCH_MAX_REGS)
+        {
+            return -AT86RF215_INVAL_PARAM;
+        }
+        delta[(*n)++] = to->img[j];
+    }
+    return AT86RF215_OK;
+}
+
+static uint32_t elapsed_us(uint32_t t0)
+{
+    return timebase_ticks_to_us((uint32_t) timebase_diff(timebase_now(), t0));
+}
+
+/*
+ * Polls the state until it is want, or with leave until it is no longer
+ * want. With resend, the command is repeated on every poll, a TRXOFF
+ * issued during a transition may be ignored [Errata reference 4840].
+ */
+static int wait_state(struct mode_switch *ms, at86rf215_rf_state_t want,
+                      bool leave, at86rf215_rf_cmd_t resend)
+{
+    const uint32_t t0 = timebase_now();
+    const uint32_t limit = timebase_us_to_ticks(MODE_SWITCH_TIMEOUT_US);
+    at86rf215_rf_state_t state;
+    do
+    {
+        int ret = at86rf215_get_state(ms->h, &state, ms->radio);
+        if (ret)
+        {
+            return ret;
+        }
+        if ((state == want) != leave)
+        {
+            return AT86RF215_OK;
+        }
+        if (resend != AT86RF215_CMD_RF_NOP)
+        {
+            ret = at86rf215_set_cmd(ms->h, resend, ms->radio);
+            if (ret)
+            {
+                return ret;
+            }
+        }
+    }
+    while ((uint32_t) timebase_diff(timebase_now(), t0) <= limit);
+    return -AT86RF215_TIMEOUT;
+}
+
+/* Brings the radio to TRXOFF without cutting a baseband frame */
+static int enter_trxoff(struct mode_switch *ms)
+{
+    at86rf215_rf_state_t state;
+    int ret = at86rf215_get_state(ms->h, &state, ms->radio);
+    if (ret)
+    {
+        return ret;
+    }
+    if (state == AT86RF215_STATE_RF_TRXOFF)
+    {
+        return AT86RF215_OK;
+    }
+    /* In the I/Q mode TX lasts until stopped, a baseband frame ends */
+    if (state == AT86RF215_STATE_RF_TX
+            && ms->h->priv.chpm != AT86RF215_RF_MODE_RF)
+    {
+        ret = wait_state(ms, AT86RF215_STATE_RF_TX, true, AT86RF215_CMD_RF_NOP);
+        if (ret)
+        {
+            return ret;
+        }
+    }
+    ret = at86rf215_set_cmd(ms->h, AT86RF215_CMD_RF_TRXOFF, ms->radio);
+    if (ret)
+    {
+        return ret;
+    }
+    return wait_state(ms, AT86RF215_STATE_RF_TRXOFF, false,
+                      AT86RF215_CMD_RF_TRXOFF);
+}
+
+/*
+ * Precomputes the deltas between profiles a and b and applies a in full,
+ * from TRXOFF. The radio is left in TRXOFF with a as profile 0, b is
+ * profile 1. Both profiles should stay valid while ms is in use.
+ */
+int mode_switch_init(struct mode_switch *ms, struct at86rf215 *h,
+                     at86rf215_radio_t radio, const struct profile *a,
+                     const struct profile *b)
+{
+    if (!ms || !h || !a || !b)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    memset(ms, 0, sizeof(*ms));
+    ms->h = h;
+    ms->radio = radio;
+    ms->prof[0] = a;
+    ms->prof[1] = b;
+    int ret = delta_build(b, a, ms->delta[0], &ms->ndelta[0]);
+    if (ret)
+    {
+        return ret;
+    }
+    ret = delta_build(a, b, ms->delta[1], &ms->ndelta[1]);
+    if (ret)
+    {
+        return ret;
+    }
+    ret = enter_trxoff(ms);
+    if (ret)
+    {
+        return ret;
+    }
+    return profile_apply(h, a);
+}
+
+/*
+ * Switches to profile which (0 or 1) by writing its delta in TRXOFF, then
+ * issues next: AT86RF215_CMD_RF_TXPREP or AT86RF215_CMD_RF_RX wait for the
+ * state to be reached, AT86RF215_CMD_RF_TRXOFF leaves the radio there.
+ * Switching to the current profile only handles the state. lat may be
+ * NULL.
+ */
+int mode_switch_to(struct mode_switch *ms, uint8_t which,
+                   at86rf215_rf_cmd_t next, struct mode_switch_latency *lat)
+{
+    struct mode_switch_latency l = { 0 };
+    at86rf215_rf_state_t want;
+    if (!ms || which > 1)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    switch (next)
+    {
+    case AT86RF215_CMD_RF_TRXOFF:
+        want = AT86RF215_STATE_RF_TRXOFF;
+        break;
+    case AT86RF215_CMD_RF_TXPREP:
+        want = AT86RF215_STATE_RF_TXPREP;
+        break;
+    case AT86RF215_CMD_RF_RX:
+        want = AT86RF215_STATE_RF_RX;
+        break;
+    default:
+        return -AT86RF215_INVAL_PARAM;
+    }
+
+    const bool change = which != ms->cur;
+    const uint32_t t0 = timebase_now();
+    int ret = enter_trxoff(ms);
+    if (ret)
+    {
+        return ret;
+    }
+    l.trxoff_us = elapsed_us(t0);
+
+    if (change)
+    {
+        const uint32_t t = timebase_now();
+        ret = at86rf215_reg_image_apply(ms->h, ms->delta[which],
+                                        ms->ndelta[which]);
+        if (ret)
+        {
+            return ret;
+        }
+        l.apply_us = elapsed_us(t);
+        l.regs = ms->ndelta[which];
+        ms->cur = which;
+        profile_track(ms->h, ms->prof[which]);
+    }
+
+    if (next != AT86RF215_CMD_RF_TRXOFF)
+    {
+        const uint32_t t = timebase_now();
+        ret = at86rf215_set_cmd(ms->h, next, ms->radio);
+        if (ret)
+        {
+            return ret;
+        }
+        ret = wait_state(ms, want, false, AT86RF215_CMD_RF_NOP);
+        if (ret)
+        {
+            return ret;
+        }
+        l.ready_us = elapsed_us(t);
+    }
+    l.total_us = elapsed_us(t0);
+
+    if (change)
+    {
+        ms->stats.switches++;
+        ms->stats.regs_written += l.regs;
+        ms->stats.regs_skipped += ms->prof[which]->n - l.regs;
+        if (l.total_us > ms->stats.max_us)
+        {
+            ms->stats.max_us = l.total_us;
+        }
+    }
+    if (lat)
+    {
+        *lat = l;
+    }
+    return AT86RF215_OK;
+}
+
+void mode_switch_get_stats(const struct mode_switch *ms,
+                           struct mode_switch_stats *stats)
+{
+    if (ms && stats)
+    {
+        *stats = ms->stats;
+    }
+}
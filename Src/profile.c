@@ -0,0 +1,42 @@
+/*
+ * profile.c
+ *
+ * Radio profiles, see profile.h
+ */
+#include <profile.h>
+#include <string.h>
+#include "profile_images.h"
+
+const struct profile profile_iq_rf09 =
+{
+    "iq", AT86RF215_RF09, iq_img, sizeof(iq_img) / sizeof(iq_img[0]), NULL
+};
+
+const struct profile profile_fsk_rf09 =
+{
+    "fsk", AT86RF215_RF09, fsk_img, sizeof(fsk_img) / sizeof(fsk_img[0]),
+    &fsk_bbc
+};
+
+void profile_track(struct at86rf215 *h, const struct profile *p)
+{
+    if (p->bbc)
+    {
+        memcpy(&h->priv.bbc[p->radio], p->bbc, sizeof(*p->bbc));
+    }
+}
+
+int profile_apply(struct at86rf215 *h, const struct profile *p)
+{
+    if (!h || !p)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    int ret = at86rf215_reg_image_apply(h, p->img, p->n);
+    if (ret)
+    {
+        return ret;
+    }
+    profile_track(h, p);
+    return AT86RF215_OK;
+}
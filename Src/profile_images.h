@@ -0,0 +1,66 @@
+/*
+ * profile_images.h
+ *
+ * Register images of the radio profiles, see profile.h. Generated by
+ * tools/profile_gen.cpp, do not edit. Included by profile.c only.
+ */
+#ifndef PROFILE_IMAGES_H
+#define PROFILE_IMAGES_H
+
+#include <at86rf215.h>
+
+/* I/Q streaming at 4 MHz, 910 MHz */
+static const struct at86rf215_reg_val iq_img[] =
+{
+    { 0x00A, 0x16 },
+    { 0x00B, 0x12 },
+    { 0x100, 0x32 },
+    { 0x101, 0x41 },
+    { 0x105, 0x00 },
+    { 0x106, 0x0C },
+    { 0x107, 0x00 },
+    { 0x108, 0x80 },
+    { 0x113, 0x91 },
+    { 0x114, 0x05 },
+};
+
+/* BBC0 2-FSK, 100 ksym/s, 910 MHz */
+static const struct at86rf215_reg_val fsk_img[] =
+{
+    { 0x00A, 0x16 },
+    { 0x00B, 0x02 },
+    { 0x100, 0x12 },
+    { 0x101, 0x41 },
+    { 0x105, 0x00 },
+    { 0x106, 0x0C },
+    { 0x107, 0x00 },
+    { 0x108, 0x80 },
+    { 0x113, 0x84 },
+    { 0x114, 0x05 },
+    { 0x301, 0x1D },
+    { 0x360, 0x5E },
+    { 0x361, 0x01 },
+    { 0x36A, 0x00 },
+};
+
+/* The baseband set up by fsk_img, for h->priv.bbc */
+static const struct at86rf215_bb_conf fsk_bbc =
+{
+    .ctx = 0,
+    .fcsfe = 0,
+    .txafcs = 1,
+    .fcst = AT86RF215_FCS_32,
+    .pt = AT86RF215_BB_MRFSK,
+    .fsk =
+    {
+        .mord = AT86RF215_2FSK,
+        .midx = AT86RF215_MIDX_7,
+        .midxs = AT86RF215_MIDXS_88,
+        .bt = AT86RF215_FSK_BT_10,
+        .srate = AT86RF215_FSK_SRATE_100,
+        .fi = 0,
+        .preamble_length = 8,
+    },
+};
+
+#endif /* PROFILE_IMAGES_H */
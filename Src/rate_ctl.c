@@ -0,0 +1,311 @@
+/*
+ * rate_ctl.c
+ *
+ * Rate ladder with precomputed register images
+ */
+#include <rate_ctl.h>
+#include <regs.h>
+#include <spi_helper.h>
+#include <timebase.h>
+#include <string.h>
+
+#if RATE_CTL_MAX_RUNGS > 255
+#error "RATE_CTL_MAX_RUNGS should fit the 8-bit rung index"
+#endif
+
+/* BBCn_PC.BBEN, cleared by at86rf215_bb_conf() */
+#define PC_BBEN             BIT(2)
+
+/* Success average of a peer just met, or just moved to another rung */
+#define SUCCESS_FULL        256
+
+/*
+ * Registers of an MR-FSK configuration, RF09 and BBC0 set, sorted. The
+ * RF24 and BBC1 ones are at a 0x100 offset.
+ */
+static const uint16_t img_regs[RATE_CTL_IMG_LEN] = {
+    REG_RF09_RXBWC, REG_RF09_RXDFE, REG_RF09_TXDFE,
+    REG_BBC0_PC,
+    REG_BBC0_FSKC0, REG_BBC0_FSKC1, REG_BBC0_FSKC2, REG_BBC0_FSKC3,
+    REG_BBC0_FSKC4, REG_BBC0_FSKPLL, REG_BBC0_FSKSFD0L, REG_BBC0_FSKSFD0H,
+    REG_BBC0_FSKSFD1L, REG_BBC0_FSKSFD1H, REG_BBC0_FSKPHRTX,
+    REG_BBC0_FSKPHRRX, REG_BBC0_FSKRPC, REG_BBC0_FSKRPCONT,
+    REG_BBC0_FSKRPCOFFT,
+    REG_BBC0_FSKRRXFLL, REG_BBC0_FSKRRXFLH, REG_BBC0_FSKDM,
+    REG_BBC0_FSKPE0, REG_BBC0_FSKPE1, REG_BBC0_FSKPE2 };
+
+#define IMG_PC              3
+
+/*
+ * Builds the image of every rung, through at86rf215_bb_conf() and a
+ * capture of the registers it wrote, then applies the first rung. The
+ * radio should be in TRXOFF. rungs should stay valid while the controller
+ * is in use.
+ */
+int rate_ctl_init(struct rate_ctl *rc, struct at86rf215 *h,
+                  at86rf215_radio_t radio, struct rate_ctl_rung *rungs,
+                  size_t nrungs)
+{
+    size_t i, j;
+    if (!rc || !h || !rungs || !nrungs || nrungs > RATE_CTL_MAX_RUNGS)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    memset(rc, 0, sizeof(*rc));
+    rc->h = h;
+    rc->radio = radio;
+    rc->rungs = rungs;
+    rc->nrungs = (uint8_t) nrungs;
+
+    const uint16_t off = radio == AT86RF215_RF09 ? 0 : 0x100;
+    for (i = 0; i < nrungs; i++)
+    {
+        struct rate_ctl_rung *r = &rungs[i];
+        if (r->conf.pt != AT86RF215_BB_MRFSK)
+        {
+            return -AT86RF215_NOT_SUPPORTED;
+        }
+        int ret = at86rf215_bb_conf(h, radio, &r->conf);
+        if (ret)
+        {
+            return ret;
+        }
+        for (j = 0; j < RATE_CTL_IMG_LEN; j++)
+        {
+            r->img[j].reg = img_regs[j] + off;
+        }
+        ret = at86rf215_reg_image_capture(h, r->img, RATE_CTL_IMG_LEN);
+        if (ret)
+        {
+            return ret;
+        }
+        r->img[IMG_PC].val |= PC_BBEN;
+    }
+    /* The radio holds the last rung, force the write of the first */
+    rc->active = nrungs - 1;
+    if (nrungs == 1)
+    {
+        memcpy(&h->priv.bbc[radio], &rungs[0].conf, sizeof(rungs[0].conf));
+        return at86rf215_bb_enable(h, radio, 1);
+    }
+    return rate_ctl_apply(rc, 0);
+}
+
+static struct rate_ctl_peer *peer_get(struct rate_ctl *rc, uint16_t addr)
+{
+    size_t i;
+    struct rate_ctl_peer *p = NULL;
+    for (i = 0; i < RATE_CTL_MAX_PEERS; i++)
+    {
+        if (rc->peers[i].used && rc->peers[i].addr == addr)
+        {
+            return &rc->peers[i];
+        }
+        if (!p && !rc->peers[i].used)
+        {
+            p = &rc->peers[i];
+        }
+    }
+    if (!p)
+    {
+        /* Table full, the peer takes over a slot of its own */
+        p = &rc->peers[addr % RATE_CTL_MAX_PEERS];
+    }
+    memset(p, 0, sizeof(*p));
+    p->used = 1;
+    p->addr = addr;
+    p->success = SUCCESS_FULL;
+    return p;
+}
+
+/* Moving average over about 8 samples */
+static int16_t average(int16_t avg, int16_t sample)
+{
+    return avg + (sample - avg) / 8;
+}
+
+/* Accounts the level of a frame received from the peer */
+void rate_ctl_rx(struct rate_ctl *rc, uint16_t addr,
+                 const struct at86rf215_rx_pkt *pkt)
+{
+    /* 127 marks an invalid reading */
+    if (!pkt || pkt->rssi == 127 || pkt->edv == 127)
+    {
+        return;
+    }
+    struct rate_ctl_peer *p = peer_get(rc, addr);
+    if (!p->level_valid)
+    {
+        p->rssi_q4 = pkt->rssi * 16;
+        p->edv_q4 = pkt->edv * 16;
+        p->level_valid = 1;
+        return;
+    }
+    p->rssi_q4 = average(p->rssi_q4, pkt->rssi * 16);
+    p->edv_q4 = average(p->edv_q4, pkt->edv * 16);
+}
+
+/* Accounts the outcome of a frame sent to the peer, e.g. its ACK */
+void rate_ctl_tx_result(struct rate_ctl *rc, uint16_t addr, bool delivered)
+{
+    struct rate_ctl_peer *p = peer_get(rc, addr);
+    p->success = average(p->success, delivered ? SUCCESS_FULL : 0);
+    if (p->samples < UINT16_MAX)
+    {
+        p->samples++;
+    }
+}
+
+/*
+ * The rung to use for the peer, updated from its statistics. Does not touch
+ * the radio, see rate_ctl_select().
+ */
+int rate_ctl_rung(struct rate_ctl *rc, uint16_t addr)
+{
+    if (!rc)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    struct rate_ctl_peer *p = peer_get(rc, addr);
+    if (!p->level_valid)
+    {
+        return p->rung;
+    }
+    /* The lower of the two, RSSI is only sampled at the end of the frame */
+    const int16_t q4 = p->rssi_q4 < p->edv_q4 ? p->rssi_q4 : p->edv_q4;
+    const int level = q4 / 16;
+    const bool judged = p->samples >= RATE_CTL_MIN_SAMPLES;
+    uint8_t r = p->rung;
+
+    if (level < rc->rungs[r].min_dbm
+            || (judged && p->success < RATE_CTL_DOWN_SUCCESS))
+    {
+        while (r > 0 && rc->rungs[r].min_dbm > level)
+        {
+            r--;
+        }
+        if (r == p->rung && r > 0)
+        {
+            r--;
+        }
+    }
+    else if (r + 1 < rc->nrungs && judged
+            && p->success >= RATE_CTL_UP_SUCCESS
+            && level >= rc->rungs[r + 1].min_dbm + RATE_CTL_HYST_DB)
+    {
+        r++;
+    }
+
+    if (r != p->rung)
+    {
+        if (r > p->rung)
+        {
+            p->ups++;
+        }
+        else
+        {
+            p->downs++;
+        }
+        p->rung = r;
+        p->samples = 0;
+        p->success = SUCCESS_FULL;
+    }
+    return r;
+}
+
+/*
+ * Brings the radio to TRXOFF for the image writes, letting a frame on air
+ * end first. The TRXOFF command is repeated while polling, one issued
+ * during a transition may be ignored [Errata reference 4840]. The state
+ * left is returned in prev.
+ */
+static int enter_trxoff(struct rate_ctl *rc, at86rf215_rf_state_t *prev)
+{
+    const uint32_t t0 = timebase_now();
+    const uint32_t limit = timebase_us_to_ticks(RATE_CTL_TRXOFF_TIMEOUT_US);
+    at86rf215_rf_state_t state;
+    int ret = at86rf215_get_state(rc->h, prev, rc->radio);
+    if (ret)
+    {
+        return ret;
+    }
+    state = *prev;
+    while (state != AT86RF215_STATE_RF_TRXOFF)
+    {
+        if ((uint32_t) timebase_diff(timebase_now(), t0) > limit)
+        {
+            return -AT86RF215_TIMEOUT;
+        }
+        if (state != AT86RF215_STATE_RF_TX)
+        {
+            ret = at86rf215_set_cmd(rc->h, AT86RF215_CMD_RF_TRXOFF, rc->radio);
+            if (ret)
+            {
+                return ret;
+            }
+        }
+        ret = at86rf215_get_state(rc->h, &state, rc->radio);
+        if (ret)
+        {
+            return ret;
+        }
+    }
+    return AT86RF215_OK;
+}
+
+/*
+ * Switches the radio to a rung with its register image, written in
+ * TRXOFF. A frame on air is let to end, the radio then goes back to RX or
+ * TXPREP if it was there. Keeps the driver copy of the baseband
+ * configuration in line, for the airtime computations.
+ */
+int rate_ctl_apply(struct rate_ctl *rc, uint8_t rung)
+{
+    if (!rc || rung >= rc->nrungs)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    if (rung == rc->active)
+    {
+        return AT86RF215_OK;
+    }
+    const struct rate_ctl_rung *r = &rc->rungs[rung];
+    at86rf215_rf_state_t prev;
+    int ret = enter_trxoff(rc, &prev);
+    if (ret)
+    {
+        return ret;
+    }
+    ret = at86rf215_reg_image_apply(rc->h, r->img, RATE_CTL_IMG_LEN);
+    if (ret)
+    {
+        return ret;
+    }
+    memcpy(&rc->h->priv.bbc[rc->radio], &r->conf, sizeof(r->conf));
+    rc->active = rung;
+    rc->switches++;
+    if (prev == AT86RF215_STATE_RF_RX)
+    {
+        return at86rf215_set_cmd(rc->h, AT86RF215_CMD_RF_RX, rc->radio);
+    }
+    if (prev == AT86RF215_STATE_RF_TXPREP)
+    {
+        return at86rf215_set_cmd(rc->h, AT86RF215_CMD_RF_TXPREP, rc->radio);
+    }
+    return AT86RF215_OK;
+}
+
+/*
+ * Picks the rung of the peer and applies it, ahead of a transmission to
+ * it. Returns the rung or a negative error code.
+ */
+int rate_ctl_select(struct rate_ctl *rc, uint16_t addr)
+{
+    int rung = rate_ctl_rung(rc, addr);
+    if (rung < 0)
+    {
+        return rung;
+    }
+    int ret = rate_ctl_apply(rc, rung);
+    return ret ? ret : rung;
+}
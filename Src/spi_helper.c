@@ -27,49 +27,530 @@ volatile unsigned char SPI_RXData_FPGA;
 volatile unsigned char SPI_RXData_Flash;
 
 /* Statics */
-static volatile uint8_t RXData = 0;
+static SpiJob_t *volatile job_head[SPI_PRIO_NUM];
+static SpiJob_t *volatile job_tail[SPI_PRIO_NUM];
+static SpiJob_t *volatile job_active = NULL;
+static volatile uint8_t bus_locked = 0;
+/* IPSR of the bus holder, 0 is thread mode */
+static volatile uint32_t bus_owner = 0;
+/* Byte transfers dropped because another context held the bus */
+static volatile uint32_t bus_busy_drops = 0;
+
+/* Work of the interrupts that found the bus taken, run from PendSV */
+#define SPI_BUS_DEFER_NUM   2
+static SpiBusDeferred_t deferred_fn[SPI_BUS_DEFER_NUM];
+static void *deferred_arg[SPI_BUS_DEFER_NUM];
+
+/* uDMA basic mode moves at most 1024 items per request */
+#define SPI_DMA_MAX_XFER    1024
+#define SPI_DMA_TX_CH       0
+#define SPI_DMA_RX_CH       1
+
+#if defined(__TI_COMPILER_VERSION__)
+#pragma DATA_ALIGN(dma_ctl_table, 1024)
+static DMA_ControlTable dma_ctl_table[32];
+#else
+static DMA_ControlTable dma_ctl_table[32] __attribute__((aligned(1024)));
+#endif
+static uint8_t dma_dummy_tx = 0x00;
+static uint8_t dma_dummy_rx;
+static volatile uint16_t dma_chunk = 0;
 
 /**#############################Functions#############################**/
 
+/*
+ * Blocking byte transfer. The caller owns the bus (see SpiBusLock()), so the
+ * RX interrupt is off and RXIFG can be polled directly.
+ */
+static uint8_t spi_xfer_polled(uint8_t outData)
+{
+    while (!(EUSCI_B_CMSIS(EUSCI_B0_BASE)->IFG & EUSCI_B_IFG_TXIFG))
+        ;
+    EUSCI_B_CMSIS(EUSCI_B0_BASE)->TXBUF = outData;
+    while (!(EUSCI_B_CMSIS(EUSCI_B0_BASE)->IFG & EUSCI_B_IFG_RXIFG))
+        ;
+    return EUSCI_B_CMSIS(EUSCI_B0_BASE)->RXBUF;
+}
+
+/*
+ * The byte transfers below have no way to report an error: with the bus
+ * taken they send nothing and return 0, and count it for SpiBusBusyDrops().
+ */
+static void bus_busy_drop(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bus_busy_drops++;
+    __set_PRIMASK(primask);
+}
 
 uint8_t SpiInOut_IQRadio(uint8_t outData) {
-    /* SPI send data */
+    if (!SpiBusLock())
+    {
+        bus_busy_drop();
+        return 0;
+    }
+    SPI_RXData_IQ = spi_xfer_polled(outData);
+    SpiBusUnlock();
+    return SPI_RXData_IQ;
+}
 
-	EUSCI_B_CMSIS(EUSCI_B0_BASE)->TXBUF = outData;
+uint8_t SpiInOut_LoRa(uint8_t outData) {
+    if (!SpiBusLock())
+    {
+        bus_busy_drop();
+        return 0;
+    }
+    SPI_RXData_LoRa = spi_xfer_polled(outData);
+    SpiBusUnlock();
+    return SPI_RXData_LoRa;
+}
 
-   __no_operation();
+uint8_t fpgaSpiInOut(uint8_t outData) {
+    if (!SpiBusLock())
+    {
+        bus_busy_drop();
+        return 0;
+    }
+    SPI_RXData_FPGA = spi_xfer_polled(outData);
+    SpiBusUnlock();
+    return SPI_RXData_FPGA;
+}
 
-   __enable_irq();
-   PCM_gotoLPM0();
-    return SPI_RXData_IQ;
+uint8_t flashSpiInOut(uint8_t outData) {
+    if (!SpiBusLock())
+    {
+        bus_busy_drop();
+        return 0;
+    }
+    SPI_RXData_Flash = spi_xfer_polled(outData);
+    SpiBusUnlock();
+    return SPI_RXData_Flash;
+}
+
+/* Next MOSI byte of the active job */
+static uint8_t job_tx_byte(const SpiJob_t *job)
+{
+    if (job->pos < job->hdr_len)
+    {
+        return job->hdr[job->pos];
+    }
+    return job->tx ? job->tx[job->pos - job->hdr_len] : 0x00;
+}
+
+/*
+ * Moves the next chunk of the data phase with the DMA. The RX channel is
+ * armed first, so no byte can be clocked before it is ready to be collected.
+ * TXIFG is already set, the TX channel starts as soon as it is enabled.
+ */
+static void job_dma_chunk(SpiJob_t *job)
+{
+    uint16_t done = job->pos - job->hdr_len;
+    uint16_t n = job->len - done;
+    if (n > SPI_DMA_MAX_XFER)
+    {
+        n = SPI_DMA_MAX_XFER;
+    }
+    dma_chunk = n;
+
+    if (job->rx)
+    {
+        DMA_setChannelControl(UDMA_PRI_SELECT | DMA_CH1_EUSCIB0RX0,
+                UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_8 | UDMA_ARB_1);
+        DMA_setChannelTransfer(UDMA_PRI_SELECT | DMA_CH1_EUSCIB0RX0,
+                UDMA_MODE_BASIC,
+                (void *) SPI_getReceiveBufferAddressForDMA(EUSCI_B0_BASE),
+                job->rx + done, n);
+    }
+    else
+    {
+        DMA_setChannelControl(UDMA_PRI_SELECT | DMA_CH1_EUSCIB0RX0,
+                UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_NONE | UDMA_ARB_1);
+        DMA_setChannelTransfer(UDMA_PRI_SELECT | DMA_CH1_EUSCIB0RX0,
+                UDMA_MODE_BASIC,
+                (void *) SPI_getReceiveBufferAddressForDMA(EUSCI_B0_BASE),
+                &dma_dummy_rx, n);
+    }
+
+    if (job->tx)
+    {
+        DMA_setChannelControl(UDMA_PRI_SELECT | DMA_CH0_EUSCIB0TX0,
+                UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE | UDMA_ARB_1);
+        DMA_setChannelTransfer(UDMA_PRI_SELECT | DMA_CH0_EUSCIB0TX0,
+                UDMA_MODE_BASIC, (void *) (job->tx + done),
+                (void *) SPI_getTransmitBufferAddressForDMA(EUSCI_B0_BASE), n);
+    }
+    else
+    {
+        DMA_setChannelControl(UDMA_PRI_SELECT | DMA_CH0_EUSCIB0TX0,
+                UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_NONE | UDMA_ARB_1);
+        DMA_setChannelTransfer(UDMA_PRI_SELECT | DMA_CH0_EUSCIB0TX0,
+                UDMA_MODE_BASIC, &dma_dummy_tx,
+                (void *) SPI_getTransmitBufferAddressForDMA(EUSCI_B0_BASE), n);
+    }
+
+    DMA_enableChannel(SPI_DMA_RX_CH);
+    DMA_enableChannel(SPI_DMA_TX_CH);
+}
+
+/* Clocks the first byte of a job, or hands a header-less job to the DMA */
+static void job_kick(SpiJob_t *job)
+{
+    if (job->hdr_len == 0 && job->len >= SPI_DMA_MIN_LEN)
+    {
+        job_dma_chunk(job);
+        return;
+    }
+    EUSCI_B_CMSIS(EUSCI_B0_BASE)->IE |= EUSCI_B_SPI_RECEIVE_INTERRUPT;
+    EUSCI_B_CMSIS(EUSCI_B0_BASE)->TXBUF = job_tx_byte(job);
+}
+
+/* Must be called with interrupts disabled */
+static void job_start_next(void)
+{
+    uint8_t p;
+    SpiJob_t *job = NULL;
+
+    if (job_active || bus_locked)
+    {
+        return;
+    }
+    for (p = 0; p < SPI_PRIO_NUM; p++)
+    {
+        job = job_head[p];
+        if (job)
+        {
+            job_head[p] = job->next;
+            if (!job_head[p])
+            {
+                job_tail[p] = NULL;
+            }
+            break;
+        }
+    }
+    if (!job)
+    {
+        return;
+    }
+
+    job->next = NULL;
+    job->pos = 0;
+    job->state = SPI_JOB_ACTIVE;
+    job_active = job;
+
+    GPIO_setOutputLowOnPin(job->cs_port, job->cs_pin);
+    job_kick(job);
+}
+
+/* Closes the CS window of the active job and starts the next one */
+static void job_finish(SpiJob_t *job)
+{
+    GPIO_setOutputHighOnPin(job->cs_port, job->cs_pin);
+    EUSCI_B_CMSIS(EUSCI_B0_BASE)->IE &= ~EUSCI_B_SPI_RECEIVE_INTERRUPT;
+    job_active = NULL;
+    job->state = SPI_JOB_DONE;
+    if (job->done)
+    {
+        job->done(job);
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    job_start_next();
+    __set_PRIMASK(primask);
+}
+
+/*
+ * Configures the NVIC so that the SPI engine preempts the radio IRQ line.
+ * Blocking transfers issued from the PORT2 ISR, or from the TA0 ones (see
+ * timebase_init()), wait for the active job to finish, which would never
+ * happen at equal or lower priority. PendSV runs the
+ * deferred bus work below everything else.
+ */
+void SpiJobInit(void)
+{
+    uint8_t p;
+    for (p = 0; p < SPI_PRIO_NUM; p++)
+    {
+        job_head[p] = NULL;
+        job_tail[p] = NULL;
+    }
+    job_active = NULL;
+    bus_locked = 0;
+    bus_owner = 0;
+    for (p = 0; p < SPI_BUS_DEFER_NUM; p++)
+    {
+        deferred_fn[p] = NULL;
+    }
+
+    EUSCI_B_CMSIS(EUSCI_B0_BASE)->IE &= ~EUSCI_B_SPI_RECEIVE_INTERRUPT;
+    Interrupt_setPriority(INT_EUSCIB0, 0x20);
+    Interrupt_setPriority(INT_DMA_INT1, 0x20);
+    Interrupt_setPriority(INT_PORT2, 0x40);
+    NVIC_SetPriority(PendSV_IRQn, (1 << __NVIC_PRIO_BITS) - 1);
+    Interrupt_enableInterrupt(INT_EUSCIB0);
+
+    /* Long data phases: CH0/CH1 on eUSCI_B0, RX completion on DMA_INT1 */
+    DMA_enableModule();
+    DMA_setControlBase(dma_ctl_table);
+    DMA_assignChannel(DMA_CH0_EUSCIB0TX0);
+    DMA_assignChannel(DMA_CH1_EUSCIB0RX0);
+    DMA_disableChannelAttribute(DMA_CH0_EUSCIB0TX0, UDMA_ATTR_ALL);
+    DMA_disableChannelAttribute(DMA_CH1_EUSCIB0RX0, UDMA_ATTR_ALL);
+    DMA_assignInterrupt(DMA_INT1, SPI_DMA_RX_CH);
+    DMA_clearInterruptFlag(SPI_DMA_RX_CH);
+    DMA_enableInterrupt(DMA_INT1);
+}
+
+/*
+ * Queues a job behind all the jobs of equal or higher priority. Safe to call
+ * from interrupt context. Returns false if the job is already in flight or
+ * has nothing to transfer.
+ */
+bool SpiJobSubmit(SpiJob_t *job)
+{
+    if (!job || (job->hdr_len + job->len) == 0 || job->hdr_len > sizeof(job->hdr)
+            || job->prio >= SPI_PRIO_NUM)
+    {
+        return false;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (job->state == SPI_JOB_QUEUED || job->state == SPI_JOB_ACTIVE)
+    {
+        __set_PRIMASK(primask);
+        return false;
+    }
+    job->next = NULL;
+    job->state = SPI_JOB_QUEUED;
+    if (job_tail[job->prio])
+    {
+        job_tail[job->prio]->next = job;
+    }
+    else
+    {
+        job_head[job->prio] = job;
+    }
+    job_tail[job->prio] = job;
+    job_start_next();
+    __set_PRIMASK(primask);
+    return true;
+}
+
+bool SpiJobBusy(void)
+{
+    uint8_t p;
+    if (job_active)
+    {
+        return true;
+    }
+    for (p = 0; p < SPI_PRIO_NUM; p++)
+    {
+        if (job_head[p])
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Takes the bus for a blocking, caller-framed transfer. Waits for the job in
+ * flight (queued jobs stay queued) and can be nested by the holder. The bus
+ * is exclusive to one context: an interrupt that preempted another holder
+ * gets false and must not touch the bus, it may SpiBusDefer() its work.
+ * From thread mode the bus is never held by anyone else, so it never fails.
+ */
+bool SpiBusLock(void)
+{
+    const uint32_t self = __get_IPSR();
+    for (;;)
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        if (bus_locked && bus_owner != self)
+        {
+            __set_PRIMASK(primask);
+            return false;
+        }
+        if (!job_active)
+        {
+            bus_locked++;
+            bus_owner = self;
+            EUSCI_B_CMSIS(EUSCI_B0_BASE)->IE &= ~EUSCI_B_SPI_RECEIVE_INTERRUPT;
+            __set_PRIMASK(primask);
+            return true;
+        }
+        __set_PRIMASK(primask);
+    }
+}
+
+/* Byte transfers dropped so far by SpiInOut_IQRadio() and friends */
+uint32_t SpiBusBusyDrops(void)
+{
+    return bus_busy_drops;
+}
+
+/* Releasing the last level hands the bus to the queued jobs and deferred work */
+void SpiBusUnlock(void)
+{
+    uint8_t i;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (bus_locked)
+    {
+        bus_locked--;
+    }
+    if (!bus_locked)
+    {
+        for (i = 0; i < SPI_BUS_DEFER_NUM; i++)
+        {
+            if (deferred_fn[i])
+            {
+                SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+                break;
+            }
+        }
+    }
+    job_start_next();
+    __set_PRIMASK(primask);
+}
+
+/*
+ * Runs fn(arg) from PendSV once the bus holder lets it go. For the interrupts
+ * that got false from SpiBusLock(); a fn already pending is not queued twice.
+ * Returns false if all the slots are taken.
+ */
+bool SpiBusDefer(SpiBusDeferred_t fn, void *arg)
+{
+    uint8_t i;
+    bool ret = false;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (i = 0; i < SPI_BUS_DEFER_NUM && !ret; i++)
+    {
+        if (deferred_fn[i] == fn)
+        {
+            ret = true;
+        }
+    }
+    for (i = 0; i < SPI_BUS_DEFER_NUM && !ret; i++)
+    {
+        if (!deferred_fn[i])
+        {
+            deferred_fn[i] = fn;
+            deferred_arg[i] = arg;
+            ret = true;
+        }
+    }
+    if (ret && !bus_locked)
+    {
+        SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    }
+    __set_PRIMASK(primask);
+    return ret;
 }
 
+/* Lowest priority: whoever held the bus has returned by now */
+void PendSV_Handler(void)
+{
+    uint8_t i;
+    for (i = 0; i < SPI_BUS_DEFER_NUM; i++)
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        const SpiBusDeferred_t fn = deferred_fn[i];
+        void *arg = deferred_arg[i];
+        deferred_fn[i] = NULL;
+        __set_PRIMASK(primask);
+        if (fn)
+        {
+            fn(arg);
+        }
+    }
+}
+
+
 
+//******************************************************************************
+//
+//DMA_INT1 fires when the RX channel has collected a whole chunk, i.e. when
+//the last byte of the chunk has been clocked.
+//
+//******************************************************************************
+void DMA_INT1_IRQHandler(void)
+{
+    SpiJob_t *job = job_active;
 
+    DMA_clearInterruptFlag(SPI_DMA_RX_CH);
+    if (!job)
+    {
+        return;
+    }
 
+    job->pos += dma_chunk;
+    if (job->pos < job->hdr_len + job->len)
+    {
+        job_dma_chunk(job);
+        return;
+    }
+    job_finish(job);
+}
 
 //******************************************************************************
 //
-//This is the EUSCI_B0 interrupt vector service routine.
+//This is the EUSCI_B0 interrupt vector service routine. Every received byte
+//advances the active job by one, so TXBUF is always empty at this point.
 //
 //******************************************************************************
 void EUSCIB0_IRQHandler(void)
 {
-    uint32_t status = EUSCI_B_CMSIS(EUSCI_B0_BASE)->IFG &
-            ((EUSCI_SPI_TRANSMIT_INTERRUPT | EUSCI_SPI_RECEIVE_INTERRUPT)
-                    & EUSCI_B_CMSIS(EUSCI_B0_BASE)->IE);
+    SpiJob_t *job = job_active;
 
-    EUSCI_B_CMSIS(EUSCI_B0_BASE)->IFG &= ~status;
+    if (!job)
+    {
+        /* Blocking transfers poll RXIFG themselves */
+        EUSCI_B_CMSIS(EUSCI_B0_BASE)->IE &= ~EUSCI_B_SPI_RECEIVE_INTERRUPT;
+        return;
+    }
 
-    while(!(EUSCI_B_CMSIS(EUSCI_B0_BASE)->IFG & EUSCI_B_SPI_TRANSMIT_INTERRUPT));
+    uint8_t data = EUSCI_B_CMSIS(EUSCI_B0_BASE)->RXBUF;
+    if (job->pos >= job->hdr_len && job->rx)
+    {
+        job->rx[job->pos - job->hdr_len] = data;
+    }
+    job->pos++;
 
-    SPI_RXData_IQ = EUSCI_B_CMSIS(EUSCI_B0_BASE)->RXBUF;
+    if (job->pos == job->hdr_len && job->len >= SPI_DMA_MIN_LEN)
+    {
+        /* Header is out, the DMA takes over the data phase */
+        EUSCI_B_CMSIS(EUSCI_B0_BASE)->IE &= ~EUSCI_B_SPI_RECEIVE_INTERRUPT;
+        job_dma_chunk(job);
+        return;
+    }
+    if (job->pos < job->hdr_len + job->len)
+    {
+        EUSCI_B_CMSIS(EUSCI_B0_BASE)->TXBUF = job_tx_byte(job);
+        return;
+    }
 
-    /* exit from LPM0 */
-    SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+    job_finish(job);
 }
 
 
+uint32_t cycle_counter_mhz = CYCLES_us;
+
+/* Should be called once the clock system is set up */
+void cycle_counter_init(void)
+{
+    const uint32_t mhz = CS_getMCLK() / 1000000;
+    cycle_counter_mhz = mhz ? mhz : 1;
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
 void delay_ms(uint32_t msTime)
 {
     //    unsigned long cycles;
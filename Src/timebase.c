@@ -0,0 +1,298 @@
+/*
+ * timebase.c
+ *
+ * Timer_A0 timebase and compare alarm
+ */
+#include <timebase.h>
+#include <msp.h>
+#include <driverlib.h>
+
+/* TA0IV value of the counter overflow */
+#define TA0IV_OVERFLOW      0x0E
+
+static volatile uint16_t overflows = 0;
+static uint32_t hz = 0;
+
+/* Compare callbacks, CCR0 is the alarm */
+static volatile timebase_alarm_cb_t compare_cb[TIMEBASE_CCR_NUM];
+static void *compare_arg[TIMEBASE_CCR_NUM];
+static uint32_t compare_at[TIMEBASE_CCR_NUM];
+
+/* Millisecond clock, carried over at every overflow so no wrap is missed */
+static uint32_t ms_last = 0;
+static uint32_t ms_rem = 0;
+static uint32_t ms_count = 0;
+
+static timebase_capture_cb_t capture_cb[TIMEBASE_CCR_NUM];
+static void *capture_arg[TIMEBASE_CCR_NUM];
+
+/*
+ * Starts Timer_A0 in continuous mode from SMCLK. The overflow IRQ keeps the
+ * upper half of the timebase, so it should not be held off for longer than
+ * a full 16-bit period. The capture callbacks issue blocking SPI transfers,
+ * so both vectors sit below the SPI engine (0x20), with the radio IRQ line
+ * (see SpiJobInit()).
+ */
+void timebase_init(void)
+{
+    uint8_t i;
+    hz = CS_getSMCLK();
+
+    TIMER_A0->CTL = TIMER_A_CTL_CLR;
+    for (i = 0; i < TIMEBASE_CCR_NUM; i++)
+    {
+        TIMER_A0->CCTL[i] = 0;
+        compare_cb[i] = NULL;
+        capture_cb[i] = NULL;
+    }
+    overflows = 0;
+    ms_last = 0;
+    ms_rem = 0;
+    ms_count = 0;
+    TIMER_A0->CTL = TIMER_A_CTL_SSEL__SMCLK | TIMER_A_CTL_ID__1
+            | TIMER_A_CTL_MC__CONTINUOUS | TIMER_A_CTL_IE;
+
+    Interrupt_setPriority(INT_TA0_0, 0x40);
+    Interrupt_setPriority(INT_TA0_N, 0x40);
+    Interrupt_enableInterrupt(INT_TA0_0);
+    Interrupt_enableInterrupt(INT_TA0_N);
+}
+
+/* The current timebase value. Safe from interrupt context */
+uint32_t timebase_now(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint16_t hi = overflows;
+    uint16_t lo = TIMER_A0->R;
+    /* An overflow not served yet: only count it if lo was read after it */
+    if ((TIMER_A0->CTL & TIMER_A_CTL_IFG) && lo < 0x8000)
+    {
+        hi++;
+    }
+    __set_PRIMASK(primask);
+    return ((uint32_t) hi << 16) | lo;
+}
+
+/* Must be called with interrupts disabled */
+static void ms_update(uint32_t now)
+{
+    const uint32_t per_ms = hz / 1000;
+    if (!per_ms)
+    {
+        return;
+    }
+    ms_rem += now - ms_last;
+    ms_last = now;
+    ms_count += ms_rem / per_ms;
+    ms_rem %= per_ms;
+}
+
+/*
+ * Milliseconds since timebase_init(), wrapping at 32 bits like a plain
+ * counter. Safe from interrupt context
+ */
+uint32_t timebase_ms(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ms_update(timebase_now());
+    const uint32_t ms = ms_count;
+    __set_PRIMASK(primask);
+    return ms;
+}
+
+/* Ticks per second */
+uint32_t timebase_hz(void)
+{
+    return hz;
+}
+
+uint32_t timebase_us_to_ticks(uint32_t us)
+{
+    return ((uint64_t) us * hz) / 1000000;
+}
+
+uint32_t timebase_ticks_to_us(uint32_t ticks)
+{
+    return ((uint64_t) ticks * 1000000) / hz;
+}
+
+static bool compare_arm(uint8_t ccr, uint32_t at, timebase_alarm_cb_t cb,
+                        void *arg)
+{
+    bool ok = true;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    compare_at[ccr] = at;
+    compare_arg[ccr] = arg;
+    compare_cb[ccr] = cb;
+    capture_cb[ccr] = NULL;
+    TIMER_A0->CCR[ccr] = at & 0xFFFF;
+    TIMER_A0->CCTL[ccr] = TIMER_A_CCTLN_CCIE;
+    /*
+     * The compare only fires on the match: if at passed before CCRn was
+     * written, nothing would happen until the counter wraps
+     */
+    if (timebase_diff(timebase_now(), at) >= 0
+            && !(TIMER_A0->CCTL[ccr] & TIMER_A_CCTLN_CCIFG))
+    {
+        TIMER_A0->CCTL[ccr] = 0;
+        compare_cb[ccr] = NULL;
+        ok = false;
+    }
+    __set_PRIMASK(primask);
+    return ok;
+}
+
+static void compare_cancel(uint8_t ccr)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    TIMER_A0->CCTL[ccr] = 0;
+    compare_cb[ccr] = NULL;
+    __set_PRIMASK(primask);
+}
+
+/* CCRn matches once per 16-bit period, the upper half decides */
+static void compare_match(uint8_t ccr)
+{
+    const uint32_t now = timebase_now();
+    TIMER_A0->CCTL[ccr] &= ~TIMER_A_CCTLN_CCIFG;
+    if (!compare_cb[ccr] || timebase_diff(now, compare_at[ccr]) < 0)
+    {
+        return;
+    }
+    const timebase_alarm_cb_t cb = compare_cb[ccr];
+    compare_cb[ccr] = NULL;
+    TIMER_A0->CCTL[ccr] = 0;
+    /* The callback may arm the next compare */
+    cb(now, compare_arg[ccr]);
+}
+
+/*
+ * Calls cb from the TA0_0 ISR once the timebase reaches at. Replaces a
+ * pending alarm. Returns false, without arming anything, if at has already
+ * passed.
+ */
+bool timebase_alarm_set(uint32_t at, timebase_alarm_cb_t cb, void *arg)
+{
+    return compare_arm(0, at, cb, arg);
+}
+
+void timebase_alarm_cancel(void)
+{
+    compare_cancel(0);
+}
+
+/*
+ * Same as the alarm on CCR1..4, from the TA0_N ISR, for the clients that
+ * must not share CCR0. Replaces a capture or compare set up on ccr.
+ * Returns false, without arming anything, for CCR0 or if at has already
+ * passed.
+ */
+bool timebase_compare_set(uint8_t ccr, uint32_t at, timebase_alarm_cb_t cb,
+                          void *arg)
+{
+    if (ccr == 0 || ccr >= TIMEBASE_CCR_NUM)
+    {
+        return false;
+    }
+    return compare_arm(ccr, at, cb, arg);
+}
+
+void timebase_compare_cancel(uint8_t ccr)
+{
+    if (ccr == 0 || ccr >= TIMEBASE_CCR_NUM)
+    {
+        return;
+    }
+    compare_cancel(ccr);
+}
+
+/*
+ * Sets up CCRn to capture the rising edges of its CCInA input, synchronized
+ * to the timer clock, and calls cb for each of them once enabled with
+ * timebase_capture_enable(). The pin should be routed to the input by the
+ * caller. Returns false for CCR0, which is the alarm.
+ */
+bool timebase_capture_set(uint8_t ccr, timebase_capture_cb_t cb, void *arg)
+{
+    if (ccr == 0 || ccr >= TIMEBASE_CCR_NUM)
+    {
+        return false;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    compare_cb[ccr] = NULL;
+    capture_cb[ccr] = cb;
+    capture_arg[ccr] = arg;
+    TIMER_A0->CCTL[ccr] = TIMER_A_CCTLN_CM__RISING | TIMER_A_CCTLN_CCIS__CCIA
+            | TIMER_A_CCTLN_SCS | TIMER_A_CCTLN_CAP;
+    __set_PRIMASK(primask);
+    return true;
+}
+
+/*
+ * Masks or unmasks the capture IRQ. An edge captured while masked stays
+ * pending and is delivered once unmasked.
+ */
+void timebase_capture_enable(uint8_t ccr, bool enable)
+{
+    if (ccr == 0 || ccr >= TIMEBASE_CCR_NUM)
+    {
+        return;
+    }
+    if (enable)
+    {
+        TIMER_A0->CCTL[ccr] |= TIMER_A_CCTLN_CCIE;
+    }
+    else
+    {
+        TIMER_A0->CCTL[ccr] &= ~TIMER_A_CCTLN_CCIE;
+    }
+}
+
+/* Puts the upper half to a capture, taken less than a 16-bit period ago */
+static uint32_t extend(uint16_t lo)
+{
+    const uint32_t now = timebase_now();
+    uint32_t ts = (now & 0xFFFF0000) | lo;
+    if (timebase_diff(ts, now) > 0)
+    {
+        ts -= 0x10000;
+    }
+    return ts;
+}
+
+void TA0_0_IRQHandler(void)
+{
+    compare_match(0);
+}
+
+/* Reading TA0IV acknowledges the highest pending source, CCR1 first */
+void TA0_N_IRQHandler(void)
+{
+    const uint16_t iv = TIMER_A0->IV;
+    if (iv == TA0IV_OVERFLOW)
+    {
+        overflows++;
+        ms_update(timebase_now());
+        return;
+    }
+    const uint8_t ccr = iv >> 1;
+    if (ccr == 0 || ccr >= TIMEBASE_CCR_NUM)
+    {
+        return;
+    }
+    if (!(TIMER_A0->CCTL[ccr] & TIMER_A_CCTLN_CAP))
+    {
+        compare_match(ccr);
+        return;
+    }
+    const uint32_t ts = extend(TIMER_A0->CCR[ccr]);
+    if (capture_cb[ccr])
+    {
+        capture_cb[ccr](ts, capture_arg[ccr]);
+    }
+}
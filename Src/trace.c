@@ -0,0 +1,60 @@
+/*
+ * trace.c
+ *
+ * Binary trace ring
+ */
+#include <trace.h>
+#include <string.h>
+
+struct trace_ring trace_ring;
+
+/*
+ * Clears the ring and starts recording. The cycle counter should already
+ * run, see cycle_counter_init().
+ */
+void trace_init(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(&trace_ring, 0, sizeof(trace_ring));
+    trace_ring.magic = TRACE_MAGIC;
+    trace_ring.len = TRACE_LEN;
+    trace_ring.cycles_per_us = cycle_counter_mhz;
+    trace_ring.enabled = TRACE_ENABLE;
+    __set_PRIMASK(primask);
+}
+
+/* Pauses or resumes recording, e.g. to freeze the ring after a failure */
+void trace_enable(bool enable)
+{
+    trace_ring.enabled = enable && TRACE_ENABLE;
+}
+
+/*
+ * Copies up to max of the most recent records, oldest first. Interrupts are
+ * held off during the copy, so no record changes under it; a record whose
+ * writer got preempted by the caller may still be incomplete.
+ * Returns the number of records copied.
+ */
+size_t trace_copy(struct trace_rec *out, size_t max)
+{
+    size_t i, n;
+    if (!out)
+    {
+        return 0;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const uint32_t head = trace_ring.head;
+    n = head < TRACE_LEN ? head : TRACE_LEN;
+    if (n > max)
+    {
+        n = max;
+    }
+    for (i = 0; i < n; i++)
+    {
+        out[i] = trace_ring.rec[(head - n + i) & (TRACE_LEN - 1)];
+    }
+    __set_PRIMASK(primask);
+    return n;
+}
@@ -0,0 +1,175 @@
+/*
+ * tx_timed.c
+ *
+ * Scheduled transmission: TXPREP and TX commands from timebase alarms
+ */
+#include <tx_timed.h>
+#include <timebase.h>
+#include <regs.h>
+#include <spi_helper.h>
+
+typedef enum
+{
+    STEP_IDLE = 0,
+    STEP_PREP,      /* waiting for the TXPREP alarm */
+    STEP_TX,        /* in TXPREP, waiting for the slot */
+    STEP_DONE       /* report ready */
+} step_t;
+
+static volatile step_t step = STEP_IDLE;
+static struct at86rf215 *dev = NULL;
+static at86rf215_radio_t dev_radio = AT86RF215_RF09;
+static struct tx_timed_report report;
+
+/* RFn_CMD writes, one job per command since TX may queue behind TXPREP */
+static const uint8_t cmd_txprep = AT86RF215_CMD_RF_TXPREP;
+static const uint8_t cmd_tx = AT86RF215_CMD_RF_TX;
+static SpiJob_t prep_job;
+static SpiJob_t tx_job;
+
+/* Queues the write of cmd to the RFn_CMD register of the radio */
+static int cmd_submit(SpiJob_t *job, const uint8_t *cmd, SpiJobCallback_t done)
+{
+    const uint16_t reg = dev_radio == AT86RF215_RF09 ? REG_RF09_CMD : REG_RF24_CMD;
+    job->client = SPI_CLIENT_IQRADIO;
+    job->prio = SPI_PRIO_IRQ;
+    job->cs_port = GPIO_PORT_P3; /* same SELN as at86rf215_set_seln() */
+    job->cs_pin = GPIO_PIN0;
+    job->hdr[0] = 0x80 | ((reg >> 8) & 0x3F);
+    job->hdr[1] = reg & 0xFF;
+    job->hdr_len = 2;
+    job->tx = cmd;
+    job->rx = NULL;
+    job->len = 1;
+    job->done = done;
+    job->arg = NULL;
+    return SpiJobSubmit(job) ? AT86RF215_OK : -AT86RF215_BUS_BUSY;
+}
+
+/* From the EUSCIB0 ISR, the TX command is on the radio */
+static void tx_done(SpiJob_t *job)
+{
+    (void) job;
+    if (step != STEP_TX)
+    {
+        /* Cancelled while queued */
+        return;
+    }
+    report.achieved = timebase_now();
+    report.error_ticks = timebase_diff(report.achieved, report.requested);
+    step = STEP_DONE;
+}
+
+static void tx_alarm(uint32_t now, void *arg)
+{
+    (void) arg;
+    report.fired = now;
+    /* Set by the driver on TRXRDY, if that IRQ is enabled */
+    report.trxrdy = dev->priv.radios[dev_radio].trxready;
+    report.status = cmd_submit(&tx_job, &cmd_tx, tx_done);
+    if (report.status)
+    {
+        report.achieved = now;
+        step = STEP_DONE;
+    }
+}
+
+static void prep_alarm(uint32_t now, void *arg)
+{
+    (void) arg;
+    dev->priv.radios[dev_radio].trxready = 0;
+    report.status = cmd_submit(&prep_job, &cmd_txprep, NULL);
+    if (report.status)
+    {
+        /* Without TXPREP, TX at the slot would start from TRXOFF or RX */
+        report.fired = now;
+        report.achieved = now;
+        step = STEP_DONE;
+        return;
+    }
+    step = STEP_TX;
+    if (!timebase_alarm_set(report.requested, tx_alarm, NULL))
+    {
+        /* Already late, start right away and let the report tell */
+        tx_alarm(timebase_now(), NULL);
+    }
+}
+
+/*
+ * Uploads the frame and schedules its transmission at the timebase tick at.
+ * Returns -AT86RF215_TIMEOUT if at is too close to fit the TXPREP
+ * transition, or another negative error code of the upload. Only one frame
+ * can be scheduled at a time.
+ */
+int tx_timed_at(struct at86rf215 *h, at86rf215_radio_t radio,
+                const uint8_t *psdu, size_t len, uint32_t at)
+{
+    if (!h)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    if (step == STEP_PREP || step == STEP_TX)
+    {
+        return -AT86RF215_INVAL_CONF;
+    }
+    int ret = at86rf215_tx_preload(h, radio, psdu, len);
+    if (ret)
+    {
+        return ret;
+    }
+
+    const uint32_t prep_at = at - timebase_us_to_ticks(TX_TIMED_TXPREP_US);
+    const uint32_t earliest = timebase_now()
+            + timebase_us_to_ticks(TX_TIMED_MARGIN_US);
+    if (timebase_diff(prep_at, earliest) < 0)
+    {
+        return -AT86RF215_TIMEOUT;
+    }
+
+    dev = h;
+    dev_radio = radio;
+    report.requested = at;
+    report.fired = 0;
+    report.achieved = 0;
+    report.error_ticks = 0;
+    report.trxrdy = 0;
+    report.status = AT86RF215_OK;
+    step = STEP_PREP;
+    if (!timebase_alarm_set(prep_at, prep_alarm, NULL))
+    {
+        step = STEP_IDLE;
+        return -AT86RF215_TIMEOUT;
+    }
+    return AT86RF215_OK;
+}
+
+/* True from tx_timed_at() until the TX command has been issued */
+bool tx_timed_pending(void)
+{
+    return step == STEP_PREP || step == STEP_TX;
+}
+
+/*
+ * Requested against achieved start of the last scheduled frame. Returns
+ * false while it is pending or when it has already been collected.
+ */
+bool tx_timed_report(struct tx_timed_report *out)
+{
+    if (step != STEP_DONE)
+    {
+        return false;
+    }
+    if (out)
+    {
+        *out = report;
+    }
+    step = STEP_IDLE;
+    return true;
+}
+
+/* Drops the scheduled frame. The radio may be left in TXPREP */
+void tx_timed_cancel(void)
+{
+    timebase_alarm_cancel();
+    step = STEP_IDLE;
+}
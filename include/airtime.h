@@ -0,0 +1,43 @@
+/*
+ * airtime.h
+ *
+ * On-air time and goodput of a frame for a baseband configuration. Only
+ * depends on the configuration structures and has no device access, so it
+ * also builds on the host, e.g. for tools/airtime_calc.cpp.
+ */
+#ifndef AIRTIME_H
+#define AIRTIME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <at86rf215.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct airtime
+{
+    uint32_t sym_rate_hz;   /* symbols per second */
+    uint32_t shr_sym;       /* preamble and SFD */
+    uint32_t data_sym;      /* PHR and PSDU, FEC tail and pad included */
+    uint32_t data_bits;     /* PHR and PSDU bits on air, after FEC */
+    uint32_t us;            /* start of the preamble to the last symbol */
+};
+
+int airtime_frame(const struct at86rf215_bb_conf *conf, size_t len,
+                  struct airtime *a);
+
+int airtime_frame_us(const struct at86rf215_bb_conf *conf, size_t len,
+                     uint32_t *us);
+
+size_t airtime_fcs_len(const struct at86rf215_bb_conf *conf);
+
+int airtime_goodput_bps(const struct at86rf215_bb_conf *conf, size_t payload,
+                        uint32_t gap_us, uint32_t *bps);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AIRTIME_H */
@@ -0,0 +1,135 @@
+/*
+ * arq.h
+ *
+ * Selective-repeat ARQ between two nodes on one radio. Data frames carry an
+ * 8-bit sequence number, every data frame received is answered with an ACK
+ * holding the next in-order sequence number expected and a bitmap of the
+ * frames received beyond it. The sender only repeats the frames missing
+ * from the bitmap, so a loss costs one frame, not the rest of the window.
+ *
+ * The ACK is uploaded right after the data frame is collected and sent from
+ * RX with no TXPREP wait. BBCn_AMCS.TX2RX brings the radio back to RX after
+ * each frame. Retransmission deadlines are kept on the timebase (timebase.h)
+ * and derived from the airtime of the frame and of its ACK.
+ *
+ * While running, the ARQ layer is the only consumer of the RX pipeline.
+ * Everything runs from arq_poll(), nothing from interrupt context.
+ *
+ * Frame layout, FCS excluded:
+ *   DATA: ARQ_TYPE_DATA, seq, payload
+ *   ACK:  ARQ_TYPE_ACK, next expected seq, 32-bit bitmap LSB first, bit i
+ *         set if seq next + 1 + i was received
+ */
+#ifndef ARQ_H
+#define ARQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <at86rf215.h>
+#include <frame_pool.h>
+
+/* Frames in flight. At most 32, the size of the ACK bitmap plus one */
+#ifndef ARQ_WINDOW
+#define ARQ_WINDOW              16
+#endif
+
+/*
+ * Frame pool blocks able to take a full frame that the receiver leaves to
+ * the RX pipeline. Frames received out of order pin their block until the
+ * gap is filled; one that would eat into this reserve is not kept, the
+ * sender repeats it. Without the reserve, a window of large frames could
+ * exhaust the pool and the missing frame itself could not be received.
+ */
+#ifndef ARQ_RX_RESERVE
+#define ARQ_RX_RESERVE          1
+#endif
+
+/* Transmissions of a frame before the link is declared lost */
+#ifndef ARQ_MAX_TRIES
+#define ARQ_MAX_TRIES           8
+#endif
+
+/*
+ * Added to the airtime of a frame and of its ACK for the retransmission
+ * timeout. Covers the RX to TX turnaround and the arq_poll() latency of
+ * the peer.
+ */
+#ifndef ARQ_ACK_SLACK_US
+#define ARQ_ACK_SLACK_US        2000
+#endif
+
+#define ARQ_TYPE_DATA           0xD1
+#define ARQ_TYPE_ACK            0xA2
+#define ARQ_DATA_HDR            2
+#define ARQ_ACK_LEN             6
+
+struct arq;
+
+/* Called from arq_poll() with the payloads, in sequence order */
+typedef void (*arq_deliver_cb_t)(struct arq *a, const uint8_t *data,
+                                 size_t len, void *arg);
+
+struct arq_stats
+{
+    uint32_t sent;          /* data frames transmitted, repeats included */
+    uint32_t retries;       /* repeats */
+    uint32_t fast_retries;  /* repeats before the timeout, as a later frame
+                               was acknowledged */
+    uint32_t acked;         /* frames confirmed by the peer */
+    uint32_t acks_sent;
+    uint32_t acks_rcvd;
+    uint32_t delivered;     /* payloads handed to the application */
+    uint32_t dups;          /* data frames already received */
+    uint32_t not_held;      /* out of order frames not kept, pool low */
+    uint32_t dropped;       /* bad FCS, foreign or malformed frames */
+    uint32_t tx_timeouts;   /* transmissions without TXFE in time, radio
+                               put back in RX */
+};
+
+struct arq_slot
+{
+    struct frame_buf *buf;  /* PSDU, ARQ header and room for the FCS */
+    uint32_t sent;          /* timebase at the last transmission */
+    uint32_t due;           /* timebase of the next retransmission */
+    uint32_t airtime_us;
+    uint8_t  tries;
+    uint8_t  acked;
+    uint8_t  fast;          /* due early, a later frame was acknowledged */
+};
+
+struct arq
+{
+    struct at86rf215   *h;
+    at86rf215_radio_t   radio;
+    arq_deliver_cb_t    deliver;
+    void               *arg;
+    /* Private */
+    uint8_t             snd_base;   /* oldest frame not acknowledged */
+    uint8_t             snd_next;   /* sequence of the next new frame */
+    struct arq_slot     snd[ARQ_WINDOW];
+    uint8_t             rcv_base;   /* next in-order sequence expected */
+    struct frame_buf   *rcv[ARQ_WINDOW];
+    uint16_t            rcv_len[ARQ_WINDOW];
+    uint8_t             ack_pending;
+    uint8_t             tx_busy;
+    uint32_t            tx_t0;
+    uint32_t            tx_limit;   /* ticks, bound of the frame on air */
+    uint32_t            ack_us;     /* airtime of an ACK */
+    struct arq_stats    stats;
+};
+
+int arq_init(struct arq *a, struct at86rf215 *h, at86rf215_radio_t radio,
+             arq_deliver_cb_t deliver, void *arg);
+
+void arq_reset(struct arq *a);
+
+int arq_send(struct arq *a, const uint8_t *data, size_t len);
+
+size_t arq_window_free(const struct arq *a);
+
+int arq_poll(struct arq *a);
+
+void arq_get_stats(const struct arq *a, struct arq_stats *stats);
+
+#endif /* ARQ_H */
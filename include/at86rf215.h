@@ -22,8 +22,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
-#include <msp432p401r.h>
-#include <driverlib.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,6 +33,96 @@ extern "C" {
  */
 #define AT86RF215_MAX_PDU (2047)
 
+/**
+ * Set to 1 to fetch the four IRQ status registers with a single SPI burst.
+ * Set to 0 to fall back to one transaction per register.
+ */
+#ifndef AT86RF215_IRQ_BURST
+#define AT86RF215_IRQ_BURST (1)
+#endif
+
+/**
+ * Set to 1 to keep a histogram of the IRQ pin to handler latency
+ */
+#ifndef AT86RF215_IRQ_STATS
+#define AT86RF215_IRQ_STATS (1)
+#endif
+
+/**
+ * Number of log2 microsecond bins of the IRQ latency histogram
+ */
+#define AT86RF215_IRQ_HIST_BINS (16)
+
+/**
+ * Energy bins of the per-channel scan histogram. Bin 0 collects everything
+ * below AT86RF215_SCAN_HIST_MIN dBm, each bin covers
+ * AT86RF215_SCAN_HIST_STEP dB and the last one saturates
+ */
+#define AT86RF215_SCAN_HIST_BINS (8)
+#define AT86RF215_SCAN_HIST_MIN  (-100)
+#define AT86RF215_SCAN_HIST_STEP (10)
+
+/**
+ * RFn_EDD value for a measurement of df x dtb, dtb being one of
+ * 0 (2 us), 1 (8 us), 2 (32 us), 3 (128 us)
+ */
+#define AT86RF215_EDD(df, dtb) ((((df) & 0x3F) << 2) | ((dtb) & 0x3))
+
+/**
+ * Channels per radio remembered by the AGC gain cache
+ */
+#ifndef AT86RF215_AGC_CACHE_SIZE
+#define AT86RF215_AGC_CACHE_SIZE (16)
+#endif
+
+/**
+ * Number of frames the RX pipeline can hold until the application collects
+ * them. Should be a power of 2 and at most 32. The frame data live in the
+ * frame pool (frame_pool.h)
+ */
+#ifndef AT86RF215_RX_QUEUE_LEN
+#define AT86RF215_RX_QUEUE_LEN (4)
+#endif
+
+/**
+ * Largest SPI job of the frame buffer upload. A job is not preempted, so
+ * this bounds how long an IRQ status read waits behind the upload: 64
+ * bytes take about 1 ms at a 500 kHz SPI clock
+ */
+#ifndef AT86RF215_RX_UPLOAD_CHUNK
+#define AT86RF215_RX_UPLOAD_CHUNK (64)
+#endif
+
+/**
+ * RSTN low time of at86rf215_init(). The datasheet minimum is 625 ns
+ */
+#ifndef AT86RF215_RSTN_PULSE_US
+#define AT86RF215_RSTN_PULSE_US (1)
+#endif
+
+/**
+ * Upper bound of the reset to wake-up IRQ time, after which
+ * at86rf215_init() gives up
+ */
+#ifndef AT86RF215_WAKEUP_TIMEOUT_US
+#define AT86RF215_WAKEUP_TIMEOUT_US (1000)
+#endif
+
+/**
+ * Longest run of contiguous registers at86rf215_reg_image_apply() writes
+ * with a single burst
+ */
+#define AT86RF215_REG_IMAGE_RUN (32)
+
+/**
+ * Set to 1 for AT86RF215TxSetIQ() to enable the embedded control, so the
+ * FPGA keys the transmitter through the LSB of the I word.
+ * @see at86rf215_set_iq_eec()
+ */
+#ifndef AT86RF215_IQ_EEC
+#define AT86RF215_IQ_EEC (0)
+#endif
+
 
 
 /* AT86RF215 definitions */
@@ -58,7 +147,10 @@ typedef enum
   AT86RF215_INVAL_CONF,    //!< The requested configuration is invalid
   AT86RF215_INVAL_CHPM,    //!< Invalid chip mode for the requested operation
   AT86RF215_TIMEOUT,       //!< A timeout event occured
-  AT86RF215_PLL_UNLOCK     //!< The PLL lock error occured
+  AT86RF215_PLL_UNLOCK,    //!< The PLL lock error occured
+  AT86RF215_NO_DATA,       //!< There is no data available
+  AT86RF215_CHANNEL_BUSY,  //!< The clear channel assessment failed
+  AT86RF215_BUS_BUSY       //!< The SPI bus is held by a preempted context
 } at86rf215_error_t;
 
 /**
@@ -80,6 +172,47 @@ typedef enum
   AT86RF215_RF24 = 1, //!< 2.4 GHz radio
 } at86rf215_radio_t;
 
+/**
+ * IRQ status sources. The order matches the contiguous IRQS registers
+ * (0x00 - 0x03), so the value is also the offset of the status register
+ */
+typedef enum
+{
+  AT86RF215_IRQ_SRC_RF09 = 0, //!< RF09_IRQS
+  AT86RF215_IRQ_SRC_RF24 = 1, //!< RF24_IRQS
+  AT86RF215_IRQ_SRC_BBC0 = 2, //!< BBC0_IRQS
+  AT86RF215_IRQ_SRC_BBC1 = 3, //!< BBC1_IRQS
+  AT86RF215_IRQ_SRC_NUM  = 4
+} at86rf215_irq_src_t;
+
+/**
+ * Bits of the RFn_IRQS registers
+ */
+typedef enum
+{
+  AT86RF215_RF_IRQ_WAKEUP = 0, //!< Wake-up / Reset completed
+  AT86RF215_RF_IRQ_TRXRDY = 1, //!< Transceiver ready
+  AT86RF215_RF_IRQ_EDC    = 2, //!< Energy detection completion
+  AT86RF215_RF_IRQ_BATLOW = 3, //!< Battery low
+  AT86RF215_RF_IRQ_TRXERR = 4, //!< Transceiver error
+  AT86RF215_RF_IRQ_IQIFSF = 5  //!< I/Q interface synchronization failure
+} at86rf215_rf_irq_t;
+
+/**
+ * Bits of the BBCn_IRQS registers
+ */
+typedef enum
+{
+  AT86RF215_BB_IRQ_RXFS = 0, //!< Receiver frame start
+  AT86RF215_BB_IRQ_RXFE = 1, //!< Receiver frame end
+  AT86RF215_BB_IRQ_RXAM = 2, //!< Receiver address match
+  AT86RF215_BB_IRQ_RXEM = 3, //!< Receiver extended match
+  AT86RF215_BB_IRQ_TXFE = 4, //!< Transmitter frame end
+  AT86RF215_BB_IRQ_AGCH = 5, //!< AGC hold
+  AT86RF215_BB_IRQ_AGCR = 6, //!< AGC release
+  AT86RF215_BB_IRQ_FBLI = 7  //!< Frame buffer level indication
+} at86rf215_bb_irq_t;
+
 /**
  * CLKO pad driver strength
  */
@@ -597,6 +730,40 @@ struct at86rf215_aux_conf
   uint8_t pavc   : 2;    /**< Power Amplifier Voltage Control */
 };
 
+struct at86rf215_agc_cache_entry
+{
+  uint32_t key;   /**< Channel key, e.g. the center frequency in Hz */
+  uint8_t  gcw;   /**< Converged AGCS.GCW */
+  uint8_t  valid;
+};
+
+/**
+ * Converged AGC gain per channel, so a retune can start from the gain the
+ * channel had last time instead of a full AGC settling
+ */
+struct at86rf215_agc_cache
+{
+  struct at86rf215_agc_cache_entry e[AT86RF215_AGC_CACHE_SIZE];
+  uint8_t                          victim;    /**< Next slot to replace */
+  uint8_t                          cur_valid; /**< cur_key is the channel
+                                                 the radio is tuned to */
+  uint32_t                         cur_key;
+  uint32_t                         hits;
+  uint32_t                         misses;
+};
+
+/**
+ * An entry of a register image. Images are kept sorted by register, so
+ * contiguous registers can be written with a single burst
+ */
+struct at86rf215_reg_val
+{
+  uint16_t reg;
+  uint8_t  val;
+};
+
+struct at86rf215_work;
+
 struct at86rf215_radio
 {
   uint32_t       init;
@@ -604,8 +771,167 @@ struct at86rf215_radio
   uint8_t        cs_reg;
   uint32_t       cs;
   uint32_t       base_freq;
-  uint8_t        trxready;
-  uint8_t        tx_complete;
+  volatile uint8_t trxready;
+  volatile uint8_t tx_complete;
+  volatile uint8_t edc_done;
+  uint32_t       edc_time;      /* cycle counter at the last EDC IRQ */
+  uint32_t       rxfs_capture;  /* timer capture of the last RXFS */
+  uint8_t        rxfs_valid;
+  /* Work queue of the dual radio scheduler (at86rf215_sched.h) */
+  struct at86rf215_work *work_head;
+  struct at86rf215_work *work_tail;
+  uint8_t        work_step;
+  uint16_t       work_pos;
+  uint32_t       work_t0;
+};
+
+/**
+ * Energy detection mode (RFn_EDC.EDM)
+ */
+typedef enum
+{
+  AT86RF215_EDM_AUTO   = 0, //!< Measurement triggered by a frame reception
+  AT86RF215_EDM_SINGLE = 1, //!< A single measurement per register write
+  AT86RF215_EDM_CONT   = 2, //!< Continuous measurements
+  AT86RF215_EDM_OFF    = 3  //!< Energy detection disabled
+} at86rf215_edm_t;
+
+/**
+ * Precomputed CCF0L, CCF0H, CNL, CNM values, written with a single burst
+ */
+struct at86rf215_retune
+{
+  uint8_t regs[4];
+};
+
+/**
+ * A channel of an energy detection scan
+ */
+struct at86rf215_scan_chan
+{
+  struct at86rf215_retune tune;    /**< Filled with at86rf215_retune_freq()
+                                      or at86rf215_retune_channel() */
+  uint16_t                samples; /**< Valid EDV samples */
+  uint16_t                busy;    /**< Samples above the busy threshold */
+  int32_t                 edv_sum; /**< Sum of the EDV samples in dBm */
+  int8_t                  edv_max; /**< Maximum EDV in dBm */
+  uint16_t                hist[AT86RF215_SCAN_HIST_BINS];
+};
+
+/**
+ * Energy detection scan over a list of channels. Driven by the EDC IRQ
+ */
+struct at86rf215_scan
+{
+  at86rf215_radio_t           radio;
+  struct at86rf215_scan_chan *chans;    /**< Channel list */
+  size_t                      nchans;   /**< Channels in the list */
+  uint16_t                    per_chan; /**< Measurements per channel visit */
+  uint16_t                    sweeps;   /**< Sweeps to run, 0 until stopped */
+  uint8_t                     edd;      /**< Measurement duration.
+                                           @see AT86RF215_EDD */
+  int8_t                      busy_thr; /**< Busy threshold in dBm */
+  volatile uint8_t            running;
+  uint32_t                    elapsed_us; /**< Duration of the last scan */
+  /* Private */
+  size_t                      cur;
+  uint16_t                    cur_n;
+  uint16_t                    sweep_n;
+  uint8_t                     edc_saved;
+  uint8_t                     edd_saved;
+  uint8_t                     irqm_saved;
+  uint32_t                    t_start;
+};
+
+/**
+ * Outcome of at86rf215_lbt_tx()
+ */
+struct at86rf215_lbt
+{
+  uint8_t  busy;          /**< The channel was found busy */
+  int8_t   edv;           /**< Energy measured by the CCA in dBm */
+  uint32_t cca_us;        /**< TX command to the EDC IRQ */
+  uint32_t turnaround_us; /**< EDC IRQ to the radio observed in TX */
+  uint32_t total_us;      /**< TX command to the end of the frame */
+};
+
+struct at86rf215;
+
+/**
+ * Handler of a single IRQ bit. Runs in the context of at86rf215_irq_callback()
+ * @param h the device handle
+ * @param radio the RF frontend the IRQ belongs to
+ * @param arg the user argument given at registration
+ */
+typedef void (*at86rf215_irq_handler_t)(struct at86rf215 *h,
+                                        at86rf215_radio_t radio, void *arg);
+
+struct at86rf215_irq_entry
+{
+  at86rf215_irq_handler_t fn;
+  void                   *arg;
+};
+
+/**
+ * IRQ pin to handler latency statistics
+ */
+struct at86rf215_irq_stats
+{
+  uint32_t count;  /**< Number of stamped IRQs serviced */
+  uint32_t max_us; /**< Worst case latency in microseconds */
+  uint32_t hist[AT86RF215_IRQ_HIST_BINS]; /**< Bin i counts latencies in
+                                             [2^(i-1), 2^i) us, bin 0 is < 1 us
+                                             and the last bin saturates */
+};
+
+struct frame_buf;
+
+/**
+ * A frame delivered by the RX pipeline
+ */
+struct at86rf215_rx_pkt
+{
+  at86rf215_radio_t radio;     /**< The RF frontend that received the frame */
+  uint16_t          len;       /**< PSDU length, including the FCS */
+  int8_t            rssi;      /**< RSSI at the end of the frame in dBm */
+  int8_t            edv;       /**< Energy of the frame in dBm */
+  uint8_t           fcs_ok;    /**< 1 if the FCS check passed */
+  uint32_t          timestamp; /**< Cycle counter value at the RXFE IRQ */
+  uint32_t          rx_start;  /**< Timer capture of the IRQ pin edge raised
+                                  by RXFS, see at86rf215_irq_capture() */
+  uint8_t           rx_start_valid; /**< 1 if rx_start holds a capture that
+                                       belongs to the RXFS of the frame */
+  uint8_t          *psdu;      /**< The received PSDU */
+  struct frame_buf *buf;       /**< The frame pool block holding the PSDU.
+                                  Take an extra reference with
+                                  frame_buf_ref() to keep it after
+                                  at86rf215_rx_release() */
+};
+
+struct at86rf215_rx_stats
+{
+  uint32_t frames;  /**< Frames handed to the application */
+  uint32_t no_buf;  /**< Frames dropped because the queue or the frame pool
+                       was full */
+  uint32_t overrun; /**< Frames dropped because the previous upload was still
+                       in progress */
+  uint32_t spi_err; /**< Frames dropped due to SPI errors */
+};
+
+/**
+ * RX pipeline state. Frames are produced from IRQ context and consumed by a
+ * single reader, so the ring needs no locking
+ */
+struct at86rf215_rx_pipe
+{
+  uint8_t                   ready;
+  volatile uint8_t          head; /**< Written only by the producer */
+  volatile uint8_t          tail; /**< Written only by the consumer */
+  uint8_t                   ring[AT86RF215_RX_QUEUE_LEN];
+  volatile uint32_t         free_mask;
+  volatile uint8_t          active[2];
+  struct at86rf215_rx_pkt   pkts[AT86RF215_RX_QUEUE_LEN];
+  struct at86rf215_rx_stats stats;
 };
 
 /**
@@ -619,6 +945,15 @@ struct at86rf215_priv
   at86rf215_chpm_t         chpm;
   struct at86rf215_radio   radios[2];
   struct at86rf215_bb_conf bbc[2];
+  struct at86rf215_irq_entry irq_tbl[AT86RF215_IRQ_SRC_NUM][8];
+  volatile uint32_t        irq_stamp;
+  volatile uint8_t         irq_stamped;
+  uint32_t                 irq_time;
+  volatile uint32_t        irq_capture;
+  volatile uint8_t         irq_captured;
+  struct at86rf215_irq_stats irq_stats;
+  struct at86rf215_rx_pipe rx;
+  struct at86rf215_agc_cache agc_cache[2];
 };
 
 struct at86rf215
@@ -647,8 +982,9 @@ struct at86rf215
 #define CLK_FREQ_8M     1
 #define CLK_FREQ_16M    2
 #define CLK_FREQ_24M    3
+#define CLK_FREQ_25M    4
 
-#define CLK_FREQ        CLK_FREQ_8M
+#define CLK_FREQ        CLK_FREQ_25M
 
 //#if CLK_FREQ == CLK_FREQ_8M
 //#define CYCLES_mS      8000
@@ -706,12 +1042,28 @@ at86rf215_reg_read_8(struct at86rf215 *h, uint8_t *out, uint16_t reg);
 int
 at86rf215_reg_read_32(struct at86rf215 *h, uint32_t *out, uint16_t reg);
 
+int
+at86rf215_reg_read_burst(struct at86rf215 *h, uint8_t *out, uint16_t reg,
+                         size_t len);
+
 int
 at86rf215_reg_write_8(struct at86rf215 *h, const uint8_t in, uint16_t reg);
 
 int
 at86rf215_reg_write_16(struct at86rf215 *h, const uint16_t in, uint16_t reg);
 
+int
+at86rf215_reg_write_burst(struct at86rf215 *h, const uint8_t *in, uint16_t reg,
+                          size_t len);
+
+int
+at86rf215_reg_image_apply(struct at86rf215 *h,
+                          const struct at86rf215_reg_val *img, size_t n);
+
+int
+at86rf215_reg_image_capture(struct at86rf215 *h, struct at86rf215_reg_val *img,
+                            size_t n);
+
 int
 at86rf215_get_state(struct at86rf215 *h, at86rf215_rf_state_t *state,
                     at86rf215_radio_t radio);
@@ -753,6 +1105,18 @@ at86rf215_set_channel(struct at86rf215 *h, at86rf215_radio_t radio,
 int
 at86rf215_set_freq(struct at86rf215 *h, at86rf215_radio_t radio, uint32_t freq);
 
+int
+at86rf215_retune_freq(struct at86rf215 *h, at86rf215_radio_t radio,
+                      uint32_t freq, struct at86rf215_retune *t);
+
+int
+at86rf215_retune_channel(struct at86rf215 *h, at86rf215_radio_t radio,
+                         uint16_t channel, struct at86rf215_retune *t);
+
+int
+at86rf215_retune(struct at86rf215 *h, at86rf215_radio_t radio,
+                 const struct at86rf215_retune *t);
+
 int
 at86rf215_get_pll_ls(struct at86rf215 *h, at86rf215_pll_ls_t *status,
                      at86rf215_radio_t radio);
@@ -783,6 +1147,18 @@ int
 at86rf215_set_agc_gain(struct at86rf215 *h, at86rf215_radio_t radio,
                        uint8_t gain);
 
+int
+at86rf215_agc_cache_store(struct at86rf215 *h, at86rf215_radio_t radio,
+                          uint32_t key);
+
+int
+at86rf215_agc_cache_apply(struct at86rf215 *h, at86rf215_radio_t radio,
+                          uint32_t key);
+
+int
+at86rf215_set_freq_cached(struct at86rf215 *h, at86rf215_radio_t radio,
+                          uint32_t freq);
+
 int
 at86rf215_get_agc_gain(struct at86rf215 *h, at86rf215_radio_t radio,
                        uint8_t *gain);
@@ -794,6 +1170,9 @@ at86rf215_set_aux_settings(struct at86rf215 *h, at86rf215_radio_t radio,
 int
 at86rf215_irq_enable(struct at86rf215 *h, uint8_t enable);
 
+int
+at86rf215_get_irq_line(struct at86rf215 *h);
+
 int
 at86rf215_irq_callback(struct at86rf215 *h);
 
@@ -803,6 +1182,22 @@ at86rf215_irq_clear(struct at86rf215 *h);
 int
 at86rf215_radio_irq_clear(struct at86rf215 *h, at86rf215_radio_t radio);
 
+int
+at86rf215_irq_register(struct at86rf215 *h, at86rf215_irq_src_t src,
+                       uint8_t bit, at86rf215_irq_handler_t fn, void *arg);
+
+void
+at86rf215_irq_stamp(struct at86rf215 *h, uint32_t cycles);
+
+void
+at86rf215_irq_capture(struct at86rf215 *h, uint32_t ticks);
+
+int
+at86rf215_irq_get_stats(struct at86rf215 *h, struct at86rf215_irq_stats *stats);
+
+int
+at86rf215_irq_reset_stats(struct at86rf215 *h);
+
 int
 at86rf215_irq_user_callback(struct at86rf215 *h, uint8_t rf09_irqs,
                             uint8_t rf24_irqs, uint8_t bbc0_irqs,
@@ -823,17 +1218,61 @@ int
 at86rf215_tx_frame(struct at86rf215 *h, at86rf215_radio_t radio,
                    const uint8_t *psdu, size_t len, size_t timeout_ms);
 
+int
+at86rf215_tx_preload(struct at86rf215 *h, at86rf215_radio_t radio,
+                     const uint8_t *psdu, size_t len);
+
+int
+at86rf215_tx_buf(struct at86rf215 *h, at86rf215_radio_t radio,
+                 struct frame_buf *buf, size_t timeout_ms);
+
+int
+at86rf215_lbt_tx(struct at86rf215 *h, at86rf215_radio_t radio,
+                 const uint8_t *psdu, size_t len, int8_t thr, uint8_t edd,
+                 size_t timeout_ms, struct at86rf215_lbt *res);
+
 int
 at86rf215_rx(struct at86rf215 *h, at86rf215_radio_t radio, size_t timeout_ms);
 
+int
+at86rf215_rx_arm(struct at86rf215 *h, at86rf215_radio_t radio);
+
+int
+at86rf215_rx_start(struct at86rf215 *h, at86rf215_radio_t radio,
+                   size_t timeout_ms);
+
+int
+at86rf215_rx_stop(struct at86rf215 *h, at86rf215_radio_t radio);
+
+int
+at86rf215_rx_get(struct at86rf215 *h, struct at86rf215_rx_pkt **pkt);
+
+int
+at86rf215_rx_release(struct at86rf215 *h, struct at86rf215_rx_pkt *pkt);
+
+int
+at86rf215_rx_get_stats(struct at86rf215 *h, struct at86rf215_rx_stats *stats);
+
 int
 at86rf215_iq_conf(struct at86rf215 *h, at86rf215_radio_t radio,
                   const struct at86rf215_iq_conf *conf);
 
+int
+at86rf215_set_iq_eec(struct at86rf215 *h, uint8_t enable);
+
+int
+at86rf215_scan_start(struct at86rf215 *h, struct at86rf215_scan *scan);
+
+int
+at86rf215_scan_stop(struct at86rf215 *h, struct at86rf215_scan *scan);
+
+int
+at86rf215_scan_best(const struct at86rf215_scan *scan, size_t *idx);
+
 
-    void AT86RF215WriteBuffer( uint16_t addr, uint8_t *buffer, uint8_t size );
-    void AT86RF215ReadBuffer(uint16_t addr, uint8_t *buffer, uint8_t size);
-    void AT86RF215Write( uint16_t addr, uint8_t data );
+    int AT86RF215WriteBuffer( uint16_t addr, uint8_t *buffer, uint8_t size );
+    int AT86RF215ReadBuffer(uint16_t addr, uint8_t *buffer, uint8_t size);
+    int AT86RF215Write( uint16_t addr, uint8_t data );
     uint8_t AT86RF215Read( uint16_t addr );
     void AT86RF215TxSetIQ(uint32_t freq);
     uint8_t AT86RF215GetState(void);
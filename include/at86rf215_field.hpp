@@ -0,0 +1,163 @@
+/*
+ * at86rf215_field.hpp
+ *
+ * Typed register fields for C++17 code, on top of the driver register
+ * access. The registers and fields themselves are generated into
+ * at86rf215_regs.hpp (tools/regs_gen.cpp). C++17 is beyond the TI ARM CGT
+ * of the firmware build, this is for the host tools and other toolchains.
+ *
+ * A field value is an update<Reg, Mask>: the register is part of the type,
+ * and so are the bits written. Updates of one register merge with | at
+ * compile time, fields set twice or fields of other registers do not
+ * compile, and constants wider than their field do not compile either:
+ *
+ *   namespace r = at86rf215_regs;
+ *   r::write(h, r::RF_IQIFC1::CHPM::RF | r::RF_IQIFC1::SKEDRV::val<2>);
+ *   r::write(h, radio, r::BBC0_PC::CTX::val<1>);
+ *
+ * write() issues one read-modify-write per call, or a single write when
+ * the update covers all 8 bits. Registers of the RF09 and BBC0 sets are
+ * banked: given a radio, they address the RF24 and BBC1 copy as well.
+ */
+#ifndef AT86RF215_FIELD_HPP
+#define AT86RF215_FIELD_HPP
+
+#include <at86rf215.h>
+#include <cstdint>
+
+namespace at86rf215_regs {
+
+/* Offset of the RF24 and BBC1 registers from the RF09 and BBC0 ones */
+constexpr uint16_t bank_stride = 0x100;
+
+template <uint16_t Addr, bool Banked = false>
+struct reg {
+    static constexpr uint16_t addr = Addr;
+    static constexpr bool banked = Banked;
+};
+
+/* Value of the bits Mask of register Reg, the other bits are kept */
+template <typename Reg, uint8_t Mask>
+struct update {
+    uint8_t value;
+};
+
+template <typename Reg, uint8_t M1, uint8_t M2>
+constexpr update<Reg, M1 | M2> operator|(update<Reg, M1> a, update<Reg, M2> b)
+{
+    static_assert((M1 & M2) == 0, "field set twice");
+    return {uint8_t(a.value | b.value)};
+}
+
+template <typename Reg, unsigned Pos, unsigned Width>
+struct field {
+    static_assert(Width >= 1 && Pos + Width <= 8, "field out of its register");
+
+    using reg_type = Reg;
+    static constexpr unsigned pos = Pos;
+    static constexpr unsigned width = Width;
+    static constexpr uint8_t mask = ((1u << Width) - 1) << Pos;
+    using update_type = update<Reg, mask>;
+
+    template <unsigned V>
+    static constexpr update_type make()
+    {
+        static_assert(V < (1u << Width), "value wider than its field");
+        return {uint8_t(V << Pos)};
+    }
+
+    /* Constant, checked at compile time */
+    template <unsigned V>
+    static constexpr update_type val = make<V>();
+
+    /* Run time value, the bits beyond the field are dropped */
+    static constexpr update_type set(unsigned v)
+    {
+        return {uint8_t((v << Pos) & mask)};
+    }
+
+    static constexpr unsigned get(uint8_t r)
+    {
+        return (r & mask) >> Pos;
+    }
+};
+
+/* Whole register value, for the registers without fields */
+template <typename Reg, unsigned V>
+constexpr update<Reg, 0xFF> value()
+{
+    static_assert(V <= 0xFF, "value wider than its register");
+    return {uint8_t(V)};
+}
+
+namespace detail {
+
+template <typename Reg, uint8_t Mask>
+int write_at(struct at86rf215 *h, update<Reg, Mask> u, uint16_t offset)
+{
+    const uint16_t addr = Reg::addr + offset;
+    if constexpr (Mask == 0xFF) {
+        return at86rf215_reg_write_8(h, u.value, addr);
+    } else {
+        uint8_t val;
+        int ret = at86rf215_reg_read_8(h, &val, addr);
+        if (ret) {
+            return ret;
+        }
+        return at86rf215_reg_write_8(h, uint8_t((val & uint8_t(~Mask)) | u.value),
+                                     addr);
+    }
+}
+
+template <typename Field>
+int read_at(struct at86rf215 *h, uint8_t *out, uint16_t offset)
+{
+    uint8_t val;
+    int ret = at86rf215_reg_read_8(h, &val, Field::reg_type::addr + offset);
+    if (ret) {
+        return ret;
+    }
+    *out = Field::get(val);
+    return AT86RF215_OK;
+}
+
+template <typename Reg>
+constexpr uint16_t bank(at86rf215_radio_t radio)
+{
+    static_assert(Reg::banked, "register not of the RF09 or BBC0 set");
+    return radio == AT86RF215_RF09 ? 0 : bank_stride;
+}
+
+} // namespace detail
+
+/* Writes the updates of one register, in a single access or read-modify-write */
+template <typename Reg, uint8_t Mask, typename... More>
+int write(struct at86rf215 *h, update<Reg, Mask> u, More... more)
+{
+    return detail::write_at(h, (u | ... | more), 0);
+}
+
+/* Same, on the copy of a banked register of the radio */
+template <typename Reg, uint8_t Mask, typename... More>
+int write(struct at86rf215 *h, at86rf215_radio_t radio, update<Reg, Mask> u,
+          More... more)
+{
+    return detail::write_at(h, (u | ... | more), detail::bank<Reg>(radio));
+}
+
+template <typename Field>
+int read(struct at86rf215 *h, uint8_t *out)
+{
+    return detail::read_at<Field>(h, out, 0);
+}
+
+template <typename Field>
+int read(struct at86rf215 *h, at86rf215_radio_t radio, uint8_t *out)
+{
+    return detail::read_at<Field>(h, out,
+                                  detail::bank<typename Field::reg_type>(radio));
+}
+
+} // namespace at86rf215_regs
+
+#endif /* AT86RF215_FIELD_HPP */
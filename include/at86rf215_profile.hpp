@@ -0,0 +1,73 @@
+/*
+ * at86rf215_profile.hpp
+ *
+ * Register images built at compile time from typed field updates
+ * (at86rf215_field.hpp), for at86rf215_reg_image_apply(). Each argument of
+ * profile() is the complete value of one register, fields merged with |,
+ * the bits not given written as 0. The image comes out sorted, so the
+ * contiguous registers go out as one SPI burst, and a register given twice
+ * does not compile:
+ *
+ *   namespace r = at86rf215_regs;
+ *   constexpr auto img = r::profile(
+ *       r::RF09_TXDFE::SR::SR4000 | r::RF09_TXDFE::RCUT::CUT_4_4,
+ *       r::RF_IQIFC1::CHPM::RF);
+ *
+ * Banked registers are given in their RF09 and BBC0 form,
+ * profile<AT86RF215_RF24>() moves them to the RF24 and BBC1 copy.
+ *
+ * The firmware compiler (TI ARM CGT) stops at C++14, so the images are
+ * built on the host by tools/profile_gen.cpp and land in the firmware as
+ * the C tables of Src/profile_images.h.
+ */
+#ifndef AT86RF215_PROFILE_HPP
+#define AT86RF215_PROFILE_HPP
+
+#include <at86rf215_field.hpp>
+#include <array>
+#include <cstddef>
+
+namespace at86rf215_regs {
+
+namespace detail {
+
+/* Not constexpr: reaching it stops the compile-time evaluation */
+inline void profile_register_twice() {}
+
+template <at86rf215_radio_t Radio, typename Reg, uint8_t Mask>
+constexpr at86rf215_reg_val profile_entry(update<Reg, Mask> u)
+{
+    uint16_t reg = Reg::addr;
+    if constexpr (Reg::banked) {
+        if (Radio != AT86RF215_RF09) {
+            reg += bank_stride;
+        }
+    }
+    return {reg, u.value};
+}
+
+} // namespace detail
+
+template <at86rf215_radio_t Radio = AT86RF215_RF09, typename... Updates>
+constexpr std::array<at86rf215_reg_val, sizeof...(Updates)> profile(Updates... u)
+{
+    std::array<at86rf215_reg_val, sizeof...(Updates)> img = {
+        detail::profile_entry<Radio>(u)...};
+    for (size_t i = 1; i < img.size(); i++) {
+        for (size_t j = i; j > 0 && img[j - 1].reg > img[j].reg; j--) {
+            const at86rf215_reg_val t = img[j];
+            img[j] = img[j - 1];
+            img[j - 1] = t;
+        }
+    }
+    for (size_t i = 1; i < img.size(); i++) {
+        if (img[i - 1].reg == img[i].reg) {
+            detail::profile_register_twice();
+        }
+    }
+    return img;
+}
+
+} // namespace at86rf215_regs
+
+#endif /* AT86RF215_PROFILE_HPP */
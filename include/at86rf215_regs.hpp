@@ -0,0 +1,939 @@
+/*
+ * at86rf215_regs.hpp
+ *
+ * Registers and fields of the AT86RF215, see at86rf215_field.hpp.
+ * Generated by tools/regs_gen.cpp from include/regs.h and
+ * include/at86rf215Regs.h, do not edit.
+ */
+#ifndef AT86RF215_REGS_HPP
+#define AT86RF215_REGS_HPP
+
+#include <at86rf215_field.hpp>
+
+namespace at86rf215_regs {
+
+struct RF09_IRQS : reg<0x0000> {};
+
+struct RF24_IRQS : reg<0x0001> {};
+
+struct BBC0_IRQS : reg<0x0002> {};
+
+struct BBC1_IRQS : reg<0x0003> {};
+
+struct RF_RST : reg<0x0005> {};
+
+struct RF_CFG : reg<0x0006> {
+    struct DRV : field<RF_CFG, 0, 2> {};
+    struct IRQP : field<RF_CFG, 2, 1> {};
+    struct IRQMM : field<RF_CFG, 3, 1> {};
+};
+
+struct RF_CLKO : reg<0x0007> {
+    struct OS : field<RF_CLKO, 0, 3> {
+        static constexpr update_type CLKO_OFF = make<0x00>();
+        static constexpr update_type CLKO_26MHZ = make<0x01>();
+        static constexpr update_type CLKO_32MHZ = make<0x02>();
+    };
+    struct DRV : field<RF_CLKO, 3, 2> {};
+};
+
+struct RF_BMDVC : reg<0x0008> {};
+
+struct RF_XOC : reg<0x0009> {};
+
+struct RF_IQIFC0 : reg<0x000A> {
+    struct EEC : field<RF_IQIFC0, 0, 1> {};
+    struct CMV1V2 : field<RF_IQIFC0, 1, 1> {};
+    struct CMV : field<RF_IQIFC0, 2, 2> {
+        static constexpr update_type CMV150 = make<0x00>();
+        static constexpr update_type CMV200 = make<0x01>();
+        static constexpr update_type CMV250 = make<0x02>();
+        static constexpr update_type CMV300 = make<0x03>();
+    };
+    struct DRV : field<RF_IQIFC0, 4, 2> {
+        static constexpr update_type DRV_Current_1mA = make<0x00>();
+        static constexpr update_type DRV_Current_2mA = make<0x01>();
+        static constexpr update_type DRV_Current_3mA = make<0x02>();
+        static constexpr update_type DRV_Current_4mA = make<0x03>();
+    };
+    struct SF : field<RF_IQIFC0, 6, 1> {};
+    struct EXTLB : field<RF_IQIFC0, 7, 1> {};
+};
+
+struct RF_IQIFC1 : reg<0x000B> {
+    struct SKEDRV : field<RF_IQIFC1, 0, 2> {
+        static constexpr update_type SKEW_pos_2 = make<0x00>();
+        static constexpr update_type SKEW_pos_1 = make<0x01>();
+        static constexpr update_type SKEW_zero = make<0x02>();
+        static constexpr update_type SKEW_neg_1 = make<0x03>();
+    };
+    struct CHPM : field<RF_IQIFC1, 4, 3> {
+        static constexpr update_type BBRF = make<0x00>();
+        static constexpr update_type RF = make<0x01>();
+        static constexpr update_type BBRF09 = make<0x04>();
+        static constexpr update_type BBRF24 = make<0x05>();
+    };
+    struct FAILSF : field<RF_IQIFC1, 7, 1> {};
+};
+
+struct RF_IQIFC2 : reg<0x000C> {};
+
+struct RF_PN : reg<0x000D> {};
+
+struct RF_VN : reg<0x000E> {};
+
+struct RF09_IRQM : reg<0x0100, true> {
+    struct WAKEUP : field<RF09_IRQM, 0, 1> {};
+    struct TRXRDY : field<RF09_IRQM, 1, 1> {};
+    struct EDC : field<RF09_IRQM, 2, 1> {};
+    struct BATLOW : field<RF09_IRQM, 3, 1> {};
+    struct TRXERR : field<RF09_IRQM, 4, 1> {};
+    struct IQIFSF : field<RF09_IRQM, 5, 1> {};
+};
+
+struct RF09_AUXS : reg<0x0101, true> {
+    struct PAVC : field<RF09_AUXS, 0, 2> {
+        static constexpr update_type PA_VC_2_0 = make<0x00>();
+        static constexpr update_type PA_VC_2_2 = make<0x01>();
+        static constexpr update_type PA_VC_2_4 = make<0x02>();
+    };
+    struct AVS : field<RF09_AUXS, 2, 1> {};
+    struct AVEN : field<RF09_AUXS, 3, 1> {};
+    struct AVEXT : field<RF09_AUXS, 4, 1> {};
+    struct AGCMAP : field<RF09_AUXS, 5, 2> {};
+    struct EXTLNABYP : field<RF09_AUXS, 7, 1> {};
+};
+
+struct RF09_STATE : reg<0x0102, true> {
+    struct STATE : field<RF09_STATE, 0, 3> {
+        static constexpr update_type TRXOFF = make<0x02>();
+        static constexpr update_type TXPREP = make<0x03>();
+        static constexpr update_type TX = make<0x04>();
+        static constexpr update_type RX = make<0x05>();
+        static constexpr update_type TRANSITION = make<0x06>();
+        static constexpr update_type RESET = make<0x07>();
+    };
+};
+
+struct RF09_CMD : reg<0x0103, true> {
+    struct CMD : field<RF09_CMD, 0, 3> {
+        static constexpr update_type NOP = make<0x00>();
+        static constexpr update_type SLEEP = make<0x01>();
+        static constexpr update_type TRXOFF = make<0x02>();
+        static constexpr update_type TXPREP = make<0x03>();
+        static constexpr update_type TX = make<0x04>();
+        static constexpr update_type RX = make<0x05>();
+        static constexpr update_type RESET = make<0x07>();
+    };
+};
+
+struct RF09_CS : reg<0x0104, true> {};
+
+struct RF09_CCF0L : reg<0x0105, true> {};
+
+struct RF09_CCF0H : reg<0x0106, true> {};
+
+struct RF09_CNL : reg<0x0107, true> {};
+
+struct RF09_CNM : reg<0x0108, true> {};
+
+struct RF09_RXBWC : reg<0x0109, true> {
+    struct BW : field<RF09_RXBWC, 0, 4> {
+        static constexpr update_type BW160KHZ_IF250KHZ = make<0x00>();
+        static constexpr update_type BW200KHZ_IF250KHZ = make<0x01>();
+        static constexpr update_type BW250KHZ_IF250KHZ = make<0x02>();
+        static constexpr update_type BW320KHZ_IF500KHZ = make<0x03>();
+        static constexpr update_type BW400KHZ_IF500KHZ = make<0x04>();
+        static constexpr update_type BW500KHZ_IF500KHZ = make<0x05>();
+        static constexpr update_type BW630KHZ_IF1000KHZ = make<0x06>();
+        static constexpr update_type BW800KHZ_IF1000KHZ = make<0x07>();
+        static constexpr update_type BW1000KHZ_IF1000KHZ = make<0x08>();
+        static constexpr update_type BW1250KHZ_IF2000KHZ = make<0x09>();
+        static constexpr update_type BW1600KHZ_IF2000KHZ = make<0x0A>();
+        static constexpr update_type BW2000KHZ_IF2000KHZ = make<0x0B>();
+    };
+    struct IFS : field<RF09_RXBWC, 4, 1> {
+        static constexpr update_type IFS_Deactive = make<0x00>();
+        static constexpr update_type IFS_Active = make<0x01>();
+    };
+    struct IFI : field<RF09_RXBWC, 5, 1> {};
+};
+
+struct RF09_RXDFE : reg<0x010A, true> {
+    struct SR : field<RF09_RXDFE, 0, 4> {
+        static constexpr update_type SR4000 = make<0x01>();
+        static constexpr update_type SR2000 = make<0x02>();
+        static constexpr update_type SR1333 = make<0x03>();
+        static constexpr update_type SR1000 = make<0x04>();
+        static constexpr update_type SR800 = make<0x05>();
+        static constexpr update_type SR666 = make<0x06>();
+        static constexpr update_type SR500 = make<0x08>();
+        static constexpr update_type SR400 = make<0x0A>();
+    };
+    struct RCUT : field<RF09_RXDFE, 5, 3> {
+        static constexpr update_type CUT_1_4 = make<0x00>();
+        static constexpr update_type CUT_3_8 = make<0x01>();
+        static constexpr update_type CUT_1_2 = make<0x02>();
+        static constexpr update_type CUT_3_4 = make<0x03>();
+        static constexpr update_type CUT_4_4 = make<0x04>();
+    };
+};
+
+struct RF09_AGCC : reg<0x010B, true> {
+    struct EN : field<RF09_AGCC, 0, 1> {};
+    struct FRZC : field<RF09_AGCC, 1, 1> {};
+    struct FRZS : field<RF09_AGCC, 2, 1> {};
+    struct RST : field<RF09_AGCC, 3, 1> {};
+    struct AVGS : field<RF09_AGCC, 4, 2> {
+        static constexpr update_type AVGS_8 = make<0x00>();
+        static constexpr update_type AVGS_16 = make<0x01>();
+        static constexpr update_type AVGS_32 = make<0x02>();
+        static constexpr update_type AVGS_64 = make<0x03>();
+    };
+    struct AGCI : field<RF09_AGCC, 6, 1> {};
+};
+
+struct RF09_AGCS : reg<0x010C, true> {
+    struct GCW : field<RF09_AGCS, 0, 5> {};
+    struct TGT : field<RF09_AGCS, 5, 3> {};
+};
+
+struct RF09_RSSI : reg<0x010D, true> {};
+
+struct RF09_EDC : reg<0x010E, true> {
+    struct EDM : field<RF09_EDC, 0, 2> {};
+};
+
+struct RF09_EDD : reg<0x010F, true> {
+    struct DTB : field<RF09_EDD, 0, 2> {};
+    struct DF : field<RF09_EDD, 2, 6> {};
+};
+
+struct RF09_EDV : reg<0x0110, true> {};
+
+struct RF09_RNDV : reg<0x0111, true> {};
+
+struct RF09_TXCUTC : reg<0x0112, true> {
+    struct LPFCUT : field<RF09_TXCUTC, 0, 4> {};
+    struct PARAMP : field<RF09_TXCUTC, 6, 2> {};
+};
+
+struct RF09_TXDFE : reg<0x0113, true> {
+    struct SR : field<RF09_TXDFE, 0, 4> {
+        static constexpr update_type SR4000 = make<0x01>();
+        static constexpr update_type SR2000 = make<0x02>();
+        static constexpr update_type SR1333 = make<0x03>();
+        static constexpr update_type SR1000 = make<0x04>();
+        static constexpr update_type SR800 = make<0x05>();
+        static constexpr update_type SR666 = make<0x06>();
+        static constexpr update_type SR500 = make<0x08>();
+        static constexpr update_type SR400 = make<0x0A>();
+    };
+    struct DM : field<RF09_TXDFE, 4, 1> {};
+    struct RCUT : field<RF09_TXDFE, 5, 3> {
+        static constexpr update_type CUT_1_4 = make<0x00>();
+        static constexpr update_type CUT_3_8 = make<0x01>();
+        static constexpr update_type CUT_1_2 = make<0x02>();
+        static constexpr update_type CUT_3_4 = make<0x03>();
+        static constexpr update_type CUT_4_4 = make<0x04>();
+    };
+};
+
+struct RF09_PAC : reg<0x0114, true> {
+    struct TXPWR : field<RF09_PAC, 0, 5> {
+        static constexpr update_type TXPWR_00 = make<0x00>();
+        static constexpr update_type TXPWR_01 = make<0x01>();
+        static constexpr update_type TXPWR_10 = make<0x10>();
+        static constexpr update_type TXPWR_MAX = make<0x1F>();
+    };
+    struct PACUR : field<RF09_PAC, 5, 2> {
+        static constexpr update_type PAC_3dB_Reduction = make<0x00>();
+        static constexpr update_type PAC_2dB_Reduction = make<0x01>();
+        static constexpr update_type PAC_1dB_Reduction = make<0x02>();
+        static constexpr update_type PAC_0dB_Reduction = make<0x03>();
+    };
+};
+
+struct RF09_PADFE : reg<0x0116, true> {};
+
+struct RF09_PLL : reg<0x0121, true> {};
+
+struct RF09_PLLCF : reg<0x0122, true> {};
+
+struct RF09_TXCI : reg<0x0125, true> {};
+
+struct RF09_TXCQ : reg<0x0126, true> {};
+
+struct RF09_TXDACI : reg<0x0127, true> {};
+
+struct RF09_TXDACQ : reg<0x0128, true> {};
+
+struct RF24_IRQM : reg<0x0200> {
+    struct WAKEUP : field<RF24_IRQM, 0, 1> {};
+    struct TRXRDY : field<RF24_IRQM, 1, 1> {};
+    struct EDC : field<RF24_IRQM, 2, 1> {};
+    struct BATLOW : field<RF24_IRQM, 3, 1> {};
+    struct TRXERR : field<RF24_IRQM, 4, 1> {};
+    struct IQIFSF : field<RF24_IRQM, 5, 1> {};
+};
+
+struct BBC0_FBRXS : reg<0x2000> {};
+
+struct RF24_AUXS : reg<0x0201> {
+    struct PAVC : field<RF24_AUXS, 0, 2> {
+        static constexpr update_type PA_VC_2_0 = make<0x00>();
+        static constexpr update_type PA_VC_2_2 = make<0x01>();
+        static constexpr update_type PA_VC_2_4 = make<0x02>();
+    };
+    struct AVS : field<RF24_AUXS, 2, 1> {};
+    struct AVEN : field<RF24_AUXS, 3, 1> {};
+    struct AVEXT : field<RF24_AUXS, 4, 1> {};
+    struct AGCMAP : field<RF24_AUXS, 5, 2> {};
+    struct EXTLNABYP : field<RF24_AUXS, 7, 1> {};
+};
+
+struct RF24_STATE : reg<0x0202> {
+    struct STATE : field<RF24_STATE, 0, 3> {
+        static constexpr update_type TRXOFF = make<0x02>();
+        static constexpr update_type TXPREP = make<0x03>();
+        static constexpr update_type TX = make<0x04>();
+        static constexpr update_type RX = make<0x05>();
+        static constexpr update_type TRANSITION = make<0x06>();
+        static constexpr update_type RESET = make<0x07>();
+    };
+};
+
+struct RF24_CMD : reg<0x0203> {
+    struct CMD : field<RF24_CMD, 0, 3> {
+        static constexpr update_type NOP = make<0x00>();
+        static constexpr update_type SLEEP = make<0x01>();
+        static constexpr update_type TRXOFF = make<0x02>();
+        static constexpr update_type TXPREP = make<0x03>();
+        static constexpr update_type TX = make<0x04>();
+        static constexpr update_type RX = make<0x05>();
+        static constexpr update_type RESET = make<0x07>();
+    };
+};
+
+struct RF24_CS : reg<0x0204> {};
+
+struct RF24_CCF0L : reg<0x0205> {};
+
+struct RF24_CCF0H : reg<0x0206> {};
+
+struct RF24_CNL : reg<0x0207> {};
+
+struct RF24_CNM : reg<0x0208> {};
+
+struct RF24_RXBWC : reg<0x0209> {
+    struct BW : field<RF24_RXBWC, 0, 4> {
+        static constexpr update_type BW160KHZ_IF250KHZ = make<0x00>();
+        static constexpr update_type BW200KHZ_IF250KHZ = make<0x01>();
+        static constexpr update_type BW250KHZ_IF250KHZ = make<0x02>();
+        static constexpr update_type BW320KHZ_IF500KHZ = make<0x03>();
+        static constexpr update_type BW400KHZ_IF500KHZ = make<0x04>();
+        static constexpr update_type BW500KHZ_IF500KHZ = make<0x05>();
+        static constexpr update_type BW630KHZ_IF1000KHZ = make<0x06>();
+        static constexpr update_type BW800KHZ_IF1000KHZ = make<0x07>();
+        static constexpr update_type BW1000KHZ_IF1000KHZ = make<0x08>();
+        static constexpr update_type BW1250KHZ_IF2000KHZ = make<0x09>();
+        static constexpr update_type BW1600KHZ_IF2000KHZ = make<0x0A>();
+        static constexpr update_type BW2000KHZ_IF2000KHZ = make<0x0B>();
+    };
+    struct IFS : field<RF24_RXBWC, 4, 1> {
+        static constexpr update_type IFS_Deactive = make<0x00>();
+        static constexpr update_type IFS_Active = make<0x01>();
+    };
+    struct IFI : field<RF24_RXBWC, 5, 1> {};
+};
+
+struct RF24_RXDFE : reg<0x020A> {
+    struct SR : field<RF24_RXDFE, 0, 4> {
+        static constexpr update_type SR4000 = make<0x01>();
+        static constexpr update_type SR2000 = make<0x02>();
+        static constexpr update_type SR1333 = make<0x03>();
+        static constexpr update_type SR1000 = make<0x04>();
+        static constexpr update_type SR800 = make<0x05>();
+        static constexpr update_type SR666 = make<0x06>();
+        static constexpr update_type SR500 = make<0x08>();
+        static constexpr update_type SR400 = make<0x0A>();
+    };
+    struct RCUT : field<RF24_RXDFE, 5, 3> {
+        static constexpr update_type CUT_1_4 = make<0x00>();
+        static constexpr update_type CUT_3_8 = make<0x01>();
+        static constexpr update_type CUT_1_2 = make<0x02>();
+        static constexpr update_type CUT_3_4 = make<0x03>();
+        static constexpr update_type CUT_4_4 = make<0x04>();
+    };
+};
+
+struct RF24_AGCC : reg<0x020B> {
+    struct EN : field<RF24_AGCC, 0, 1> {};
+    struct FRZC : field<RF24_AGCC, 1, 1> {};
+    struct FRZS : field<RF24_AGCC, 2, 1> {};
+    struct RST : field<RF24_AGCC, 3, 1> {};
+    struct AVGS : field<RF24_AGCC, 4, 2> {
+        static constexpr update_type AVGS_8 = make<0x00>();
+        static constexpr update_type AVGS_16 = make<0x01>();
+        static constexpr update_type AVGS_32 = make<0x02>();
+        static constexpr update_type AVGS_64 = make<0x03>();
+    };
+    struct AGCI : field<RF24_AGCC, 6, 1> {};
+};
+
+struct RF24_AGCS : reg<0x020C> {
+    struct GCW : field<RF24_AGCS, 0, 5> {};
+    struct TGT : field<RF24_AGCS, 5, 3> {};
+};
+
+struct RF24_RSSI : reg<0x020D> {};
+
+struct RF24_EDC : reg<0x020E> {
+    struct EDM : field<RF24_EDC, 0, 2> {};
+};
+
+struct RF24_EDD : reg<0x020F> {
+    struct DTB : field<RF24_EDD, 0, 2> {};
+    struct DF : field<RF24_EDD, 2, 6> {};
+};
+
+struct RF24_EDV : reg<0x0210> {};
+
+struct RF24_RNDV : reg<0x0211> {};
+
+struct RF24_TXCUTC : reg<0x0212> {
+    struct LPFCUT : field<RF24_TXCUTC, 0, 4> {};
+    struct PARAMP : field<RF24_TXCUTC, 6, 2> {};
+};
+
+struct RF24_TXDFE : reg<0x0213> {
+    struct SR : field<RF24_TXDFE, 0, 4> {
+        static constexpr update_type SR4000 = make<0x01>();
+        static constexpr update_type SR2000 = make<0x02>();
+        static constexpr update_type SR1333 = make<0x03>();
+        static constexpr update_type SR1000 = make<0x04>();
+        static constexpr update_type SR800 = make<0x05>();
+        static constexpr update_type SR666 = make<0x06>();
+        static constexpr update_type SR500 = make<0x08>();
+        static constexpr update_type SR400 = make<0x0A>();
+    };
+    struct DM : field<RF24_TXDFE, 4, 1> {};
+    struct RCUT : field<RF24_TXDFE, 5, 3> {
+        static constexpr update_type CUT_1_4 = make<0x00>();
+        static constexpr update_type CUT_3_8 = make<0x01>();
+        static constexpr update_type CUT_1_2 = make<0x02>();
+        static constexpr update_type CUT_3_4 = make<0x03>();
+        static constexpr update_type CUT_4_4 = make<0x04>();
+    };
+};
+
+struct RF24_PAC : reg<0x0214> {
+    struct TXPWR : field<RF24_PAC, 0, 5> {
+        static constexpr update_type TXPWR_00 = make<0x00>();
+        static constexpr update_type TXPWR_01 = make<0x01>();
+        static constexpr update_type TXPWR_10 = make<0x10>();
+        static constexpr update_type TXPWR_MAX = make<0x1F>();
+    };
+    struct PACUR : field<RF24_PAC, 5, 2> {
+        static constexpr update_type PAC_3dB_Reduction = make<0x00>();
+        static constexpr update_type PAC_2dB_Reduction = make<0x01>();
+        static constexpr update_type PAC_1dB_Reduction = make<0x02>();
+        static constexpr update_type PAC_0dB_Reduction = make<0x03>();
+    };
+};
+
+struct RF24_PADFE : reg<0x0216> {};
+
+struct RF24_PLL : reg<0x0221> {};
+
+struct RF24_PLLCF : reg<0x0222> {};
+
+struct RF24_TXCI : reg<0x0225> {};
+
+struct RF24_TXCQ : reg<0x0226> {};
+
+struct RF24_TXDACI : reg<0x0227> {};
+
+struct RF24_TXDACQ : reg<0x0228> {};
+
+struct BBC0_FBRXE : reg<0x27FE> {};
+
+struct BBC0_FBTXS : reg<0x2800> {};
+
+struct BBC0_FBTXE : reg<0x2FFE> {};
+
+struct BBC0_IRQM : reg<0x0300, true> {
+    struct RXFS : field<BBC0_IRQM, 0, 1> {};
+    struct RXFE : field<BBC0_IRQM, 1, 1> {};
+    struct RXAM : field<BBC0_IRQM, 2, 1> {};
+    struct RXEM : field<BBC0_IRQM, 3, 1> {};
+    struct TXFE : field<BBC0_IRQM, 4, 1> {};
+    struct AGCH : field<BBC0_IRQM, 5, 1> {};
+    struct AGCR : field<BBC0_IRQM, 6, 1> {};
+    struct FBLI : field<BBC0_IRQM, 7, 1> {};
+};
+
+struct BBC1_FBRXS : reg<0x3000> {};
+
+struct BBC0_PC : reg<0x0301, true> {
+    struct PT : field<BBC0_PC, 0, 2> {};
+    struct BBEN : field<BBC0_PC, 2, 1> {};
+    struct FCST : field<BBC0_PC, 3, 1> {};
+    struct TXAFCS : field<BBC0_PC, 4, 1> {};
+    struct FCSOK : field<BBC0_PC, 5, 1> {};
+    struct FCSFE : field<BBC0_PC, 6, 1> {};
+    struct CTX : field<BBC0_PC, 7, 1> {};
+};
+
+struct BBC0_PS : reg<0x0302, true> {};
+
+struct BBC0_RXFLL : reg<0x0304, true> {};
+
+struct BBC0_RXFLH : reg<0x0305, true> {};
+
+struct BBC0_TXFLL : reg<0x0306, true> {};
+
+struct BBC0_TXFLH : reg<0x0307, true> {};
+
+struct BBC0_FBLL : reg<0x0308, true> {};
+
+struct BBC0_FBLH : reg<0x0309, true> {};
+
+struct BBC0_FBLIL : reg<0x030A, true> {};
+
+struct BBC0_FBLIH : reg<0x030B, true> {};
+
+struct BBC0_OFDMPHRTX : reg<0x030C, true> {};
+
+struct BBC0_OFDMPHRRX : reg<0x030D, true> {};
+
+struct BBC0_OFDMC : reg<0x030E, true> {};
+
+struct BBC0_OFDMSW : reg<0x030F, true> {};
+
+struct BBC0_OQPSKC0 : reg<0x0310, true> {};
+
+struct BBC0_OQPSKC1 : reg<0x0311, true> {};
+
+struct BBC0_OQPSKC2 : reg<0x0312, true> {};
+
+struct BBC0_OQPSKC3 : reg<0x0313, true> {};
+
+struct BBC0_OQPSKPHRTX : reg<0x0314, true> {};
+
+struct BBC0_OQPSKPHRRX : reg<0x0315, true> {};
+
+struct BBC0_AFC0 : reg<0x0320, true> {};
+
+struct BBC0_AFC1 : reg<0x0321, true> {};
+
+struct BBC0_AFFTM : reg<0x0322, true> {};
+
+struct BBC0_AFFVM : reg<0x0323, true> {};
+
+struct BBC0_AFS : reg<0x0324, true> {};
+
+struct BBC0_MACEA0 : reg<0x0325, true> {};
+
+struct BBC0_MACEA1 : reg<0x0326, true> {};
+
+struct BBC0_MACEA2 : reg<0x0327, true> {};
+
+struct BBC0_MACEA3 : reg<0x0328, true> {};
+
+struct BBC0_MACEA4 : reg<0x0329, true> {};
+
+struct BBC0_MACEA5 : reg<0x032A, true> {};
+
+struct BBC0_MACEA6 : reg<0x032B, true> {};
+
+struct BBC0_MACEA7 : reg<0x032C, true> {};
+
+struct BBC0_MACPID0F0 : reg<0x032D, true> {};
+
+struct BBC0_MACPID1F0 : reg<0x032E, true> {};
+
+struct BBC0_MACSHA0F0 : reg<0x032F, true> {};
+
+struct BBC0_MACSHA1F0 : reg<0x0330, true> {};
+
+struct BBC0_MACPID0F1 : reg<0x0331, true> {};
+
+struct BBC0_MACPID1F1 : reg<0x0332, true> {};
+
+struct BBC0_MACSHA0F1 : reg<0x0333, true> {};
+
+struct BBC0_MACSHA1F1 : reg<0x0334, true> {};
+
+struct BBC0_MACPID0F2 : reg<0x0335, true> {};
+
+struct BBC0_MACPID1F2 : reg<0x0336, true> {};
+
+struct BBC0_MACSHA0F2 : reg<0x0337, true> {};
+
+struct BBC0_MACSHA1F2 : reg<0x0338, true> {};
+
+struct BBC0_MACPID0F3 : reg<0x0339, true> {};
+
+struct BBC0_MACPID1F3 : reg<0x033A, true> {};
+
+struct BBC0_MACSHA0F3 : reg<0x033B, true> {};
+
+struct BBC0_MACSHA1F3 : reg<0x033C, true> {};
+
+struct BBC0_AMCS : reg<0x0340, true> {
+    struct TX2RX : field<BBC0_AMCS, 0, 1> {};
+    struct CCATX : field<BBC0_AMCS, 1, 1> {};
+    struct CCAED : field<BBC0_AMCS, 2, 1> {};
+    struct AACK : field<BBC0_AMCS, 3, 1> {};
+    struct AACKS : field<BBC0_AMCS, 4, 1> {};
+    struct AACKDR : field<BBC0_AMCS, 5, 1> {};
+    struct AACKFA : field<BBC0_AMCS, 6, 1> {};
+    struct AACKFT : field<BBC0_AMCS, 7, 1> {};
+};
+
+struct BBC0_AMEDT : reg<0x0341, true> {};
+
+struct BBC0_AMAACKPD : reg<0x0342, true> {};
+
+struct BBC0_AMAACKTL : reg<0x0343, true> {};
+
+struct BBC0_AMAACKTH : reg<0x0344, true> {};
+
+struct BBC0_FSKC0 : reg<0x0360, true> {
+    struct MORD : field<BBC0_FSKC0, 0, 1> {};
+    struct MIDX : field<BBC0_FSKC0, 1, 3> {};
+    struct MIDXS : field<BBC0_FSKC0, 4, 2> {};
+    struct BT : field<BBC0_FSKC0, 6, 2> {};
+};
+
+struct BBC0_FSKC1 : reg<0x0361, true> {
+    struct SRATE : field<BBC0_FSKC1, 0, 4> {};
+    struct FI : field<BBC0_FSKC1, 5, 1> {};
+    struct FSKPLH : field<BBC0_FSKC1, 6, 2> {};
+};
+
+struct BBC0_FSKC2 : reg<0x0362, true> {
+    struct FECIE : field<BBC0_FSKC2, 0, 1> {};
+    struct FECS : field<BBC0_FSKC2, 1, 1> {};
+    struct PRI : field<BBC0_FSKC2, 2, 1> {};
+    struct MSE : field<BBC0_FSKC2, 3, 1> {};
+    struct RXPTO : field<BBC0_FSKC2, 4, 1> {};
+    struct RXO : field<BBC0_FSKC2, 5, 2> {};
+    struct PDTM : field<BBC0_FSKC2, 7, 1> {};
+};
+
+struct BBC0_FSKC3 : reg<0x0363, true> {
+    struct PDT : field<BBC0_FSKC3, 0, 4> {};
+    struct SFDT : field<BBC0_FSKC3, 4, 4> {};
+};
+
+struct BBC0_FSKC4 : reg<0x0364, true> {
+    struct CSFD0 : field<BBC0_FSKC4, 0, 2> {};
+    struct CSFD1 : field<BBC0_FSKC4, 2, 2> {};
+    struct RAWRBIT : field<BBC0_FSKC4, 4, 1> {};
+    struct SFD32 : field<BBC0_FSKC4, 5, 1> {};
+    struct SFDQ : field<BBC0_FSKC4, 6, 1> {};
+};
+
+struct BBC0_FSKPLL : reg<0x0365, true> {};
+
+struct BBC0_FSKSFD0L : reg<0x0366, true> {};
+
+struct BBC0_FSKSFD0H : reg<0x0367, true> {};
+
+struct BBC0_FSKSFD1L : reg<0x0368, true> {};
+
+struct BBC0_FSKSFD1H : reg<0x0369, true> {};
+
+struct BBC0_FSKPHRTX : reg<0x036A, true> {
+    struct RB1 : field<BBC0_FSKPHRTX, 0, 1> {};
+    struct RB2 : field<BBC0_FSKPHRTX, 1, 1> {};
+    struct DW : field<BBC0_FSKPHRTX, 2, 1> {};
+    struct SFD : field<BBC0_FSKPHRTX, 3, 1> {};
+};
+
+struct BBC0_FSKPHRRX : reg<0x036B, true> {};
+
+struct BBC0_FSKRPC : reg<0x036C, true> {};
+
+struct BBC0_FSKRPCONT : reg<0x036D, true> {};
+
+struct BBC0_FSKRPCOFFT : reg<0x036E, true> {};
+
+struct BBC0_FSKRRXFLL : reg<0x0370, true> {};
+
+struct BBC0_FSKRRXFLH : reg<0x0371, true> {};
+
+struct BBC0_FSKDM : reg<0x0372, true> {
+    struct EN : field<BBC0_FSKDM, 0, 1> {};
+    struct PE : field<BBC0_FSKDM, 1, 1> {};
+};
+
+struct BBC0_FSKPE0 : reg<0x0373, true> {};
+
+struct BBC0_FSKPE1 : reg<0x0374, true> {};
+
+struct BBC0_FSKPE2 : reg<0x0375, true> {};
+
+struct BBC1_FBRXE : reg<0x37FE> {};
+
+struct BBC0_PMUC : reg<0x0380, true> {};
+
+struct BBC1_FBTXS : reg<0x3800> {};
+
+struct BBC0_PMUVAL : reg<0x0381, true> {};
+
+struct BBC0_PMUQF : reg<0x0382, true> {};
+
+struct BBC0_PMUI : reg<0x0383, true> {};
+
+struct BBC0_PMUQ : reg<0x0384, true> {};
+
+struct BBC0_CNTC : reg<0x0390, true> {};
+
+struct BBC0_CNT0 : reg<0x0391, true> {};
+
+struct BBC0_CNT1 : reg<0x0392, true> {};
+
+struct BBC0_CNT2 : reg<0x0393, true> {};
+
+struct BBC0_CNT3 : reg<0x0394, true> {};
+
+struct BBC1_FBTXE : reg<0x3FFE> {};
+
+struct BBC1_IRQM : reg<0x0400> {
+    struct RXFS : field<BBC1_IRQM, 0, 1> {};
+    struct RXFE : field<BBC1_IRQM, 1, 1> {};
+    struct RXAM : field<BBC1_IRQM, 2, 1> {};
+    struct RXEM : field<BBC1_IRQM, 3, 1> {};
+    struct TXFE : field<BBC1_IRQM, 4, 1> {};
+    struct AGCH : field<BBC1_IRQM, 5, 1> {};
+    struct AGCR : field<BBC1_IRQM, 6, 1> {};
+    struct FBLI : field<BBC1_IRQM, 7, 1> {};
+};
+
+struct BBC1_PC : reg<0x0401> {
+    struct PT : field<BBC1_PC, 0, 2> {};
+    struct BBEN : field<BBC1_PC, 2, 1> {};
+    struct FCST : field<BBC1_PC, 3, 1> {};
+    struct TXAFCS : field<BBC1_PC, 4, 1> {};
+    struct FCSOK : field<BBC1_PC, 5, 1> {};
+    struct FCSFE : field<BBC1_PC, 6, 1> {};
+    struct CTX : field<BBC1_PC, 7, 1> {};
+};
+
+struct BBC1_PS : reg<0x0402> {};
+
+struct BBC1_RXFLL : reg<0x0404> {};
+
+struct BBC1_RXFLH : reg<0x0405> {};
+
+struct BBC1_TXFLL : reg<0x0406> {};
+
+struct BBC1_TXFLH : reg<0x0407> {};
+
+struct BBC1_FBLL : reg<0x0408> {};
+
+struct BBC1_FBLH : reg<0x0409> {};
+
+struct BBC1_FBLIL : reg<0x040A> {};
+
+struct BBC1_FBLIH : reg<0x040B> {};
+
+struct BBC1_OFDMPHRTX : reg<0x040C> {};
+
+struct BBC1_OFDMPHRRX : reg<0x040D> {};
+
+struct BBC1_OFDMC : reg<0x040E> {};
+
+struct BBC1_OFDMSW : reg<0x040F> {};
+
+struct BBC1_OQPSKC0 : reg<0x0410> {};
+
+struct BBC1_OQPSKC1 : reg<0x0411> {};
+
+struct BBC1_OQPSKC2 : reg<0x0412> {};
+
+struct BBC1_OQPSKC3 : reg<0x0413> {};
+
+struct BBC1_OQPSKPHRTX : reg<0x0414> {};
+
+struct BBC1_OQPSKPHRRX : reg<0x0415> {};
+
+struct BBC1_AFC0 : reg<0x0420> {};
+
+struct BBC1_AFC1 : reg<0x0421> {};
+
+struct BBC1_AFFTM : reg<0x0422> {};
+
+struct BBC1_AFFVM : reg<0x0423> {};
+
+struct BBC1_AFS : reg<0x0424> {};
+
+struct BBC1_MACEA0 : reg<0x0425> {};
+
+struct BBC1_MACEA1 : reg<0x0426> {};
+
+struct BBC1_MACEA2 : reg<0x0427> {};
+
+struct BBC1_MACEA3 : reg<0x0428> {};
+
+struct BBC1_MACEA4 : reg<0x0429> {};
+
+struct BBC1_MACEA5 : reg<0x042A> {};
+
+struct BBC1_MACEA6 : reg<0x042B> {};
+
+struct BBC1_MACEA7 : reg<0x042C> {};
+
+struct BBC1_MACPID0F0 : reg<0x042D> {};
+
+struct BBC1_MACPID1F0 : reg<0x042E> {};
+
+struct BBC1_MACSHA0F0 : reg<0x042F> {};
+
+struct BBC1_MACSHA1F0 : reg<0x0430> {};
+
+struct BBC1_MACPID0F1 : reg<0x0431> {};
+
+struct BBC1_MACPID1F1 : reg<0x0432> {};
+
+struct BBC1_MACSHA0F1 : reg<0x0433> {};
+
+struct BBC1_MACSHA1F1 : reg<0x0434> {};
+
+struct BBC1_MACPID0F2 : reg<0x0435> {};
+
+struct BBC1_MACPID1F2 : reg<0x0436> {};
+
+struct BBC1_MACSHA0F2 : reg<0x0437> {};
+
+struct BBC1_MACSHA1F2 : reg<0x0438> {};
+
+struct BBC1_MACPID0F3 : reg<0x0439> {};
+
+struct BBC1_MACPID1F3 : reg<0x043A> {};
+
+struct BBC1_MACSHA0F3 : reg<0x043B> {};
+
+struct BBC1_MACSHA1F3 : reg<0x043C> {};
+
+struct BBC1_AMCS : reg<0x0440> {
+    struct TX2RX : field<BBC1_AMCS, 0, 1> {};
+    struct CCATX : field<BBC1_AMCS, 1, 1> {};
+    struct CCAED : field<BBC1_AMCS, 2, 1> {};
+    struct AACK : field<BBC1_AMCS, 3, 1> {};
+    struct AACKS : field<BBC1_AMCS, 4, 1> {};
+    struct AACKDR : field<BBC1_AMCS, 5, 1> {};
+    struct AACKFA : field<BBC1_AMCS, 6, 1> {};
+    struct AACKFT : field<BBC1_AMCS, 7, 1> {};
+};
+
+struct BBC1_AMEDT : reg<0x0441> {};
+
+struct BBC1_AMAACKPD : reg<0x0442> {};
+
+struct BBC1_AMAACKTL : reg<0x0443> {};
+
+struct BBC1_AMAACKTH : reg<0x0444> {};
+
+struct BBC1_FSKC0 : reg<0x0460> {
+    struct MORD : field<BBC1_FSKC0, 0, 1> {};
+    struct MIDX : field<BBC1_FSKC0, 1, 3> {};
+    struct MIDXS : field<BBC1_FSKC0, 4, 2> {};
+    struct BT : field<BBC1_FSKC0, 6, 2> {};
+};
+
+struct BBC1_FSKC1 : reg<0x0461> {
+    struct SRATE : field<BBC1_FSKC1, 0, 4> {};
+    struct FI : field<BBC1_FSKC1, 5, 1> {};
+    struct FSKPLH : field<BBC1_FSKC1, 6, 2> {};
+};
+
+struct BBC1_FSKC2 : reg<0x0462> {
+    struct FECIE : field<BBC1_FSKC2, 0, 1> {};
+    struct FECS : field<BBC1_FSKC2, 1, 1> {};
+    struct PRI : field<BBC1_FSKC2, 2, 1> {};
+    struct MSE : field<BBC1_FSKC2, 3, 1> {};
+    struct RXPTO : field<BBC1_FSKC2, 4, 1> {};
+    struct RXO : field<BBC1_FSKC2, 5, 2> {};
+    struct PDTM : field<BBC1_FSKC2, 7, 1> {};
+};
+
+struct BBC1_FSKC3 : reg<0x0463> {
+    struct PDT : field<BBC1_FSKC3, 0, 4> {};
+    struct SFDT : field<BBC1_FSKC3, 4, 4> {};
+};
+
+struct BBC1_FSKC4 : reg<0x0464> {
+    struct CSFD0 : field<BBC1_FSKC4, 0, 2> {};
+    struct CSFD1 : field<BBC1_FSKC4, 2, 2> {};
+    struct RAWRBIT : field<BBC1_FSKC4, 4, 1> {};
+    struct SFD32 : field<BBC1_FSKC4, 5, 1> {};
+    struct SFDQ : field<BBC1_FSKC4, 6, 1> {};
+};
+
+struct BBC1_FSKPLL : reg<0x0465> {};
+
+struct BBC1_FSKSFD0L : reg<0x0466> {};
+
+struct BBC1_FSKSFD0H : reg<0x0467> {};
+
+struct BBC1_FSKSFD1L : reg<0x0468> {};
+
+struct BBC1_FSKSFD1H : reg<0x0469> {};
+
+struct BBC1_FSKPHRTX : reg<0x046A> {
+    struct RB1 : field<BBC1_FSKPHRTX, 0, 1> {};
+    struct RB2 : field<BBC1_FSKPHRTX, 1, 1> {};
+    struct DW : field<BBC1_FSKPHRTX, 2, 1> {};
+    struct SFD : field<BBC1_FSKPHRTX, 3, 1> {};
+};
+
+struct BBC1_FSKPHRRX : reg<0x046B> {};
+
+struct BBC1_FSKRPC : reg<0x046C> {};
+
+struct BBC1_FSKRPCONT : reg<0x046D> {};
+
+struct BBC1_FSKRPCOFFT : reg<0x046E> {};
+
+struct BBC1_FSKRRXFLL : reg<0x0470> {};
+
+struct BBC1_FSKRRXFLH : reg<0x0471> {};
+
+struct BBC1_FSKDM : reg<0x0472> {
+    struct EN : field<BBC1_FSKDM, 0, 1> {};
+    struct PE : field<BBC1_FSKDM, 1, 1> {};
+};
+
+struct BBC1_FSKPE0 : reg<0x0473> {};
+
+struct BBC1_FSKPE1 : reg<0x0474> {};
+
+struct BBC1_FSKPE2 : reg<0x0475> {};
+
+struct BBC1_PMUC : reg<0x0480> {};
+
+struct BBC1_PMUVAL : reg<0x0481> {};
+
+struct BBC1_PMUQF : reg<0x0482> {};
+
+struct BBC1_PMUI : reg<0x0483> {};
+
+struct BBC1_PMUQ : reg<0x0484> {};
+
+struct BBC1_CNTC : reg<0x0490> {};
+
+struct BBC1_CNT0 : reg<0x0491> {};
+
+struct BBC1_CNT1 : reg<0x0492> {};
+
+struct BBC1_CNT2 : reg<0x0493> {};
+
+struct BBC1_CNT3 : reg<0x0494> {};
+
+} // namespace at86rf215_regs
+
+#endif /* AT86RF215_REGS_HPP */
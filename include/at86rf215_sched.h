@@ -0,0 +1,86 @@
+/*
+ * at86rf215_sched.h
+ *
+ * Dual radio scheduler. RF09 and RF24 each get a work queue, kept in
+ * h->priv.radios[]. at86rf215_sched_poll() advances both radios by one
+ * bounded step in turn, so the SPI bus interleaves fairly between them and
+ * both bands can carry traffic at once.
+ *
+ * A TX work with a frequency in a duty_cycle.h sub-band is held at the head
+ * of its queue until the budget of the sub-band can take the frame, and is
+ * charged when the TX command is issued. Its timeout covers the wait.
+ */
+#ifndef AT86RF215_SCHED_H
+#define AT86RF215_SCHED_H
+
+#include <stdbool.h>
+#include <at86rf215.h>
+#include <frame_pool.h>
+#include <duty_cycle.h>
+
+/**
+ * Bytes of frame buffer written per TX step. Bounds the time one radio
+ * holds the SPI bus before the other radio gets its turn
+ */
+#ifndef AT86RF215_SCHED_CHUNK
+#define AT86RF215_SCHED_CHUNK (64)
+#endif
+
+typedef enum
+{
+  AT86RF215_WORK_TX = 0, //!< Transmit a frame pool block
+  AT86RF215_WORK_RX,     //!< Arm the RX pipeline and enter RX
+  AT86RF215_WORK_SCAN    //!< Run an energy detection scan
+} at86rf215_work_type_t;
+
+typedef enum
+{
+  AT86RF215_WORK_IDLE = 0,
+  AT86RF215_WORK_QUEUED,
+  AT86RF215_WORK_ACTIVE,
+  AT86RF215_WORK_DONE
+} at86rf215_work_state_t;
+
+struct at86rf215_work;
+typedef void (*at86rf215_work_cb_t)(struct at86rf215 *h,
+                                    struct at86rf215_work *w);
+
+/**
+ * A unit of work for one radio. The memory is owned by the caller and
+ * should stay valid until the completion callback
+ */
+struct at86rf215_work
+{
+  struct at86rf215_work          *next;       /**< Private */
+  at86rf215_work_type_t           type;
+  struct frame_buf               *buf;        /**< TX: the frame. Released by
+                                                 the scheduler */
+  struct at86rf215_scan          *scan;       /**< SCAN: the scan */
+  uint32_t                        freq_hz;    /**< TX: carrier frequency,
+                                                 for the duty cycle
+                                                 accounting. 0 to skip it */
+  uint32_t                        airtime_us; /**< TX: set by the
+                                                 scheduler */
+  uint32_t                        timeout_us; /**< 0 for no timeout */
+  at86rf215_work_cb_t             done;       /**< Called from
+                                                 at86rf215_sched_poll(),
+                                                 may be NULL */
+  void                           *arg;
+  volatile at86rf215_work_state_t state;
+  int                             status;     /**< 0 or negative error code */
+};
+
+int
+at86rf215_sched_init(struct at86rf215 *h);
+
+int
+at86rf215_sched_submit(struct at86rf215 *h, at86rf215_radio_t radio,
+                       struct at86rf215_work *w);
+
+void
+at86rf215_sched_poll(struct at86rf215 *h);
+
+bool
+at86rf215_sched_idle(struct at86rf215 *h);
+
+#endif /* AT86RF215_SCHED_H */
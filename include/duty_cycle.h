@@ -0,0 +1,66 @@
+/*
+ * duty_cycle.h
+ *
+ * Airtime accounting against regulatory duty-cycle limits. Each sub-band
+ * has its own limit over a sliding window. Every transmission is recorded
+ * with the time its last symbol leaves the air and counts against the
+ * budget until a full window has passed since then, so the budget frees up
+ * frame by frame instead of at fixed period boundaries.
+ *
+ * Times are milliseconds of a free running clock given by the caller, e.g.
+ * at86rf215_get_time_ms(), which the board implements on timebase_ms(). It
+ * must wrap at 32 bits. Not safe from interrupt context.
+ */
+#ifndef DUTY_CYCLE_H
+#define DUTY_CYCLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Sub-bands that can be registered */
+#ifndef DUTY_CYCLE_BANDS
+#define DUTY_CYCLE_BANDS        8
+#endif
+
+/*
+ * Transmissions remembered per sub-band. When full, the two oldest are
+ * merged and expire with the later one, which only errs on the safe side.
+ */
+#ifndef DUTY_CYCLE_RECORDS
+#define DUTY_CYCLE_RECORDS      32
+#endif
+
+/* Returned for frequencies outside of every registered sub-band */
+#define DUTY_CYCLE_UNLIMITED    UINT32_MAX
+
+struct duty_cycle_stats
+{
+    uint32_t budget_us;     /* allowed airtime per window */
+    uint32_t used_us;       /* airtime in the current window */
+    uint32_t frames;        /* transmissions charged */
+    uint32_t denied;        /* duty_cycle_allowed() refusals */
+    uint32_t merges;        /* records merged because the ring was full */
+};
+
+void duty_cycle_init(void);
+
+int duty_cycle_band_add(uint32_t lo_hz, uint32_t hi_hz, uint32_t ppm,
+                        uint32_t window_ms);
+
+int duty_cycle_band(uint32_t freq_hz);
+
+uint32_t duty_cycle_available_us(uint32_t freq_hz, uint32_t now_ms);
+
+bool duty_cycle_allowed(uint32_t freq_hz, uint32_t airtime_us,
+                        uint32_t now_ms);
+
+uint32_t duty_cycle_wait_ms(uint32_t freq_hz, uint32_t airtime_us,
+                            uint32_t now_ms);
+
+void duty_cycle_charge(uint32_t freq_hz, uint32_t airtime_us, uint32_t now_ms);
+
+bool duty_cycle_stats(int band, uint32_t now_ms,
+                      struct duty_cycle_stats *stats);
+
+#endif /* DUTY_CYCLE_H */
@@ -0,0 +1,155 @@
+/*
+ * frag.h
+ *
+ * Fragmentation of messages larger than a frame. The sender streams each
+ * fragment into the TX frame buffer straight from a scatter-gather list,
+ * without staging copies: the header and the first FRAG_LEAD bytes are
+ * uploaded, TX is started, and the rest of the fragment is uploaded while
+ * its SHR and first bytes are on air. The SPI has to outrun the PHY, which
+ * holds for any MR-FSK rate.
+ *
+ * The receiver keeps the frame pool blocks of the RX pipeline: a message is
+ * reassembled in place, as the list of its fragment blocks, and handed over
+ * as a scatter-gather list. So a message needs one pool block per fragment,
+ * of the fragment frame size, on top of FRAG_RX_RESERVE blocks left to the
+ * RX pipeline: with the default FRAME_POOL_CLASSES, only one full sized
+ * fragment fits. frag_tx_start() refuses the messages that a receiver with
+ * the same pool could not hold, the receiver drops them too, and drops a
+ * partial message as soon as keeping it would eat into the reserve. Size
+ * the pool for FRAG_MAX_FRAGS fragments of the frag_len in use. Partial
+ * messages that get no fragment for FRAG_RX_TIMEOUT_US are dropped.
+ *
+ * Fragment layout, FCS excluded:
+ *   FRAG_TYPE, message id, fragment index, offset (24-bit LE),
+ *   total length (24-bit LE), payload
+ *
+ * All fragments but the last carry frag_len bytes, so the offset of each is
+ * its index times frag_len. A fragment that breaks this, or that disagrees
+ * on frag_len with the ones already held, is malformed and drops the
+ * partial message.
+ */
+#ifndef FRAG_H
+#define FRAG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <at86rf215.h>
+#include <frame_pool.h>
+
+/* Fragments per message, at most 32 */
+#ifndef FRAG_MAX_FRAGS
+#define FRAG_MAX_FRAGS          32
+#endif
+
+/* Pool blocks able to take a full frame left to the RX pipeline */
+#ifndef FRAG_RX_RESERVE
+#define FRAG_RX_RESERVE         1
+#endif
+
+/* Messages reassembled at once */
+#ifndef FRAG_RX_SLOTS
+#define FRAG_RX_SLOTS           2
+#endif
+
+/* Idle time after which a partial message is dropped */
+#ifndef FRAG_RX_TIMEOUT_US
+#define FRAG_RX_TIMEOUT_US      500000
+#endif
+
+/* Fragment bytes uploaded before the TX command */
+#ifndef FRAG_LEAD
+#define FRAG_LEAD               32
+#endif
+
+#define FRAG_TYPE               0xF3
+#define FRAG_HDR_LEN            9
+#define FRAG_MAX_TOTAL          0xFFFFFF
+
+struct frag_iov
+{
+    const uint8_t *base;
+    size_t         len;
+};
+
+struct frag_tx
+{
+    struct at86rf215       *h;
+    at86rf215_radio_t       radio;
+    const struct frag_iov  *iov;
+    size_t                  iovcnt;
+    uint32_t                total;
+    uint16_t                frag_len;   /* payload bytes per fragment */
+    uint8_t                 msg_id;
+    volatile uint8_t        busy;
+    int                     status;     /* 0 or negative error code */
+    /* Private */
+    uint8_t                 step;
+    uint8_t                 index;
+    uint32_t                offset;     /* of the current fragment */
+    size_t                  cur_iov;    /* source position of the upload */
+    size_t                  cur_off;
+    uint32_t                t0;
+    uint32_t                limit;      /* ticks, bound of the step */
+};
+
+struct frag_rx;
+
+/*
+ * Called from frag_rx_input() with the fragments of a complete message, in
+ * order. The list and the data are only valid during the call.
+ */
+typedef void (*frag_deliver_cb_t)(struct frag_rx *r, const struct frag_iov *iov,
+                                  size_t iovcnt, uint32_t total, void *arg);
+
+struct frag_rx_stats
+{
+    uint32_t fragments;     /* fragments taken */
+    uint32_t messages;      /* messages delivered */
+    uint32_t dups;
+    uint32_t expired;       /* partial messages timed out */
+    uint32_t evicted;       /* partial messages dropped for a new one */
+    uint32_t malformed;
+    uint32_t too_large;     /* messages dropped, more than the pool holds */
+};
+
+struct frag_rx_slot
+{
+    uint8_t           used;
+    uint8_t           msg_id;
+    uint32_t          total;
+    uint32_t          rcvd;         /* payload bytes */
+    uint32_t          mask;         /* fragments received */
+    uint8_t           nfrags;       /* highest index + 1 */
+    uint16_t          flen;         /* payload of all fragments but the last,
+                                       0 until the first one */
+    uint32_t          last;         /* timebase at the last fragment */
+    struct frame_buf *bufs[FRAG_MAX_FRAGS];
+    uint16_t          lens[FRAG_MAX_FRAGS];
+};
+
+struct frag_rx
+{
+    frag_deliver_cb_t     deliver;
+    void                 *arg;
+    struct frag_rx_slot   slots[FRAG_RX_SLOTS];
+    struct frag_iov       iov[FRAG_MAX_FRAGS];  /* private */
+    struct frag_rx_stats  stats;
+};
+
+int frag_tx_start(struct frag_tx *t, struct at86rf215 *h,
+                  at86rf215_radio_t radio, const struct frag_iov *iov,
+                  size_t iovcnt, uint16_t frag_len, uint8_t msg_id);
+
+int frag_tx_poll(struct frag_tx *t);
+
+void frag_tx_cancel(struct frag_tx *t);
+
+void frag_rx_init(struct frag_rx *r, frag_deliver_cb_t deliver, void *arg);
+
+bool frag_rx_input(struct frag_rx *r, struct at86rf215 *h,
+                   struct at86rf215_rx_pkt *pkt);
+
+void frag_rx_expire(struct frag_rx *r);
+
+#endif /* FRAG_H */
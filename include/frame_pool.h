@@ -0,0 +1,61 @@
+/*
+ * frame_pool.h
+ *
+ * Fixed-block frame buffer pool. No heap is used: every block is carved out
+ * of a static arena at start-up, so the RAM cost is known at link time.
+ * Allocation and release are O(1) and safe from interrupt context.
+ */
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <at86rf215.h>
+
+/*
+ * Block classes as X(block size, number of blocks), in ascending block size.
+ * Requests are served from the smallest class that fits and fall back to the
+ * larger ones when it is exhausted. Override it at build time to size the
+ * RAM of the target application.
+ */
+#ifndef FRAME_POOL_CLASSES
+#define FRAME_POOL_CLASSES(X)       \
+    X(64,                   8)      \
+    X(256,                  4)      \
+    X(AT86RF215_MAX_PDU,    2)
+#endif
+
+struct frame_buf
+{
+    struct frame_buf   *next;   /* private, free list link */
+    uint8_t            *data;
+    uint16_t            size;   /* capacity of data */
+    uint16_t            len;    /* valid bytes, maintained by the user */
+    uint8_t             cls;    /* private */
+    volatile uint8_t    refs;   /* private */
+};
+
+struct frame_pool_stats
+{
+    uint16_t size;          /* block size of the class */
+    uint16_t total;         /* number of blocks of the class */
+    uint16_t in_use;        /* blocks currently allocated */
+    uint16_t high_water;    /* maximum of in_use since start-up */
+    uint32_t fails;         /* requests that found no free block */
+};
+
+void frame_pool_init(void);
+
+struct frame_buf *frame_buf_alloc(size_t len);
+
+void frame_buf_ref(struct frame_buf *buf);
+
+void frame_buf_free(struct frame_buf *buf);
+
+size_t frame_pool_num_classes(void);
+
+int frame_pool_get_stats(size_t cls, struct frame_pool_stats *stats);
+
+size_t frame_pool_free_blocks(size_t len);
+
+#endif /* FRAME_POOL_H */
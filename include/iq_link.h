@@ -0,0 +1,71 @@
+/*
+ * iq_link.h
+ *
+ * Health counters of the LVDS I/Q interface between the FPGA and the
+ * AT86RF215. The counters are maintained by the IQIFSF and TRXERR IRQ
+ * handlers, so reading them costs no SPI traffic and no transient failure
+ * goes unnoticed.
+ */
+#ifndef IQ_LINK_H
+#define IQ_LINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <at86rf215.h>
+
+/*
+ * Bound of a recovery attempt, from the sync failure until the link is seen
+ * in sync again. An attempt that overruns it is restarted.
+ */
+#define IQ_LINK_RECOVER_TIMEOUT_US  1000
+/* Bound of the wait for the FPGA samples valid edge in iq_link_start() */
+#define IQ_LINK_START_TIMEOUT_US    1000
+
+/*
+ * Serializer clock of the FPGA (clk_out1, rtl/topModule.v) and the reset
+ * low time in its periods: 2 for the rst_n_sync flops, 1 for iq_valid to
+ * drop, the rest margin
+ */
+#define IQ_LINK_FPGA_CLK_HZ         64000000
+#define IQ_LINK_FPGA_RESET_CLOCKS   8
+
+struct iq_link_stats
+{
+    uint32_t sync_fail;         /* IQIFSF IRQs */
+    uint32_t failsafe;          /* entries into the failsafe, IQIFC1.FAILSF */
+    uint32_t tx_err;            /* TRXERR IRQs */
+    uint32_t in_sync_ms;        /* time spent with IQIFC2.SYNC set */
+    uint32_t last_fail;         /* cycle counter at the last sync failure */
+    uint32_t recoveries;        /* recoveries that got the link back in sync */
+    uint32_t recover_timeouts;  /* attempts restarted after the timeout */
+    uint32_t recover_last_us;   /* sync failure to TX re-armed, last recovery */
+    uint32_t recover_max_us;
+    uint32_t recover_sum_us;    /* over all recoveries, for the average */
+    uint32_t last_start;        /* cycle counter at the last samples valid edge */
+    uint32_t start_valid_us;    /* FPGA release to samples valid */
+    uint32_t start_tx_cycles;   /* samples valid edge to TX commanded */
+    uint32_t start_tx_max_cycles;
+    uint8_t  synced;            /* IQIFC2.SYNC as last observed */
+    uint8_t  failsafe_active;   /* IQIFC1.FAILSF as last observed */
+    uint8_t  recovering;        /* a recovery is in progress */
+};
+
+int iq_link_init(struct at86rf215 *h, at86rf215_radio_t radio);
+
+int iq_link_refresh(struct at86rf215 *h);
+
+void iq_link_get(struct iq_link_stats *stats);
+
+void iq_link_reset(void);
+
+void iq_link_set_recovery(bool enable);
+
+int iq_link_poll(struct at86rf215 *h);
+
+int iq_link_start(struct at86rf215 *h);
+
+void iq_link_samples_valid(struct at86rf215 *h, uint32_t cycles);
+
+void iq_link_fpga_hold(bool hold);
+
+#endif /* IQ_LINK_H */
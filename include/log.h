@@ -0,0 +1,51 @@
+/*
+ * log.h
+ *
+ * Deferred binary logger. A message is its id (log_ids.h) and its integer
+ * arguments, encoded into a RAM ring; the DMA drains the ring to the
+ * eUSCI_A2 UART (TX on P3.3) in the background. Logging a message costs a
+ * few microseconds and never waits for the UART, tools/log_decode.cpp
+ * turns the byte stream back into text.
+ *
+ * Frame: LOG_SYNC, id, payload length, then LEB128 varints: the
+ * microseconds since the previous frame, followed by the arguments.
+ */
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <log_ids.h>
+
+/* UART rate, from SMCLK */
+#ifndef LOG_BAUD
+#define LOG_BAUD (115200)
+#endif
+
+/* Bytes of the ring, should be a power of 2 */
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE (1024)
+#endif
+
+/* Most arguments a message can carry */
+#define LOG_MAX_ARGS (8)
+
+#define LOG_SYNC (0xA5)
+
+void log_init(void);
+
+bool log_write(log_id_t id, size_t nargs, const uint32_t *args);
+
+bool log_idle(void);
+
+uint32_t log_dropped(void);
+
+/* LOG(id, args...) for one or more integer arguments */
+#define LOG(id, ...)                                                          \
+    log_write((id), sizeof((uint32_t[]) { __VA_ARGS__ }) / sizeof(uint32_t), \
+              (const uint32_t[]) { __VA_ARGS__ })
+
+#define LOG0(id) log_write((id), 0, NULL)
+
+#endif /* LOG_H */
@@ -0,0 +1,29 @@
+/*
+ * log_ids.h
+ *
+ * Messages of the deferred logger as X(id, format). Only the id and the
+ * arguments leave the MCU; tools/log_decode.cpp reads this file to expand
+ * them again, so entries should only be appended and keep one per line.
+ * Supported conversions: %u %d %x %X %c %%, with optional flags and width.
+ */
+#ifndef LOG_IDS_H
+#define LOG_IDS_H
+
+#define LOG_IDS(X) \
+    X(LOG_DROPPED,      "log: %u messages dropped") \
+    X(LOG_VERSION,      "version = %x") \
+    X(LOG_BOOT_TIMES,   "boot: init %u us, image %u us, txprep %u us, first I/Q %u us") \
+    X(LOG_IQ_STATUS,    "failsafe = %u sync = %u iqifsf = %u trxrdy = %u txerr = %u sync_failed = %u") \
+    X(LOG_IQ_RECOVERY,  "recovery: %u done, %u timeouts, last %u us, max %u us, avg %u us") \
+    X(LOG_IQ_START,     "I/Q start: samples valid %u us after release, TX %u cycles after valid") \
+    X(LOG_IQ_HEALTH,    "sync = %u failsafe = %u sync_fail = %u failsafe_entries = %u tx_err = %u in_sync = %u ms")
+
+#define LOG_ID_ENUM(id, fmt) id,
+
+typedef enum
+{
+    LOG_IDS(LOG_ID_ENUM)
+    LOG_ID_NUM
+} log_id_t;
+
+#endif /* LOG_IDS_H */
@@ -0,0 +1,76 @@
+/*
+ * mode_switch.h
+ *
+ * Fast switching of one radio between two profiles (profile.h), e.g. the
+ * FPGA I/Q chip mode and the internal baseband. mode_switch_init()
+ * precomputes, in each direction, the registers whose value differs
+ * between the two images, so a switch only writes those, in coalesced
+ * bursts, instead of a TRXOFF and a complete reconfiguration.
+ *
+ * A switch honours the TRXOFF window the chip needs for its configuration:
+ * a baseband frame on air is let to finish, up to MODE_SWITCH_TIMEOUT_US,
+ * an I/Q transmission is stopped, TRXOFF is commanded until the radio
+ * reaches it and only then the delta is written. The radio is optionally
+ * brought to TXPREP or RX afterwards, and the time of each step reported.
+ *
+ * Registers given by only one of the profiles keep their value across
+ * switches, so each profile should give all registers its mode depends on.
+ */
+#ifndef MODE_SWITCH_H
+#define MODE_SWITCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <at86rf215.h>
+#include <profile.h>
+
+/* Registers of a delta, at most the size of the target profile */
+#ifndef MODE_SWITCH_MAX_REGS
+#define MODE_SWITCH_MAX_REGS    32
+#endif
+
+/* Bound of each state wait: end of a frame, TRXOFF, TXPREP or RX */
+#ifndef MODE_SWITCH_TIMEOUT_US
+#define MODE_SWITCH_TIMEOUT_US  20000
+#endif
+
+struct mode_switch_latency
+{
+    uint32_t trxoff_us;     /* until TRXOFF, 0 if the radio was there */
+    uint32_t apply_us;      /* delta written */
+    uint32_t ready_us;      /* requested state reached after the delta */
+    uint32_t total_us;
+    uint8_t  regs;          /* registers written */
+};
+
+struct mode_switch_stats
+{
+    uint32_t switches;      /* profile changes */
+    uint32_t regs_written;
+    uint32_t regs_skipped;  /* registers of the profiles left alone */
+    uint32_t max_us;        /* longest profile change */
+};
+
+struct mode_switch
+{
+    struct at86rf215         *h;
+    at86rf215_radio_t         radio;
+    const struct profile     *prof[2];
+    uint8_t                   cur;      /* profile applied */
+    /* Private, delta[i] leads from the other profile to prof[i] */
+    struct at86rf215_reg_val  delta[2][MODE_SWITCH_MAX_REGS];
+    size_t                    ndelta[2];
+    struct mode_switch_stats  stats;
+};
+
+int mode_switch_init(struct mode_switch *ms, struct at86rf215 *h,
+                     at86rf215_radio_t radio, const struct profile *a,
+                     const struct profile *b);
+
+int mode_switch_to(struct mode_switch *ms, uint8_t which,
+                   at86rf215_rf_cmd_t next, struct mode_switch_latency *lat);
+
+void mode_switch_get_stats(const struct mode_switch *ms,
+                           struct mode_switch_stats *stats);
+
+#endif /* MODE_SWITCH_H */
@@ -0,0 +1,51 @@
+/*
+ * profile.h
+ *
+ * Radio configurations kept in flash as sorted register images and played
+ * back with at86rf215_reg_image_apply(), a few SPI bursts instead of the
+ * register by register sequences of AT86RF215TxSetIQ() and friends. The
+ * images are generated into Src/profile_images.h by tools/profile_gen.cpp,
+ * from the typed fields of at86rf215_profile.hpp, along with the baseband
+ * configuration read back from their registers.
+ *
+ * A profile does not change the radio state. Apply it in TRXOFF, then move
+ * to TXPREP or RX as usual. A profile with a baseband also becomes the
+ * baseband configuration of the driver (h->priv.bbc), the one airtime,
+ * ARQ and fragmentation work from.
+ */
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <at86rf215.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct profile
+{
+    const char                     *name;
+    at86rf215_radio_t               radio;
+    const struct at86rf215_reg_val *img;
+    size_t                          n;
+    const struct at86rf215_bb_conf *bbc;  /* what img sets, NULL without baseband */
+};
+
+/* RF09 streaming the FPGA I/Q samples at 4 MHz, 910 MHz */
+extern const struct profile profile_iq_rf09;
+
+/* RF09 with the BBC0 2-FSK baseband, 100 ksym/s, 910 MHz */
+extern const struct profile profile_fsk_rf09;
+
+int profile_apply(struct at86rf215 *h, const struct profile *p);
+
+/* Records the baseband of p in h, for registers of p written some other way */
+void profile_track(struct at86rf215 *h, const struct profile *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROFILE_H */
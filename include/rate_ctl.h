@@ -0,0 +1,109 @@
+/*
+ * rate_ctl.h
+ *
+ * Adaptive MR-FSK rate selection. The application gives a ladder of
+ * baseband configurations, from the most robust to the fastest, each with
+ * the link level it needs. rate_ctl_init() runs at86rf215_bb_conf() once
+ * per rung and captures the resulting registers as an image, so switching
+ * rungs later costs a handful of SPI bursts (at86rf215_reg_image_apply())
+ * instead of a full reconfiguration.
+ *
+ * Each peer gets averages of the RSSI and EDV of its frames and of the
+ * delivery success of the frames sent to it. A peer climbs one rung once
+ * its level clears the next rung with RATE_CTL_HYST_DB to spare and its
+ * success stays high, and falls back as soon as either drops.
+ *
+ * Both ends have to agree on the rung: either both run the controller on
+ * the same link, or the application announces the switch to the peer.
+ */
+#ifndef RATE_CTL_H
+#define RATE_CTL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <at86rf215.h>
+
+#ifndef RATE_CTL_MAX_RUNGS
+#define RATE_CTL_MAX_RUNGS      6
+#endif
+
+/* Bound of the TRXOFF transition in rate_ctl_apply(), a frame on air included */
+#ifndef RATE_CTL_TRXOFF_TIMEOUT_US
+#define RATE_CTL_TRXOFF_TIMEOUT_US  20000
+#endif
+
+#ifndef RATE_CTL_MAX_PEERS
+#define RATE_CTL_MAX_PEERS      8
+#endif
+
+/* Extra level needed on top of the threshold of the next rung to climb */
+#ifndef RATE_CTL_HYST_DB
+#define RATE_CTL_HYST_DB        4
+#endif
+
+/* Outcomes on a rung before it is judged, after a change */
+#ifndef RATE_CTL_MIN_SAMPLES
+#define RATE_CTL_MIN_SAMPLES    8
+#endif
+
+/* Success ratio, out of 256, to climb and below which to fall back */
+#ifndef RATE_CTL_UP_SUCCESS
+#define RATE_CTL_UP_SUCCESS     240
+#endif
+#ifndef RATE_CTL_DOWN_SUCCESS
+#define RATE_CTL_DOWN_SUCCESS   160
+#endif
+
+/* RF and baseband registers written by at86rf215_bb_conf() for MR-FSK */
+#define RATE_CTL_IMG_LEN        25
+
+struct rate_ctl_rung
+{
+    struct at86rf215_bb_conf conf;      /* MR-FSK configuration */
+    int8_t                   min_dbm;   /* link level it needs */
+    /* Private */
+    struct at86rf215_reg_val img[RATE_CTL_IMG_LEN];
+};
+
+struct rate_ctl_peer
+{
+    uint16_t addr;
+    uint8_t  used;
+    uint8_t  rung;
+    uint8_t  level_valid;   /* a frame of the peer was received */
+    int16_t  rssi_q4;       /* averages in 1/16 dBm */
+    int16_t  edv_q4;
+    uint16_t success;       /* average, out of 256 */
+    uint16_t samples;       /* outcomes since the last change */
+    uint32_t ups;
+    uint32_t downs;
+};
+
+struct rate_ctl
+{
+    struct at86rf215        *h;
+    at86rf215_radio_t        radio;
+    struct rate_ctl_rung    *rungs;
+    uint8_t                  nrungs;
+    uint8_t                  active;    /* rung applied to the radio */
+    uint32_t                 switches;  /* images applied */
+    struct rate_ctl_peer     peers[RATE_CTL_MAX_PEERS];
+};
+
+int rate_ctl_init(struct rate_ctl *rc, struct at86rf215 *h,
+                  at86rf215_radio_t radio, struct rate_ctl_rung *rungs,
+                  size_t nrungs);
+
+void rate_ctl_rx(struct rate_ctl *rc, uint16_t addr,
+                 const struct at86rf215_rx_pkt *pkt);
+
+void rate_ctl_tx_result(struct rate_ctl *rc, uint16_t addr, bool delivered);
+
+int rate_ctl_rung(struct rate_ctl *rc, uint16_t addr);
+
+int rate_ctl_apply(struct rate_ctl *rc, uint8_t rung);
+
+int rate_ctl_select(struct rate_ctl *rc, uint16_t addr);
+
+#endif /* RATE_CTL_H */
@@ -25,6 +25,7 @@ Maintainer: Mehrdad Hessar, Ali Najafi
 #define _SYSTEM_SPI_H_
 #include <stdio.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <msp.h>
 #include <driverlib.h>
 
@@ -38,12 +39,79 @@ extern volatile unsigned char SPI_RXData_Flash;
 
 /* SPI object type definition */
 
+/*
+ * Data phases of at least SPI_DMA_MIN_LEN bytes are moved by the DMA
+ * (CH0 = eUSCI_B0 TX, CH1 = eUSCI_B0 RX) instead of one interrupt per byte.
+ */
+#define SPI_DMA_MIN_LEN     16
+
+/* Devices sharing the eUSCI_B0 bus */
+typedef enum
+{
+    SPI_CLIENT_IQRADIO = 0,
+    SPI_CLIENT_LORA,
+    SPI_CLIENT_FPGA,
+    SPI_CLIENT_FLASH,
+    SPI_CLIENT_NUM
+} SpiClient_t;
+
+/*
+ * Job priorities, lowest value is served first. Ordering only happens at job
+ * boundaries: a job never gets interrupted once its CS window is open, so
+ * bulk transfers that must not delay IRQ reads should be submitted in chunks.
+ */
+typedef enum
+{
+    SPI_PRIO_IRQ = 0,   /* status reads issued from interrupt context */
+    SPI_PRIO_HIGH,
+    SPI_PRIO_NORMAL,
+    SPI_PRIO_BULK,      /* frame buffer uploads, flash pages */
+    SPI_PRIO_NUM
+} SpiPriority_t;
+
+typedef enum
+{
+    SPI_JOB_IDLE = 0,
+    SPI_JOB_QUEUED,
+    SPI_JOB_ACTIVE,
+    SPI_JOB_DONE
+} SpiJobState_t;
+
+struct SpiJob;
+typedef void (*SpiJobCallback_t)(struct SpiJob *job);
+
+/*
+ * A single CS-framed transfer. The hdr bytes (command/address) are clocked
+ * first and their MISO bytes are dropped, then len data bytes follow. A NULL
+ * tx clocks out 0x00, a NULL rx discards the MISO data. The job memory is
+ * owned by the caller and must stay valid until the callback has run.
+ */
+typedef struct SpiJob
+{
+    struct SpiJob          *next;
+    SpiClient_t             client;
+    SpiPriority_t           prio;
+    uint_fast8_t            cs_port;
+    uint_fast16_t           cs_pin;
+    uint8_t                 hdr[4];
+    uint8_t                 hdr_len;
+    const uint8_t          *tx;
+    uint8_t                *rx;
+    uint16_t                len;
+    SpiJobCallback_t        done;   /* called from the EUSCIB0 ISR, may be NULL */
+    void                   *arg;
+    volatile SpiJobState_t  state;
+    uint16_t                pos;    /* private */
+} SpiJob_t;
+
 /**#############################Clock#############################**/
 #define CLK_FREQ_8M     1
 #define CLK_FREQ_16M    2
 #define CLK_FREQ_24M    3
+#define CLK_FREQ_25M    4
 
-#define CLK_FREQ        CLK_FREQ_8M
+/* MCLK runs from MODOSC (25 MHz), see ClockInit() */
+#define CLK_FREQ        CLK_FREQ_25M
 
 #if CLK_FREQ == CLK_FREQ_8M
 #define CYCLES_mS      8000
@@ -51,11 +119,35 @@ extern volatile unsigned char SPI_RXData_Flash;
 #define CYCLES_mS      16000
 #elif CLK_FREQ == CLK_FREQ_24M
 #define CYCLES_mS      24000
+#elif CLK_FREQ == CLK_FREQ_25M
+#define CYCLES_mS      25000
 #else
 #define CYCLES_mS      8000
 #endif
 
 #define CYCLES_us   CYCLES_mS/1000
+
+/**#############################Cycle counter#############################**/
+/* DWT cycle counter, free running at MCLK. Wraps, so only use differences. */
+void cycle_counter_init(void);
+
+/* MCLK cycles per microsecond, taken from CS_getMCLK() by cycle_counter_init() */
+extern uint32_t cycle_counter_mhz;
+
+static inline uint32_t cycle_counter_get(void)
+{
+    return DWT->CYCCNT;
+}
+
+static inline uint32_t cycles_to_us(uint32_t cycles)
+{
+    return cycles / cycle_counter_mhz;
+}
+
+static inline uint32_t us_to_cycles(uint32_t us)
+{
+    return us * cycle_counter_mhz;
+}
 /**#############################Functions#############################**/
 void SpiInit(void);
 
@@ -67,6 +159,17 @@ uint8_t fpgaSpiInOut(uint8_t outData);
 
 uint8_t flashSpiInOut(uint8_t outData);
 
+void SpiJobInit(void);
+bool SpiJobSubmit(SpiJob_t *job);
+bool SpiJobBusy(void);
+
+typedef void (*SpiBusDeferred_t)(void *arg);
+
+bool SpiBusLock(void);
+void SpiBusUnlock(void);
+bool SpiBusDefer(SpiBusDeferred_t fn, void *arg);
+uint32_t SpiBusBusyDrops(void);
+
 void delay_ms(uint32_t msTime);
 void delay_us(uint32_t usTime);
 
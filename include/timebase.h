@@ -0,0 +1,60 @@
+/*
+ * timebase.h
+ *
+ * 32-bit timebase on Timer_A0, counting SMCLK ticks. The 16-bit counter is
+ * extended in software by its overflow IRQ. CCR0 serves the compare
+ * alarm. Each of CCR1..4 either captures rising edges of its CCIxA input
+ * with the timebase value, or serves a compare of its own, so periodic work
+ * does not have to share the alarm.
+ */
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Capture/compare units of Timer_A0 */
+#define TIMEBASE_CCR_NUM    5
+
+/*
+ * Called from the TA0_0 (alarm) or TA0_N (compare) ISR with the timebase
+ * value at its entry
+ */
+typedef void (*timebase_alarm_cb_t)(uint32_t now, void *arg);
+
+/* Called from the TA0_N ISR with the timebase value latched by the edge */
+typedef void (*timebase_capture_cb_t)(uint32_t ts, void *arg);
+
+void timebase_init(void);
+
+uint32_t timebase_now(void);
+
+uint32_t timebase_ms(void);
+
+uint32_t timebase_hz(void);
+
+uint32_t timebase_us_to_ticks(uint32_t us);
+
+uint32_t timebase_ticks_to_us(uint32_t ticks);
+
+bool timebase_alarm_set(uint32_t at, timebase_alarm_cb_t cb, void *arg);
+
+void timebase_alarm_cancel(void);
+
+bool timebase_compare_set(uint8_t ccr, uint32_t at, timebase_alarm_cb_t cb,
+                          void *arg);
+
+void timebase_compare_cancel(uint8_t ccr);
+
+bool timebase_capture_set(uint8_t ccr, timebase_capture_cb_t cb, void *arg);
+
+void timebase_capture_enable(uint8_t ccr, bool enable);
+
+/* Wrap-safe a - b, positive when a is later than b */
+static inline int32_t timebase_diff(uint32_t a, uint32_t b)
+{
+    return (int32_t) (a - b);
+}
+
+#endif /* TIMEBASE_H */
@@ -0,0 +1,110 @@
+/*
+ * trace.h
+ *
+ * Binary trace ring. Each event is an 8 byte record stamped with the DWT
+ * cycle counter, so a trace point costs a few dozen cycles instead of the
+ * milliseconds of a printf and can stay enabled in production. The ring
+ * keeps the last TRACE_LEN records; tools/trace_decode.cpp turns a memory
+ * dump of trace_ring into a timeline.
+ *
+ * Register accesses are recorded at the SPI level. Commands and state reads
+ * are the accesses to RFn_CMD and RFn_STATE, the decoder names them.
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <msp.h>
+#include <spi_helper.h>
+
+/* Set to 0 to compile every trace point out */
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE (1)
+#endif
+
+/* Records kept by the ring, should be a power of 2 */
+#ifndef TRACE_LEN
+#define TRACE_LEN (256)
+#endif
+
+#if TRACE_LEN & (TRACE_LEN - 1)
+#error "TRACE_LEN should be a power of 2"
+#endif
+
+#define TRACE_MAGIC (0x31435254) /* "TRC1" */
+
+typedef enum
+{
+    TRACE_NONE = 0,     /* slot never written */
+    TRACE_REG_READ,     /* a: value, b: register */
+    TRACE_REG_WRITE,    /* a: value, b: register */
+    TRACE_BURST_READ,   /* a: length, saturated at 255, b: first register */
+    TRACE_BURST_WRITE,  /* a: length, saturated at 255, b: first register */
+    TRACE_IRQ_RF,       /* a: RF09_IRQS, b: RF24_IRQS */
+    TRACE_IRQ_BB,       /* a: BBC0_IRQS, b: BBC1_IRQS */
+    TRACE_FPGA_RESET,   /* a: 0 held in reset, 1 released */
+    TRACE_USER,         /* a, b: application defined */
+    TRACE_BUS_BUSY      /* a: 0 write, 1 read, b: register; dropped, bus taken */
+} trace_type_t;
+
+struct trace_rec
+{
+    uint32_t cycles;
+    uint8_t  type;
+    uint8_t  a;
+    uint16_t b;
+};
+
+/* Memory layout seen by the decoder, keep tools/trace_decode.cpp in sync */
+struct trace_ring
+{
+    uint32_t          magic;
+    uint32_t          len;              /* TRACE_LEN */
+    uint32_t          cycles_per_us;
+    volatile uint32_t head;             /* records written since trace_init() */
+    volatile uint32_t enabled;
+    struct trace_rec  rec[TRACE_LEN];
+};
+
+extern struct trace_ring trace_ring;
+
+void trace_init(void);
+
+void trace_enable(bool enable);
+
+size_t trace_copy(struct trace_rec *out, size_t max);
+
+#if TRACE_ENABLE
+/*
+ * Appends a record, overwriting the oldest one. Lock-free and safe from any
+ * interrupt context: a preemption between the LDREX and the STREX makes the
+ * claim retry, so every writer owns its slot.
+ */
+static inline void trace_put(trace_type_t type, uint8_t a, uint16_t b)
+{
+    uint32_t idx;
+    if (!trace_ring.enabled)
+    {
+        return;
+    }
+    do
+    {
+        idx = __LDREXW(&trace_ring.head);
+    } while (__STREXW(idx + 1, &trace_ring.head));
+
+    struct trace_rec *r = &trace_ring.rec[idx & (TRACE_LEN - 1)];
+    r->cycles = cycle_counter_get();
+    r->type = type;
+    r->a = a;
+    r->b = b;
+}
+#else
+#define trace_put(type, a, b) ((void) 0)
+#endif
+
+/* Burst records keep the length in a byte */
+#define TRACE_LEN8(len) ((uint8_t) ((len) > 0xFF ? 0xFF : (len)))
+
+#endif /* TRACE_H */
@@ -0,0 +1,51 @@
+/*
+ * tx_timed.h
+ *
+ * Transmission at a given timebase tick. The frame is uploaded to the frame
+ * buffer when requested, TXPREP is issued from a timebase alarm
+ * TX_TIMED_TXPREP_US ahead of the slot and RF_CMD_TX from another alarm at
+ * the slot itself, so the start does not depend on state polling.
+ *
+ * Both commands are queued from the TA0_0 ISR as SPI_PRIO_IRQ jobs, so the
+ * alarm never waits on the bus. They go out as soon as the transfer in
+ * flight ends, or the blocking transaction of the code the alarm preempted;
+ * that delay shows up in the report. The application should not access the
+ * radio over SPI from the TXPREP alarm until the frame started.
+ */
+#ifndef TX_TIMED_H
+#define TX_TIMED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <at86rf215.h>
+
+/* TRXOFF to TXPREP, PLL settling included */
+#ifndef TX_TIMED_TXPREP_US
+#define TX_TIMED_TXPREP_US      200
+#endif
+
+/* Smallest lead left between tx_timed_at() returning and the TXPREP alarm */
+#ifndef TX_TIMED_MARGIN_US
+#define TX_TIMED_MARGIN_US      20
+#endif
+
+struct tx_timed_report
+{
+    uint32_t requested;     /* the slot, timebase ticks */
+    uint32_t fired;         /* TA0_0 ISR entry */
+    uint32_t achieved;      /* RF_CMD_TX written, end of its SPI job */
+    int32_t  error_ticks;   /* achieved - requested */
+    uint8_t  trxrdy;        /* TXPREP was reached before the slot */
+    int      status;        /* 0 or negative error code of TXPREP or TX */
+};
+
+int tx_timed_at(struct at86rf215 *h, at86rf215_radio_t radio,
+                const uint8_t *psdu, size_t len, uint32_t at);
+
+bool tx_timed_pending(void);
+
+bool tx_timed_report(struct tx_timed_report *report);
+
+void tx_timed_cancel(void);
+
+#endif /* TX_TIMED_H */
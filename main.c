@@ -66,9 +66,37 @@
 #include <msp.h>
 #include <stdio.h>
 #include "spi_helper.h"
+#include "frame_pool.h"
+#include "trace.h"
+#include "log.h"
+#include "iq_link.h"
+#include "timebase.h"
+#include "profile.h"
 #include <regs.h>
 #include <at86rf215Regs.h>
 
+/*
+ * Set to 1 to boot through at86rf215_init() and the I/Q register image of
+ * profile_iq_rf09, instead of the fixed reset delays, the RF_VN polling and
+ * AT86RF215TxSetIQ()
+ */
+#ifndef FAST_BOOT
+#define FAST_BOOT 0
+#endif
+
+/* Bound of each wait of the fast boot */
+#define FAST_BOOT_TIMEOUT_US    1000
+
+/* Period of the I/Q link status check */
+#define STATUS_PERIOD_US        1000
+/* Status periods between two messages when the link counters do not move */
+#define STATUS_HEARTBEAT        1000
+
+/* The AT86RF215 IRQ on P2.3 is mapped to TA0.CCI1A */
+#define RADIO_IRQ_CCR           1
+/* Compare of the status tick, the alarm (CCR0) belongs to tx_timed */
+#define STATUS_CCR              2
+
 
 /* Statics */
 static volatile uint8_t transmitData = 0x01, receiveData = 0x00;
@@ -92,6 +120,30 @@ void FPGAreset(void);
 
 
 static void at86_fsk_900_tx_demo(void);
+static int radio_init(void);
+static void radio_irq_init(void);
+static void status_arm(uint32_t now);
+static void status_tick(uint32_t now, void *arg);
+
+/* Status tick, on its own timebase compare */
+static uint32_t status_at = 0;
+static volatile bool status_due = false;
+
+#if FAST_BOOT
+/* Boot milestones, in microseconds since the end of ClockInit() */
+struct boot_times
+{
+    uint32_t init_us;       /* IC awake and identified */
+    uint32_t image_us;      /* I/Q image written */
+    uint32_t txprep_us;     /* TRXRDY after TXPREP */
+    uint32_t first_iq_us;   /* FPGA samples valid, RF09 sent to TX */
+};
+
+static struct boot_times boot;
+static volatile uint8_t boot_trxrdy = 0;
+
+static int fast_boot(uint32_t t0);
+#endif
 typedef enum
 {
     CLK_MCLK = 0,
@@ -108,6 +160,7 @@ void gpio_init() {
  GPIO_setAsInputPin(GPIO_PORT_P2, GPIO_PIN3); //irq
  GPIO_setAsOutputPin(GPIO_PORT_P3, GPIO_PIN7); // RESETN --FPGA
  MAP_GPIO_setAsInputPinWithPullDownResistor(GPIO_PORT_P2, GPIO_PIN3);
+ GPIO_setAsInputPin(GPIO_PORT_P2, GPIO_PIN4); // samples valid --FPGA
 
 }
 
@@ -116,12 +169,16 @@ int main(void)
     /* Halting WDT  */
     WDTCTL = WDTPW | WDTHOLD;
     ClockInit();
+    cycle_counter_init();
+    trace_init();
+#if FAST_BOOT
+    uint32_t boot_t0 = cycle_counter_get();
+#endif
     //
 
     volatile uint32_t i;
     gpio_init();
-    AT86RF215Reset();
-    GpioSetInterrupt(GPIO_PORT_P2, GPIO_PIN3, GPIO_LOW_TO_HIGH_TRANSITION);
+    GpioSetInterrupt(GPIO_PORT_P2, GPIO_PIN4, GPIO_LOW_TO_HIGH_TRANSITION);
 
     //![Simple SPI Example]
     /* Selecting P1.5 P1.6 and P1.7 in SPI mode */
@@ -134,29 +191,39 @@ int main(void)
     /* Enable SPI module */
     SPI_enableModule(EUSCI_B0_BASE);
 
-    /* Enabling interrupts */
-    SPI_enableInterrupt(EUSCI_B0_BASE, EUSCI_SPI_RECEIVE_INTERRUPT);
-    Interrupt_enableInterrupt(INT_EUSCIB0);
+    /* Enabling interrupts: the RX interrupt is only armed while a queued job runs */
+    SpiJobInit();
+    frame_pool_init();
+    log_init();
+    timebase_init();
+    radio_irq_init();
     //EUSCI_B_SPI_enableInterrupt(EUSCI_B0_BASE, EUSCI_B_SPI_RECEIVE_INTERRUPT);
 
 
     /* Polling to see if the TX buffer is ready */
     while (!(SPI_getInterruptStatus(EUSCI_B0_BASE,EUSCI_SPI_TRANSMIT_INTERRUPT)));
 
-     uint8_t version = AT86RF215Read(REG_RF_VN );
-
-     printf("version = %x\n"
-             "",version);
-                  //  fflush(stdout);
-     while (version != 0x03)
+#if FAST_BOOT
+    modem_state = AT86RF215_RF09;
+    if (fast_boot(boot_t0))
+    {
+        GPIO_setAsOutputPin(GPIO_PORT_P2, GPIO_PIN2);
+    }
+    LOG(LOG_BOOT_TIMES, boot.init_us, boot.image_us, boot.txprep_us,
+        boot.first_iq_us);
+#else
+     /* Resets the IC and brings up the driver IRQ path, the link counters need it */
+     while (radio_init())
      {
          GPIO_setAsOutputPin(
          GPIO_PORT_P2,
          GPIO_PIN2
          );
          delay_us(1000);
-         version = AT86RF215Read(REG_RF_VN);
      }
+     uint8_t version = AT86RF215Read(REG_RF_VN );
+
+     LOG(LOG_VERSION, version);
       modem_state = AT86RF215_RF09; // for 09 command // modem is set here
 
 
@@ -174,6 +241,7 @@ int main(void)
              delay_us(100);
              /* Set RESET pin to 0 */
       GPIO_setOutputLowOnPin(GPIO_PORT_P3, GPIO_PIN7); // fpga in reset mode --- so sending zeroes now
+      trace_put(TRACE_FPGA_RESET, 0, 0);
 
 
 
@@ -181,38 +249,186 @@ int main(void)
      // AT86RF215TxSetIQ_old(920000000);
       delay_ms(1);
       //FPGAreset();
-      AT86RF215Write(REG_RF09_CMD, RF_CMD_TX);
-      /* FPGA firmware load */
-        delay_us(10);
+      iq_link_init(&ctx, AT86RF215_RF09);
+      /* Releases the FPGA and commands TX on its samples valid edge */
+      if (iq_link_start(&ctx))
+      {
+          GPIO_setAsOutputPin(GPIO_PORT_P2, GPIO_PIN2);
+      }
+#endif
+
+    struct iq_link_stats link;
+    iq_link_get(&link);
+    LOG(LOG_IQ_START, link.start_valid_us, link.start_tx_cycles);
+
+    /* Sync loss restarts the I/Q path by itself, see iq_link_fpga_hold() */
+    iq_link_set_recovery(true);
+
+    struct iq_link_stats logged = { 0 };
+    uint32_t heartbeat = STATUS_HEARTBEAT;
+    status_at = timebase_now();
+    status_arm(status_at);
+    while (1)
+    {
+        /* Failures come from the IRQ path, only sync acquisition raises no IRQ */
+        iq_link_get(&link);
+        if (link.recovering)
+        {
+            iq_link_poll(&ctx);
+            iq_link_get(&link);
+        }
+        else if (!link.synced)
+        {
+            iq_link_refresh(&ctx);
+            iq_link_get(&link);
+        }
+        if (link.recoveries != logged.recoveries
+                || link.recover_timeouts != logged.recover_timeouts)
+        {
+            LOG(LOG_IQ_RECOVERY, link.recoveries, link.recover_timeouts,
+                link.recover_last_us, link.recover_max_us,
+                link.recoveries ? link.recover_sum_us / link.recoveries : 0);
+            logged.recoveries = link.recoveries;
+            logged.recover_timeouts = link.recover_timeouts;
+        }
+
+        /* Queued for the UART DMA, the loop never waits for it */
+        if (link.sync_fail != logged.sync_fail || link.failsafe != logged.failsafe
+                || link.tx_err != logged.tx_err || link.synced != logged.synced
+                || ++heartbeat >= STATUS_HEARTBEAT)
+        {
+            LOG(LOG_IQ_HEALTH, link.synced, link.failsafe_active, link.sync_fail,
+                link.failsafe, link.tx_err, link.in_sync_ms);
+            logged = link;
+            heartbeat = 0;
+        }
+
+        /* The IRQs run meanwhile, the core sleeps between them */
+        while (!status_due)
+        {
+            __disable_irq();
+            if (!status_due)
+            {
+                /* Still woken by an IRQ pended while masked */
+                __WFI();
+            }
+            __enable_irq();
+        }
+        status_due = false;
+    }
+}
 
-        GPIO_setOutputHighOnPin(GPIO_PORT_P3, GPIO_PIN7); // release the reset on the fpga now so that it sends clear data
-       //FPGAreset();
 
-        while (1) {
-                     uint8_t val = AT86RF215Read(REG_RF_IQIFC1);
-                                uint8_t bit7 = (val >> 7) & 0x01;
+/*
+ * Arms the next status tick. status_at advances by whole periods, so a late
+ * loop does not push the following ones back; the periods already missed
+ * are skipped.
+ */
+static void status_arm(uint32_t now)
+{
+    const uint32_t period = timebase_us_to_ticks(STATUS_PERIOD_US);
+    do
+    {
+        status_at += period;
+    } while (timebase_diff(now, status_at) >= 0);
+    if (!timebase_compare_set(STATUS_CCR, status_at, status_tick, NULL))
+    {
+        status_tick(timebase_now(), NULL);
+    }
+}
 
-                                uint8_t flsync = AT86RF215Read(REG_RF_IQIFC2);
-                                uint8_t sync = (flsync >> 7) & 0x01;   // <-- fixed
+static void status_tick(uint32_t now, void *arg)
+{
+    (void) arg;
+    status_due = true;
+    status_arm(now);
+}
 
-                               // IQIFC0.SF-> indicates synchronization failure (1= sync failed)
-                                uint8_t meh =  AT86RF215Read(REG_RF_IQIFC0);
-                                uint8_t no_sync = (meh >>6) & 0x01;
+
+static int radio_init(void)
+{
+    /* Clock, crystal and pad settings of the board */
+    ctx.clko_os = AT86RF215_RF_CLKO_26_MHZ;
+    ctx.clk_drv = AT86RF215_RF_DRVCLKO4;
+    ctx.rf_femode_09 = AT86RF215_RF_FEMODE0;
+    ctx.rf_femode_24 = AT86RF215_RF_FEMODE0;
+    ctx.xo_fs = 1;
+    ctx.xo_trim = 8;
+    ctx.irqmm = 0;
+    ctx.irqp = 0;               /* active high, P2.3 triggers on the rising edge */
+    ctx.pad_drv = AT86RF215_RF_DRV4;
+
+    return at86rf215_init(&ctx);
+}
 
 
-                                uint8_t irq = AT86RF215Read(REG_RF09_IRQS);
-                                uint8_t irqfsf = (irq>>5 ) & 0x01;
+#if FAST_BOOT
+static void boot_trxrdy_handler(struct at86rf215 *h, at86rf215_radio_t radio,
+                                void *arg)
+{
+    boot_trxrdy = 1;
+}
 
-                                uint8_t trxrdy = (irq>>1) & 0x01;
+static int fast_boot(uint32_t t0)
+{
+    int ret;
 
-                                uint8_t txerr = (irq>>4) & 0x01;
-                                printf("failsafe value = %d  and sync = %d and irq_fail_safe_interrupt = %d  and trxrdy = %d  and txerr = %d and failed_sync = %d \n", bit7, sync, irqfsf, trxrdy, txerr,no_sync);
+    /* The FPGA streams zeroes while in reset */
+    GPIO_setOutputLowOnPin(GPIO_PORT_P3, GPIO_PIN7);
+    trace_put(TRACE_FPGA_RESET, 0, 0);
 
-                                delay_ms(50);   // slow down for UART
-                 }
+    ret = radio_init();
+    if (ret)
+    {
+        return ret;
+    }
+    boot.init_us = cycles_to_us(cycle_counter_get() - t0);
 
+    ret = profile_apply(&ctx, &profile_iq_rf09);
+    if (ret)
+    {
+        return ret;
+    }
+    boot.image_us = cycles_to_us(cycle_counter_get() - t0);
+
+    /* TRXRDY of TXPREP replaces the fixed 1 ms wait */
+    boot_trxrdy = 0;
+    at86rf215_irq_register(&ctx, AT86RF215_IRQ_SRC_RF09, AT86RF215_RF_IRQ_TRXRDY,
+                           boot_trxrdy_handler, NULL);
+    ret = at86rf215_set_cmd(&ctx, AT86RF215_CMD_RF_TXPREP, AT86RF215_RF09);
+    if (ret)
+    {
+        return ret;
+    }
+    uint32_t t = cycle_counter_get();
+    while (!boot_trxrdy)
+    {
+        if (cycles_to_us(cycle_counter_get() - t) > FAST_BOOT_TIMEOUT_US)
+        {
+            return -AT86RF215_TIMEOUT;
+        }
+    }
+    at86rf215_irq_register(&ctx, AT86RF215_IRQ_SRC_RF09, AT86RF215_RF_IRQ_TRXRDY,
+                           NULL, NULL);
+    boot.txprep_us = cycles_to_us(cycle_counter_get() - t0);
 
+    ret = iq_link_init(&ctx, AT86RF215_RF09);
+    if (ret)
+    {
+        return ret;
+    }
+    /* TX is commanded on the FPGA samples valid edge */
+    ret = iq_link_start(&ctx);
+    if (ret)
+    {
+        return ret;
+    }
+    struct iq_link_stats link;
+    iq_link_get(&link);
+    boot.first_iq_us = cycles_to_us(link.last_start - t0);
+    return AT86RF215_OK;
 }
+#endif
 
 
 void ClockInit( void )
@@ -230,6 +446,100 @@ void ClockInit( void )
 }
 
 
+/* The FPGA I/Q stream is held in reset with P3.7 low */
+void iq_link_fpga_hold(bool hold)
+{
+    if (hold)
+    {
+        GPIO_setOutputLowOnPin(GPIO_PORT_P3, GPIO_PIN7);
+    }
+    else
+    {
+        GPIO_setOutputHighOnPin(GPIO_PORT_P3, GPIO_PIN7);
+    }
+    trace_put(TRACE_FPGA_RESET, hold ? 0 : 1, 0);
+}
+
+
+/* FPGA samples valid on P2.4 */
+void PORT2_IRQHandler(void)
+{
+    uint32_t now = cycle_counter_get();
+    uint_fast16_t status = MAP_GPIO_getEnabledInterruptStatus(GPIO_PORT_P2);
+    MAP_GPIO_clearInterruptFlag(GPIO_PORT_P2, status);
+
+    if (status & GPIO_PIN4)
+    {
+        iq_link_samples_valid(&ctx, now);
+    }
+}
+
+
+/* The IRQ came while the preempted code was on the SPI bus */
+static void radio_irq_deferred(void *arg)
+{
+    (void) arg;
+    at86rf215_irq_callback(&ctx);
+}
+
+
+/* AT86RF215 IRQ line, from the TA0_N ISR with the edge captured by TA0 */
+static void radio_irq_captured(uint32_t ts, void *arg)
+{
+    (void) arg;
+    /* Dates the edge for the latency statistics too, not the ISR entry */
+    const uint32_t late = us_to_cycles(timebase_ticks_to_us(timebase_now() - ts));
+    at86rf215_irq_stamp(&ctx, cycle_counter_get() - late);
+    at86rf215_irq_capture(&ctx, ts);
+    if (at86rf215_irq_callback(&ctx) == -AT86RF215_BUS_BUSY)
+    {
+        /* IRQS unread, the line stays high until PendSV gets to it */
+        SpiBusDefer(radio_irq_deferred, NULL);
+    }
+}
+
+
+/*
+ * Routes P2.3 to the TA0 capture input, so the timebase latches the IRQ
+ * edge in hardware and the ISR entry latency does not show in the RX
+ * timestamps. Should be called after timebase_init().
+ */
+static void radio_irq_init(void)
+{
+    /* Port 2 defaults, but P2.3 on TA0.CCI1A in place of P2.4, a GPIO here */
+    static const uint8_t p2_map[8] = {
+        PM_UCA1STE, PM_UCA1CLK, PM_UCA1RXD, PM_TA0CCR1A,
+        PM_NONE, PM_TA0CCR2A, PM_TA0CCR3A, PM_TA0CCR4A
+    };
+
+    PMAP_configurePorts(p2_map, PMAP_P2MAP, 1, PMAP_DISABLE_RECONFIGURATION);
+    GPIO_setAsPeripheralModuleFunctionInputPin(GPIO_PORT_P2, GPIO_PIN3,
+                                               GPIO_PRIMARY_MODULE_FUNCTION);
+    timebase_capture_set(RADIO_IRQ_CCR, radio_irq_captured, NULL);
+}
+
+
+/* Driver timeouts and the duty cycle accounting run on the timebase */
+size_t at86rf215_get_time_ms(struct at86rf215 *h)
+{
+    (void) h;
+    return timebase_ms();
+}
+
+
+/* The radio IRQ is the TA0 capture, see radio_irq_init() */
+int at86rf215_irq_enable(struct at86rf215 *h, uint8_t enable)
+{
+    if (!h)
+    {
+        return -AT86RF215_INVAL_PARAM;
+    }
+    /* A capture latched while masked stays pending, like the GPIO edge */
+    timebase_capture_enable(RADIO_IRQ_CCR, enable);
+    return AT86RF215_OK;
+}
+
+
 void GpioSetInterrupt( uint_fast8_t port, uint_fast16_t pin, uint_fast8_t irq_mode) {
     if (irq_mode == GPIO_LOW_TO_HIGH_TRANSITION )
     {
@@ -280,9 +590,11 @@ void FPGAreset(void){
        delay_us(100);
        /* Set RESET pin to 0 */
        GPIO_setOutputLowOnPin(GPIO_PORT_P3, GPIO_PIN7);
+       trace_put(TRACE_FPGA_RESET, 0, 0);
        /* Wait 10 us */
        delay_us(100);
        GPIO_setOutputHighOnPin(GPIO_PORT_P3, GPIO_PIN7);
+       trace_put(TRACE_FPGA_RESET, 1, 0);
       // delay_ms(100);
 
 //    GPIO_setOutputLowOnPin(GPIO_PORT_P3, GPIO_PIN7);
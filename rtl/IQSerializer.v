@@ -4,9 +4,12 @@ input                   clk,
 input                   start,
 input   [`ILength-1:0]  I,
 input   [`QLength-1:0]  Q,
+input                   eec,        // AT86RF215 embedded control, IQIFC0.EEC
+input                   tx_ctrl,    // with eec, keys the radio TX on and off
 output                  serial_N,
 output                  serial,
-output                  serial_clk
+output                  serial_clk,
+output reg              iq_valid    // first full I/Q word sent since start
 );
 
 parameter [0:0]	VCC = 1'b1;
@@ -20,6 +23,17 @@ parameter [3:0] Init0 = 4'h0, Init1 = 4'h1, ISYNC = 4'h2, IDATA  = 4'h3, QSYNC =
 (* syn_preserve = "TRUE" *) reg [3:0]   ICounter;
 (* syn_preserve = "TRUE" *) reg [3:0]   QCounter;
 
+/*
+*   Embedded control: the I LSB carries the TX control bit and the Q LSB stays
+*   0. tx_ctrl is sampled once per word so a word never changes it midway.
+*/
+reg                     tx_ctrl_word;
+wire [`ILength-1:0]     I_word;
+wire [`QLength-1:0]     Q_word;
+
+assign I_word = eec ? {I[`ILength-1:1], tx_ctrl_word} : I;
+assign Q_word = eec ? {Q[`QLength-1:1], VSS} : Q;
+
 //output clock
 assign serial_clk    = clk;
 
@@ -54,16 +68,16 @@ always @(*) begin
             DEDFF_D1 = VSS;
         end
         IDATA: begin
-            DEDFF_D0 = I[`ILength-ICounter-1];
-            DEDFF_D1 = I[`ILength-ICounter-2];
+            DEDFF_D0 = I_word[`ILength-ICounter-1];
+            DEDFF_D1 = I_word[`ILength-ICounter-2];
         end
         QSYNC: begin
             DEDFF_D0 = VSS;
             DEDFF_D1 = VCC;
         end
         QDATA: begin
-            DEDFF_D0 = Q[`QLength-QCounter-1];
-            DEDFF_D1 = Q[`QLength-QCounter-2];
+            DEDFF_D0 = Q_word[`QLength-QCounter-1];
+            DEDFF_D1 = Q_word[`QLength-QCounter-2];
         end
         default: begin
             DEDFF_D0 = VSS;
@@ -79,9 +93,14 @@ always @(negedge clk) begin
     if (start == VSS) begin
         ICounter    <= 4'd0;
         QCounter    <= 4'd0;
+        iq_valid    <= VSS;
+        tx_ctrl_word <= VSS;
         //I           <= `ILength'd0;
         //Q           <= `QLength'h0;
     end else begin
+        if (current_state == QDATA && QCounter == 4'd12) iq_valid <= VCC;
+        if (next_state == ISYNC)                         tx_ctrl_word <= tx_ctrl;
+
         if (current_state == IDATA) ICounter    <= ICounter + 4'd2;
         else                        ICounter    <= 4'd0;
 
@@ -1,3 +1,6 @@
 //IQ Defines
 `define ILength		14
 `define QLength		14
+
+//Embedded control, should match AT86RF215_IQ_EEC of the MCU
+`define EEC			1'b0
@@ -12,7 +12,8 @@ input       rxclk,//lvds
 input       rxd09,//lvds
 
 output serial_iq,
-output serial_clk
+output serial_clk,
+output samples_valid    // to the MCU, rises with the first I/Q word after reset
 //output clock_out,
 
 //output reg		LED,
@@ -46,6 +47,10 @@ wire				fskModule_start;
 wire [`ILength-1:0] IQSerializer_I;
 wire [`QLength-1:0]	IQSerializer_Q;
 wire 				IQSerializer_start;
+wire				IQSerializer_run;
+wire				IQSerializer_valid;
+
+reg		[1:0]		rst_n_sync;
 
 
 
@@ -69,6 +74,10 @@ assign	osc_en = 1'b1;
 assign IQSerializer_I = 14'b00000000000000;
 assign IQSerializer_Q = 14'b11111111111111;
 
+// The MCU holds the serializer with top_rst_n, samples_valid answers the release
+assign IQSerializer_run = IQSerializer_start & rst_n_sync[1];
+assign samples_valid = IQSerializer_valid;
+
 
 //assign serial_clk = clk_out1;
 
@@ -129,6 +138,11 @@ assign IQSerializer_Q = 14'b11111111111111;
 //IBUF ibuf_clk (.I(rxclk), .O(clk_in_ibuf));  
 //BUFG bufg_clk (.I(clk_in_ibuf), .O(clk_out1));     
 
+// top_rst_n comes from an MCU pin, bring it into the serializer clock domain
+always @(negedge clk_out1) begin
+	rst_n_sync <= {rst_n_sync[0], top_rst_n};
+end
+
 //------------------------------------------------------------------
 // Component instances
 //-------------------------------------------------------------------
@@ -175,12 +189,15 @@ FSKModulator fskModule_0(
 
 IQSerializer IQSerializer_0(
 	.clk(clk_out1),
-	.start(IQSerializer_start),
+	.start(IQSerializer_run),
 	.I(IQSerializer_I),
 	.Q(IQSerializer_Q),
+	.eec(`EEC),
+	.tx_ctrl(fskModule_start),	// the radio transmits for the packet only
 	.serial_N(serial_iq),
 	.serial(),
-	.serial_clk(serial_clk)
+	.serial_clk(serial_clk),
+	.iq_valid(IQSerializer_valid)
 );
 
 
@@ -0,0 +1,120 @@
+/*
+ * airtime_calc.cpp
+ *
+ * Prints the airtime and goodput of MR-FSK frames against the payload size,
+ * using the firmware calculator (Src/airtime.c) built for the host:
+ *
+ *   gcc -std=gnu99 -O2 -c -I../include ../Src/airtime.c
+ *   g++ -std=c++17 -O2 -I../include -o airtime_calc airtime_calc.cpp airtime.o
+ *   ./airtime_calc -r 50 -m 2 -p 8 -f -c 16 -g 1000 -n 16:2047:64
+ *
+ * -r symbol rate in ksym/s, -m modulation order (2 or 4), -p preamble
+ * octets, -f enables FEC, -s selects the 32-bit SFD, -c FCS size in bits,
+ * -g idle gap between frames in us, -n payload range as min:max:step.
+ */
+#include <airtime.h>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+namespace {
+
+bool srate_of(unsigned ksps, at86rf215_fsk_srate_t &srate)
+{
+    switch (ksps) {
+    case 50: srate = AT86RF215_FSK_SRATE_50; return true;
+    case 100: srate = AT86RF215_FSK_SRATE_100; return true;
+    case 150: srate = AT86RF215_FSK_SRATE_150; return true;
+    case 200: srate = AT86RF215_FSK_SRATE_200; return true;
+    case 300: srate = AT86RF215_FSK_SRATE_300; return true;
+    case 400: srate = AT86RF215_FSK_SRATE_400; return true;
+    default: return false;
+    }
+}
+
+void usage(const char *prog)
+{
+    std::cerr << "usage: " << prog
+              << " [-r ksps] [-m 2|4] [-p octets] [-f] [-s] [-c 16|32]"
+                 " [-g gap_us] [-n min:max:step]\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    unsigned ksps = 50;
+    unsigned order = 2;
+    unsigned preamble = 8;
+    bool fec = false;
+    bool sfd32 = false;
+    unsigned fcs = 16;
+    unsigned gap_us = 0;
+    unsigned min = 16, max = AT86RF215_MAX_PDU, step = 64;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool has_val = i + 1 < argc;
+        if (arg == "-r" && has_val) {
+            ksps = std::stoul(argv[++i]);
+        } else if (arg == "-m" && has_val) {
+            order = std::stoul(argv[++i]);
+        } else if (arg == "-p" && has_val) {
+            preamble = std::stoul(argv[++i]);
+        } else if (arg == "-f") {
+            fec = true;
+        } else if (arg == "-s") {
+            sfd32 = true;
+        } else if (arg == "-c" && has_val) {
+            fcs = std::stoul(argv[++i]);
+        } else if (arg == "-g" && has_val) {
+            gap_us = std::stoul(argv[++i]);
+        } else if (arg == "-n" && has_val
+                   && std::sscanf(argv[++i], "%u:%u:%u", &min, &max, &step) == 3) {
+            continue;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    struct at86rf215_bb_conf conf = {};
+    conf.pt = AT86RF215_BB_MRFSK;
+    conf.fcst = fcs == 32 ? AT86RF215_FCS_32 : AT86RF215_FCS_16;
+    conf.fsk.mord = order == 4 ? AT86RF215_4FSK : AT86RF215_2FSK;
+    conf.fsk.preamble_length = preamble;
+    conf.fsk.sfd32 = sfd32;
+    conf.fsk.sfd = 0;
+    conf.fsk.csfd0 = fec ? AT86RF215_SFD_CODED_IEEE : AT86RF215_SFD_UNCODED_IEEE;
+    if (!srate_of(ksps, conf.fsk.srate) || (order != 2 && order != 4)
+        || (fcs != 16 && fcs != 32) || !step || min > max) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const size_t fcs_len = airtime_fcs_len(&conf);
+    std::printf("%8s %8s %8s %10s %12s %6s\n", "payload", "shr_sym", "data_sym",
+                "airtime_us", "goodput_bps", "eff_%");
+    size_t best_len = 0;
+    uint32_t best_bps = 0;
+    for (size_t payload = min; payload <= max && payload + fcs_len <= AT86RF215_MAX_PDU;
+         payload += step) {
+        airtime a;
+        uint32_t bps = 0;
+        if (airtime_frame(&conf, payload + fcs_len, &a)
+            || airtime_goodput_bps(&conf, payload, gap_us, &bps)) {
+            std::cerr << "invalid configuration\n";
+            return 1;
+        }
+        // Raw bit rate of the PSDU part, the reference of the efficiency
+        const double raw = double(a.sym_rate_hz) * (order == 4 ? 2 : 1);
+        std::printf("%8zu %8u %8u %10u %12u %6.1f\n", payload, a.shr_sym, a.data_sym,
+                    a.us, bps, 100.0 * bps / raw);
+        if (bps > best_bps) {
+            best_bps = bps;
+            best_len = payload;
+        }
+    }
+    std::printf("best: %zu bytes, %u bps\n", best_len, best_bps);
+    return 0;
+}
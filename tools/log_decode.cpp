@@ -0,0 +1,243 @@
+/*
+ * log_decode.cpp
+ *
+ * Expands the binary stream of the deferred logger (include/log.h) into
+ * text. The format strings come from include/log_ids.h, so the tool does not
+ * need a rebuild when messages are added:
+ *
+ *   g++ -std=c++17 -O2 -o log_decode log_decode.cpp
+ *   stty -F /dev/ttyACM0 115200 raw
+ *   ./log_decode -i include/log_ids.h < /dev/ttyACM0
+ *
+ * A capture file can be given instead of stdin as the last argument.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t log_sync = 0xA5;
+// The time delta and LOG_MAX_ARGS arguments, 5 bytes per varint
+constexpr size_t max_payload = 5 * (1 + 8);
+
+struct message {
+    std::string name;
+    std::string fmt;
+    size_t nargs;
+};
+
+// Conversions consuming an argument, %% excluded
+size_t count_args(const std::string &fmt)
+{
+    size_t n = 0;
+    for (size_t i = 0; i + 1 < fmt.size(); i++) {
+        if (fmt[i] == '%') {
+            if (fmt[i + 1] == '%') {
+                i++;
+            } else {
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+std::string unescape(const std::string &s)
+{
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '\\' && i + 1 < s.size()) {
+            const char c = s[++i];
+            out += c == 'n' ? '\n' : c == 't' ? '\t' : c;
+        } else {
+            out += s[i];
+        }
+    }
+    return out;
+}
+
+std::vector<message> load_ids(const std::string &path)
+{
+    std::vector<message> ids;
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "cannot open " << path << "\n";
+        return ids;
+    }
+    // One X(id, "format") per line, in id order
+    const std::regex entry(R"(X\(\s*(\w+)\s*,\s*\"((?:[^\"\\]|\\.)*)\"\s*\))");
+    std::string line;
+    while (std::getline(in, line)) {
+        std::smatch m;
+        if (std::regex_search(line, m, entry)) {
+            std::string fmt = unescape(m[2]);
+            ids.push_back({m[1], fmt, count_args(fmt)});
+        }
+    }
+    return ids;
+}
+
+// printf with 32-bit integer arguments, one conversion at a time
+std::string expand(const std::string &fmt, const std::vector<uint32_t> &args)
+{
+    std::string out;
+    size_t a = 0;
+    for (size_t i = 0; i < fmt.size(); i++) {
+        if (fmt[i] != '%') {
+            out += fmt[i];
+            continue;
+        }
+        size_t j = i + 1;
+        while (j < fmt.size() && std::string("-+ #0123456789").find(fmt[j]) != std::string::npos) {
+            j++;
+        }
+        if (j >= fmt.size()) {
+            out += fmt.substr(i);
+            break;
+        }
+        const char conv = fmt[j];
+        const std::string spec = fmt.substr(i, j - i);
+        char buf[64];
+        if (conv == '%') {
+            out += '%';
+        } else if (a < args.size()) {
+            const uint32_t v = args[a++];
+            switch (conv) {
+            case 'd':
+            case 'i':
+                std::snprintf(buf, sizeof(buf), (spec + "d").c_str(), int32_t(v));
+                break;
+            case 'c':
+                std::snprintf(buf, sizeof(buf), (spec + "c").c_str(), int(v & 0xFF));
+                break;
+            case 'x':
+            case 'X':
+            case 'o':
+            case 'u':
+                std::snprintf(buf, sizeof(buf), (spec + conv).c_str(), unsigned(v));
+                break;
+            default:
+                std::snprintf(buf, sizeof(buf), "<%%%c?>", conv);
+                break;
+            }
+            out += buf;
+        } else {
+            out += "<missing>";
+        }
+        i = j;
+    }
+    return out;
+}
+
+bool get_varint(const std::vector<uint8_t> &p, size_t &pos, uint32_t &v)
+{
+    v = 0;
+    for (int shift = 0; shift < 35 && pos < p.size(); shift += 7) {
+        const uint8_t b = p[pos++];
+        v |= uint32_t(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void usage(const char *prog)
+{
+    std::cerr << "usage: " << prog << " -i log_ids.h [capture.bin]\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string ids_path;
+    std::string in_path;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-i" && i + 1 < argc) {
+            ids_path = argv[++i];
+        } else if (in_path.empty() && arg[0] != '-') {
+            in_path = arg;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (ids_path.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+    const std::vector<message> ids = load_ids(ids_path);
+    if (ids.empty()) {
+        std::cerr << ids_path << ": no LOG_IDS entries\n";
+        return 1;
+    }
+
+    std::ifstream file;
+    if (!in_path.empty()) {
+        file.open(in_path, std::ios::binary);
+        if (!file) {
+            std::cerr << "cannot open " << in_path << "\n";
+            return 1;
+        }
+    }
+    std::istream &in = in_path.empty() ? std::cin : file;
+
+    uint64_t t_us = 0;
+    uint64_t skipped = 0;
+    std::vector<uint8_t> buf;
+    int c;
+    while ((c = in.get()) != EOF) {
+        buf.push_back(uint8_t(c));
+        while (!buf.empty()) {
+            if (buf[0] != log_sync) {
+                buf.erase(buf.begin());
+                skipped++;
+                continue;
+            }
+            if (buf.size() >= 3 && (buf[1] >= ids.size() || buf[2] > max_payload)) {
+                // Not a frame after all, resynchronize on the next sync byte
+                buf.erase(buf.begin());
+                skipped++;
+                continue;
+            }
+            if (buf.size() < 3 || buf.size() < size_t(3 + buf[2])) {
+                break; // wait for the rest of the frame
+            }
+            const size_t id = buf[1];
+            const std::vector<uint8_t> payload(buf.begin() + 3, buf.begin() + 3 + buf[2]);
+
+            size_t pos = 0;
+            uint32_t dt = 0;
+            std::vector<uint32_t> args;
+            bool ok = get_varint(payload, pos, dt);
+            while (ok && pos < payload.size()) {
+                uint32_t v;
+                ok = get_varint(payload, pos, v);
+                args.push_back(v);
+            }
+            if (!ok || args.size() != ids[id].nargs) {
+                buf.erase(buf.begin());
+                skipped++;
+                continue;
+            }
+            buf.erase(buf.begin(), buf.begin() + 3 + payload.size());
+            if (skipped) {
+                std::printf("%15s  <%llu bytes skipped>\n", "",
+                            static_cast<unsigned long long>(skipped));
+                skipped = 0;
+            }
+            t_us += dt;
+            std::printf("%12.3f ms  %s\n", t_us / 1000.0, expand(ids[id].fmt, args).c_str());
+            std::fflush(stdout);
+        }
+    }
+    return 0;
+}
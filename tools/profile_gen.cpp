@@ -0,0 +1,194 @@
+/*
+ * profile_gen.cpp
+ *
+ * Generates Src/profile_images.h, the register images of the radio
+ * profiles (profile.h) as plain C tables, and for the images that set up a
+ * baseband, the struct at86rf215_bb_conf read back from their registers.
+ * The images are built from the typed fields of
+ * include/at86rf215_profile.hpp, which needs C++17 and so cannot go through
+ * the firmware compiler:
+ *
+ *   g++ -std=c++17 -O2 -I../include -o profile_gen profile_gen.cpp
+ *   ./profile_gen > ../Src/profile_images.h
+ *
+ * A register given twice, or a value wider than its field, stops the
+ * build of the tool rather than the firmware one. A baseband setting
+ * without a name in at86rf215.h stops the generation.
+ */
+#include <at86rf215_profile.hpp>
+#include <at86rf215_regs.hpp>
+#include <cstddef>
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+
+namespace {
+
+namespace r = at86rf215_regs;
+
+/* Same channel for both, so switching between them leaves it alone */
+#define PROFILE_CHANNEL_910MHZ                      \
+    r::value<r::RF09_CCF0L, 0x00>(),                \
+    r::value<r::RF09_CCF0H, 0x0C>(),                \
+    r::value<r::RF09_CNL, 0x00>(),                  \
+    r::value<r::RF09_CNM, 0x80>()
+
+/* AT86RF215TxSetIQ(910000000), from the reset values */
+constexpr auto iq_img = r::profile(
+    r::RF_IQIFC0::CMV1V2::val<1> | r::RF_IQIFC0::CMV::CMV200
+        | r::RF_IQIFC0::DRV::DRV_Current_2mA,
+    r::RF_IQIFC1::CHPM::RF | r::RF_IQIFC1::SKEDRV::SKEW_zero,
+    r::RF09_IRQM::TRXRDY::val<1> | r::RF09_IRQM::TRXERR::val<1>
+        | r::RF09_IRQM::IQIFSF::val<1>,
+    r::RF09_AUXS::PAVC::PA_VC_2_2 | r::RF09_AUXS::AGCMAP::val<2>,
+    PROFILE_CHANNEL_910MHZ,
+    r::RF09_TXDFE::SR::SR4000 | r::RF09_TXDFE::DM::val<1>
+        | r::RF09_TXDFE::RCUT::CUT_4_4,
+    r::RF09_PAC::PACUR::PAC_3dB_Reduction | r::RF09_PAC::TXPWR::val<5>);
+
+/* The baseband FSK of set_fsk_2_mode() with the FCS appended by the chip */
+constexpr auto fsk_img = r::profile(
+    r::RF_IQIFC0::CMV1V2::val<1> | r::RF_IQIFC0::CMV::CMV200
+        | r::RF_IQIFC0::DRV::DRV_Current_2mA,
+    r::RF_IQIFC1::CHPM::BBRF | r::RF_IQIFC1::SKEDRV::SKEW_zero,
+    r::RF09_IRQM::TRXRDY::val<1> | r::RF09_IRQM::TRXERR::val<1>,
+    r::RF09_AUXS::PAVC::PA_VC_2_2 | r::RF09_AUXS::AGCMAP::val<2>,
+    PROFILE_CHANNEL_910MHZ,
+    r::RF09_TXDFE::SR::SR1000 | r::RF09_TXDFE::RCUT::CUT_4_4,
+    r::RF09_PAC::PACUR::PAC_3dB_Reduction | r::RF09_PAC::TXPWR::val<5>,
+    r::BBC0_PC::PT::val<1> | r::BBC0_PC::BBEN::val<1>
+        | r::BBC0_PC::FCST::val<1> | r::BBC0_PC::TXAFCS::val<1>,
+    r::BBC0_FSKC0::MORD::val<AT86RF215_2FSK>
+        | r::BBC0_FSKC0::MIDX::val<AT86RF215_MIDX_7>
+        | r::BBC0_FSKC0::MIDXS::val<AT86RF215_MIDXS_88>
+        | r::BBC0_FSKC0::BT::val<AT86RF215_FSK_BT_10>,
+    r::BBC0_FSKC1::SRATE::val<AT86RF215_FSK_SRATE_100>,
+    r::value<r::BBC0_FSKPHRTX, 0x00>());
+
+#undef PROFILE_CHANNEL_910MHZ
+
+/* Reset value of BBCn_FSKPLL, the low byte of the preamble length */
+constexpr uint8_t fskpll_reset = 0x08;
+
+template <size_t N>
+bool find(const std::array<at86rf215_reg_val, N> &img, uint16_t reg, uint8_t &val)
+{
+    for (const auto &e : img) {
+        if (e.reg == reg) {
+            val = e.val;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool name_of(std::string &out, const char *prefix,
+             const std::initializer_list<const char *> &names, unsigned v)
+{
+    if (v >= names.size()) {
+        std::fprintf(stderr, "no name for %s value %u\n", prefix, v);
+        return false;
+    }
+    out = std::string(prefix) + names.begin()[v];
+    return true;
+}
+
+/*
+ * The fields are decoded the way at86rf215_bb_conf() encodes them, the FCS
+ * type included: conf.fcst goes to BBCn_PC.FCST unchanged.
+ */
+template <size_t N>
+bool print_bbc(const char *name, const char *img_name,
+               const std::array<at86rf215_reg_val, N> &img)
+{
+    uint8_t pc, c0, c1;
+    uint8_t pll = fskpll_reset;
+    if (!find(img, r::BBC0_PC::addr, pc) || !find(img, r::BBC0_FSKC0::addr, c0)
+            || !find(img, r::BBC0_FSKC1::addr, c1)) {
+        std::fprintf(stderr, "%s: BBC0_PC, FSKC0 or FSKC1 missing\n", img_name);
+        return false;
+    }
+    find(img, r::BBC0_FSKPLL::addr, pll);
+    if (r::BBC0_PC::PT::get(pc) != AT86RF215_BB_MRFSK) {
+        std::fprintf(stderr, "%s: only MR-FSK is supported\n", img_name);
+        return false;
+    }
+    std::string fcst, mord, midx, midxs, bt, srate;
+    if (!name_of(fcst, "AT86RF215_FCS_", {"16", "32"}, r::BBC0_PC::FCST::get(pc))
+            || !name_of(mord, "AT86RF215_", {"2FSK", "4FSK"},
+                        r::BBC0_FSKC0::MORD::get(c0))
+            || !name_of(midx, "AT86RF215_MIDX_",
+                        {"0", "1", "2", "3", "4", "5", "6", "7"},
+                        r::BBC0_FSKC0::MIDX::get(c0))
+            || !name_of(midxs, "AT86RF215_MIDXS_", {"78", "88", "98", "108"},
+                        r::BBC0_FSKC0::MIDXS::get(c0))
+            || !name_of(bt, "AT86RF215_FSK_BT_", {"05", "10", "15", "20"},
+                        r::BBC0_FSKC0::BT::get(c0))
+            || !name_of(srate, "AT86RF215_FSK_SRATE_",
+                        {"50", "100", "150", "200", "300", "400"},
+                        r::BBC0_FSKC1::SRATE::get(c1))) {
+        return false;
+    }
+    std::printf("\n/* The baseband set up by %s, for h->priv.bbc */\n"
+                "static const struct at86rf215_bb_conf %s =\n"
+                "{\n"
+                "    .ctx = %u,\n"
+                "    .fcsfe = %u,\n"
+                "    .txafcs = %u,\n"
+                "    .fcst = %s,\n"
+                "    .pt = AT86RF215_BB_MRFSK,\n"
+                "    .fsk =\n"
+                "    {\n"
+                "        .mord = %s,\n"
+                "        .midx = %s,\n"
+                "        .midxs = %s,\n"
+                "        .bt = %s,\n"
+                "        .srate = %s,\n"
+                "        .fi = %u,\n"
+                "        .preamble_length = %u,\n"
+                "    },\n"
+                "};\n",
+                img_name, name,
+                r::BBC0_PC::CTX::get(pc), r::BBC0_PC::FCSFE::get(pc),
+                r::BBC0_PC::TXAFCS::get(pc), fcst.c_str(), mord.c_str(),
+                midx.c_str(), midxs.c_str(), bt.c_str(), srate.c_str(),
+                r::BBC0_FSKC1::FI::get(c1),
+                (r::BBC0_FSKC1::FSKPLH::get(c1) << 8) | pll);
+    return true;
+}
+
+template <size_t N>
+void print_image(const char *name, const char *comment,
+                 const std::array<at86rf215_reg_val, N> &img)
+{
+    std::printf("\n/* %s */\n"
+                "static const struct at86rf215_reg_val %s[] =\n"
+                "{\n", comment, name);
+    for (const auto &e : img) {
+        std::printf("    { 0x%03X, 0x%02X },\n", unsigned(e.reg), unsigned(e.val));
+    }
+    std::printf("};\n");
+}
+
+} // namespace
+
+int main()
+{
+    std::printf("/*\n"
+                " * profile_images.h\n"
+                " *\n"
+                " * Register images of the radio profiles, see profile.h. Generated by\n"
+                " * tools/profile_gen.cpp, do not edit. Included by profile.c only.\n"
+                " */\n"
+                "#ifndef PROFILE_IMAGES_H\n"
+                "#define PROFILE_IMAGES_H\n"
+                "\n"
+                "#include <at86rf215.h>\n");
+    print_image("iq_img", "I/Q streaming at 4 MHz, 910 MHz", iq_img);
+    print_image("fsk_img", "BBC0 2-FSK, 100 ksym/s, 910 MHz", fsk_img);
+    if (!print_bbc("fsk_bbc", "fsk_img", fsk_img)) {
+        return 1;
+    }
+    std::printf("\n#endif /* PROFILE_IMAGES_H */\n");
+    return 0;
+}
@@ -0,0 +1,303 @@
+/*
+ * regs_gen.cpp
+ *
+ * Generates include/at86rf215_regs.hpp, the typed registers and fields of
+ * include/at86rf215_field.hpp. Addresses come from include/regs.h, named
+ * field values from include/at86rf215Regs.h and the field layouts from the
+ * table below (AT86RF215 datasheet):
+ *
+ *   g++ -std=c++17 -O2 -o regs_gen regs_gen.cpp
+ *   ./regs_gen ../include/regs.h ../include/at86rf215Regs.h \
+ *       > ../include/at86rf215_regs.hpp
+ *
+ * Layouts given for RFn or BBCn apply to both sets. A named value that does
+ * not fit its field stops the generation.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct field_desc {
+    const char *reg;
+    const char *name;
+    unsigned pos;
+    unsigned width;
+    const char *values;     // prefix of the named values, or nullptr
+    const char *strip;      // part of the prefix dropped from their names
+};
+
+const field_desc fields[] = {
+    {"RF_CFG", "DRV", 0, 2, nullptr, nullptr},
+    {"RF_CFG", "IRQP", 2, 1, nullptr, nullptr},
+    {"RF_CFG", "IRQMM", 3, 1, nullptr, nullptr},
+    {"RF_CLKO", "OS", 0, 3, "RF_CLKO_", "RF_"},
+    {"RF_CLKO", "DRV", 3, 2, nullptr, nullptr},
+    {"RF_IQIFC0", "EEC", 0, 1, nullptr, nullptr},
+    {"RF_IQIFC0", "CMV1V2", 1, 1, nullptr, nullptr},
+    {"RF_IQIFC0", "CMV", 2, 2, "RF_IQ_LVDS_CMV", "RF_IQ_LVDS_"},
+    {"RF_IQIFC0", "DRV", 4, 2, "RF_IQ_DRV_", "RF_IQ_"},
+    {"RF_IQIFC0", "SF", 6, 1, nullptr, nullptr},
+    {"RF_IQIFC0", "EXTLB", 7, 1, nullptr, nullptr},
+    {"RF_IQIFC1", "SKEDRV", 0, 2, "RF_IQ_SKEW_", "RF_IQ_"},
+    {"RF_IQIFC1", "CHPM", 4, 3, "RF_MODE_", "RF_MODE_"},
+    {"RF_IQIFC1", "FAILSF", 7, 1, nullptr, nullptr},
+    {"RFn_IRQM", "WAKEUP", 0, 1, nullptr, nullptr},
+    {"RFn_IRQM", "TRXRDY", 1, 1, nullptr, nullptr},
+    {"RFn_IRQM", "EDC", 2, 1, nullptr, nullptr},
+    {"RFn_IRQM", "BATLOW", 3, 1, nullptr, nullptr},
+    {"RFn_IRQM", "TRXERR", 4, 1, nullptr, nullptr},
+    {"RFn_IRQM", "IQIFSF", 5, 1, nullptr, nullptr},
+    {"RFn_AUXS", "PAVC", 0, 2, "RF_PA_VC_", "RF_"},
+    {"RFn_AUXS", "AVS", 2, 1, nullptr, nullptr},
+    {"RFn_AUXS", "AVEN", 3, 1, nullptr, nullptr},
+    {"RFn_AUXS", "AVEXT", 4, 1, nullptr, nullptr},
+    {"RFn_AUXS", "AGCMAP", 5, 2, nullptr, nullptr},
+    {"RFn_AUXS", "EXTLNABYP", 7, 1, nullptr, nullptr},
+    {"RFn_STATE", "STATE", 0, 3, "RF_STATE_", "RF_STATE_"},
+    {"RFn_CMD", "CMD", 0, 3, "RF_CMD_", "RF_CMD_"},
+    {"RFn_RXBWC", "BW", 0, 4, "RF_BW", "RF_"},
+    {"RFn_RXBWC", "IFS", 4, 1, "RX_IFS_", "RX_"},
+    {"RFn_RXBWC", "IFI", 5, 1, nullptr, nullptr},
+    {"RFn_RXDFE", "SR", 0, 4, "RF_SR", "RF_"},
+    {"RFn_RXDFE", "RCUT", 5, 3, "RF_CUT_", "RF_"},
+    {"RFn_AGCC", "EN", 0, 1, nullptr, nullptr},
+    {"RFn_AGCC", "FRZC", 1, 1, nullptr, nullptr},
+    {"RFn_AGCC", "FRZS", 2, 1, nullptr, nullptr},
+    {"RFn_AGCC", "RST", 3, 1, nullptr, nullptr},
+    {"RFn_AGCC", "AVGS", 4, 2, "RF_AGC_AVGS_", "RF_AGC_"},
+    {"RFn_AGCC", "AGCI", 6, 1, nullptr, nullptr},
+    {"RFn_AGCS", "GCW", 0, 5, nullptr, nullptr},
+    {"RFn_AGCS", "TGT", 5, 3, nullptr, nullptr},
+    {"RFn_EDC", "EDM", 0, 2, nullptr, nullptr},
+    {"RFn_EDD", "DTB", 0, 2, nullptr, nullptr},
+    {"RFn_EDD", "DF", 2, 6, nullptr, nullptr},
+    {"RFn_TXCUTC", "LPFCUT", 0, 4, nullptr, nullptr},
+    {"RFn_TXCUTC", "PARAMP", 6, 2, nullptr, nullptr},
+    {"RFn_TXDFE", "SR", 0, 4, "RF_SR", "RF_"},
+    {"RFn_TXDFE", "DM", 4, 1, nullptr, nullptr},
+    {"RFn_TXDFE", "RCUT", 5, 3, "RF_CUT_", "RF_"},
+    {"RFn_PAC", "TXPWR", 0, 5, "RF_TXPWR_", "RF_"},
+    {"RFn_PAC", "PACUR", 5, 2, "RF_PAC_", "RF_"},
+    {"BBCn_IRQM", "RXFS", 0, 1, nullptr, nullptr},
+    {"BBCn_IRQM", "RXFE", 1, 1, nullptr, nullptr},
+    {"BBCn_IRQM", "RXAM", 2, 1, nullptr, nullptr},
+    {"BBCn_IRQM", "RXEM", 3, 1, nullptr, nullptr},
+    {"BBCn_IRQM", "TXFE", 4, 1, nullptr, nullptr},
+    {"BBCn_IRQM", "AGCH", 5, 1, nullptr, nullptr},
+    {"BBCn_IRQM", "AGCR", 6, 1, nullptr, nullptr},
+    {"BBCn_IRQM", "FBLI", 7, 1, nullptr, nullptr},
+    {"BBCn_PC", "PT", 0, 2, nullptr, nullptr},
+    {"BBCn_PC", "BBEN", 2, 1, nullptr, nullptr},
+    {"BBCn_PC", "FCST", 3, 1, nullptr, nullptr},
+    {"BBCn_PC", "TXAFCS", 4, 1, nullptr, nullptr},
+    {"BBCn_PC", "FCSOK", 5, 1, nullptr, nullptr},
+    {"BBCn_PC", "FCSFE", 6, 1, nullptr, nullptr},
+    {"BBCn_PC", "CTX", 7, 1, nullptr, nullptr},
+    {"BBCn_AMCS", "TX2RX", 0, 1, nullptr, nullptr},
+    {"BBCn_AMCS", "CCATX", 1, 1, nullptr, nullptr},
+    {"BBCn_AMCS", "CCAED", 2, 1, nullptr, nullptr},
+    {"BBCn_AMCS", "AACK", 3, 1, nullptr, nullptr},
+    {"BBCn_AMCS", "AACKS", 4, 1, nullptr, nullptr},
+    {"BBCn_AMCS", "AACKDR", 5, 1, nullptr, nullptr},
+    {"BBCn_AMCS", "AACKFA", 6, 1, nullptr, nullptr},
+    {"BBCn_AMCS", "AACKFT", 7, 1, nullptr, nullptr},
+    {"BBCn_FSKC0", "MORD", 0, 1, nullptr, nullptr},
+    {"BBCn_FSKC0", "MIDX", 1, 3, nullptr, nullptr},
+    {"BBCn_FSKC0", "MIDXS", 4, 2, nullptr, nullptr},
+    {"BBCn_FSKC0", "BT", 6, 2, nullptr, nullptr},
+    {"BBCn_FSKC1", "SRATE", 0, 4, nullptr, nullptr},
+    {"BBCn_FSKC1", "FI", 5, 1, nullptr, nullptr},
+    {"BBCn_FSKC1", "FSKPLH", 6, 2, nullptr, nullptr},
+    {"BBCn_FSKC2", "FECIE", 0, 1, nullptr, nullptr},
+    {"BBCn_FSKC2", "FECS", 1, 1, nullptr, nullptr},
+    {"BBCn_FSKC2", "PRI", 2, 1, nullptr, nullptr},
+    {"BBCn_FSKC2", "MSE", 3, 1, nullptr, nullptr},
+    {"BBCn_FSKC2", "RXPTO", 4, 1, nullptr, nullptr},
+    {"BBCn_FSKC2", "RXO", 5, 2, nullptr, nullptr},
+    {"BBCn_FSKC2", "PDTM", 7, 1, nullptr, nullptr},
+    {"BBCn_FSKC3", "PDT", 0, 4, nullptr, nullptr},
+    {"BBCn_FSKC3", "SFDT", 4, 4, nullptr, nullptr},
+    {"BBCn_FSKC4", "CSFD0", 0, 2, nullptr, nullptr},
+    {"BBCn_FSKC4", "CSFD1", 2, 2, nullptr, nullptr},
+    {"BBCn_FSKC4", "RAWRBIT", 4, 1, nullptr, nullptr},
+    {"BBCn_FSKC4", "SFD32", 5, 1, nullptr, nullptr},
+    {"BBCn_FSKC4", "SFDQ", 6, 1, nullptr, nullptr},
+    {"BBCn_FSKPHRTX", "RB1", 0, 1, nullptr, nullptr},
+    {"BBCn_FSKPHRTX", "RB2", 1, 1, nullptr, nullptr},
+    {"BBCn_FSKPHRTX", "DW", 2, 1, nullptr, nullptr},
+    {"BBCn_FSKPHRTX", "SFD", 3, 1, nullptr, nullptr},
+    {"BBCn_FSKDM", "EN", 0, 1, nullptr, nullptr},
+    {"BBCn_FSKDM", "PE", 1, 1, nullptr, nullptr},
+};
+
+struct named_value {
+    std::string name;
+    unsigned value;
+};
+
+bool read_file(const char *path, std::string &out)
+{
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "cannot open " << path << "\n";
+        return false;
+    }
+    out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// REG_<name> (0x<addr>), in file order
+bool parse_regs(const std::string &text, std::vector<std::pair<std::string, unsigned>> &regs)
+{
+    static const std::regex def(R"(^[ \t]*#define[ \t]+REG_(\w+)[ \t]+\((0x[0-9A-Fa-f]+)\))",
+                                std::regex::multiline);
+    std::set<std::string> seen;
+    for (auto it = std::sregex_iterator(text.begin(), text.end(), def);
+         it != std::sregex_iterator(); ++it) {
+        const std::string name = (*it)[1];
+        if (!seen.insert(name).second) {
+            std::cerr << "REG_" << name << " defined twice\n";
+            return false;
+        }
+        regs.emplace_back(name, std::stoul((*it)[2], nullptr, 16));
+    }
+    return !regs.empty();
+}
+
+// <name> 0x<value>, commented out definitions skipped, first one kept
+void parse_values(const std::string &text, std::vector<named_value> &values)
+{
+    static const std::regex def(R"(^[ \t]*#define[ \t]+(\w+)[ \t]+(0x[0-9A-Fa-f]+)\b)",
+                                std::regex::multiline);
+    std::set<std::string> seen;
+    for (auto it = std::sregex_iterator(text.begin(), text.end(), def);
+         it != std::sregex_iterator(); ++it) {
+        const std::string name = (*it)[1];
+        if (seen.insert(name).second) {
+            values.push_back({name, unsigned(std::stoul((*it)[2], nullptr, 16))});
+        }
+    }
+}
+
+// RFn_X matches RF09_X and RF24_X, BBCn_X matches BBC0_X and BBC1_X
+bool layout_matches(const std::string &layout, const std::string &reg)
+{
+    const auto n = layout.find("n_");
+    if (n == std::string::npos) {
+        return layout == reg;
+    }
+    const std::string set = layout.substr(0, n);
+    const std::string rest = layout.substr(n + 1);
+    if (set == "RF") {
+        return reg == "RF09" + rest || reg == "RF24" + rest;
+    }
+    return reg == "BBC0" + rest || reg == "BBC1" + rest;
+}
+
+bool emit_field(const field_desc &f, const std::string &reg,
+                const std::vector<named_value> &values)
+{
+    std::printf("    struct %s : field<%s, %u, %u> {", f.name, reg.c_str(), f.pos, f.width);
+    if (!f.values) {
+        std::printf("};\n");
+        return true;
+    }
+    std::printf("\n");
+    const std::string prefix = f.values;
+    const size_t strip = std::string(f.strip).size();
+    for (const auto &v : values) {
+        if (v.name.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        if (v.value >= (1u << f.width)) {
+            std::cerr << v.name << " does not fit " << reg << "." << f.name << "\n";
+            return false;
+        }
+        std::printf("        static constexpr update_type %s = make<0x%02X>();\n",
+                    v.name.substr(strip).c_str(), v.value);
+    }
+    std::printf("    };\n");
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        std::cerr << "usage: " << argv[0] << " regs.h at86rf215Regs.h\n";
+        return 1;
+    }
+    std::string regs_text, values_text;
+    if (!read_file(argv[1], regs_text) || !read_file(argv[2], values_text)) {
+        return 1;
+    }
+    std::vector<std::pair<std::string, unsigned>> regs;
+    if (!parse_regs(regs_text, regs)) {
+        std::cerr << "no register in " << argv[1] << "\n";
+        return 1;
+    }
+    std::vector<named_value> values;
+    parse_values(values_text, values);
+
+    std::map<unsigned, std::string> by_addr;
+    for (const auto &r : regs) {
+        by_addr.emplace(r.second, r.first);
+    }
+
+    std::printf("/*\n"
+                " * at86rf215_regs.hpp\n"
+                " *\n"
+                " * Registers and fields of the AT86RF215, see at86rf215_field.hpp.\n"
+                " * Generated by tools/regs_gen.cpp from include/regs.h and\n"
+                " * include/at86rf215Regs.h, do not edit.\n"
+                " */\n"
+                "#ifndef AT86RF215_REGS_HPP\n"
+                "#define AT86RF215_REGS_HPP\n"
+                "\n"
+                "#include <at86rf215_field.hpp>\n"
+                "\n"
+                "namespace at86rf215_regs {\n");
+
+    for (const auto &r : regs) {
+        const std::string &name = r.first;
+        const unsigned addr = r.second;
+        // Banked when the RF24 or BBC1 copy sits one stride above
+        bool banked = false;
+        if (name.compare(0, 5, "RF09_") == 0 || name.compare(0, 5, "BBC0_") == 0) {
+            const std::string twin = (name[0] == 'R' ? "RF24_" : "BBC1_") + name.substr(5);
+            const auto it = by_addr.find(addr + 0x100);
+            banked = it != by_addr.end() && it->second == twin;
+        }
+        std::printf("\nstruct %s : reg<0x%04X%s> {", name.c_str(), addr,
+                    banked ? ", true" : "");
+        bool any = false;
+        for (const auto &f : fields) {
+            if (!layout_matches(f.reg, name)) {
+                continue;
+            }
+            if (!any) {
+                std::printf("\n");
+                any = true;
+            }
+            if (!emit_field(f, name, values)) {
+                return 1;
+            }
+        }
+        std::printf("};\n");
+    }
+
+    std::printf("\n"
+                "} // namespace at86rf215_regs\n"
+                "\n"
+                "#endif /* AT86RF215_REGS_HPP */\n");
+    return 0;
+}
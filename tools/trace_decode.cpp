@@ -0,0 +1,268 @@
+/*
+ * trace_decode.cpp
+ *
+ * Turns a memory dump of the firmware trace_ring (include/trace.h) into a
+ * timeline. Dump sizeof(trace_ring) bytes starting at &trace_ring as raw
+ * binary from the debugger, then:
+ *
+ *   g++ -std=c++17 -O2 -o trace_decode trace_decode.cpp
+ *   ./trace_decode trace.bin [-r include/regs.h] [-c cycles_per_us]
+ *
+ * -r names the registers after the REG_ defines of the given header,
+ * -c overrides the cycle counter rate recorded by the firmware.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t trace_magic = 0x31435254; // "TRC1"
+constexpr size_t header_size = 5 * sizeof(uint32_t);
+constexpr size_t rec_size = 8;
+
+// Keep in sync with trace_type_t
+enum trace_type : uint8_t {
+    TRACE_NONE = 0,
+    TRACE_REG_READ,
+    TRACE_REG_WRITE,
+    TRACE_BURST_READ,
+    TRACE_BURST_WRITE,
+    TRACE_IRQ_RF,
+    TRACE_IRQ_BB,
+    TRACE_FPGA_RESET,
+    TRACE_USER,
+    TRACE_BUS_BUSY
+};
+
+struct record {
+    uint32_t cycles;
+    uint8_t type;
+    uint8_t a;
+    uint16_t b;
+};
+
+// The dump comes from a little endian Cortex-M4
+uint32_t le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+}
+
+uint16_t le16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+std::map<uint16_t, std::string> load_regs(const std::string &path)
+{
+    std::map<uint16_t, std::string> regs;
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "cannot open " << path << "\n";
+        return regs;
+    }
+    const std::regex def(R"(#define\s+REG_(\w+)\s+\(?\s*(0x[0-9A-Fa-f]+)\s*\)?)");
+    std::string line;
+    while (std::getline(in, line)) {
+        std::smatch m;
+        if (std::regex_search(line, m, def)) {
+            regs.emplace(uint16_t(std::stoul(m[2], nullptr, 16)), m[1]);
+        }
+    }
+    return regs;
+}
+
+std::string hex(unsigned v, int width)
+{
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "0x%0*X", width, v);
+    return buf;
+}
+
+class decoder {
+public:
+    explicit decoder(std::map<uint16_t, std::string> regs) : regs_(std::move(regs)) {}
+
+    std::string describe(const record &r) const
+    {
+        std::ostringstream os;
+        switch (r.type) {
+        case TRACE_REG_READ:
+            os << "read  " << reg(r.b) << " = " << hex(r.a, 2);
+            if (is_state(r.b)) {
+                os << " (" << state_name(r.a & 0x7) << ")";
+            }
+            break;
+        case TRACE_REG_WRITE:
+            os << "write " << reg(r.b) << " = " << hex(r.a, 2);
+            if (is_cmd(r.b)) {
+                os << " (CMD " << cmd_name(r.a & 0x7) << ")";
+            }
+            break;
+        case TRACE_BURST_READ:
+            os << "read  " << reg(r.b) << " burst of " << unsigned(r.a)
+               << (r.a == 0xFF ? "+" : "");
+            break;
+        case TRACE_BURST_WRITE:
+            os << "write " << reg(r.b) << " burst of " << unsigned(r.a)
+               << (r.a == 0xFF ? "+" : "");
+            break;
+        case TRACE_IRQ_RF:
+            os << "IRQ   RF09 " << irqs(r.a, rf_irq) << " RF24 " << irqs(r.b & 0xFF, rf_irq);
+            break;
+        case TRACE_IRQ_BB:
+            os << "IRQ   BBC0 " << irqs(r.a, bb_irq) << " BBC1 " << irqs(r.b & 0xFF, bb_irq);
+            break;
+        case TRACE_FPGA_RESET:
+            os << "FPGA  " << (r.a ? "released" : "held in reset");
+            break;
+        case TRACE_USER:
+            os << "user  a=" << hex(r.a, 2) << " b=" << hex(r.b, 4);
+            break;
+        case TRACE_BUS_BUSY:
+            os << (r.a ? "read  " : "write ") << reg(r.b) << " dropped, bus busy";
+            break;
+        default:
+            os << "unknown type " << unsigned(r.type);
+            break;
+        }
+        return os.str();
+    }
+
+private:
+    static constexpr const char *rf_irq[8] = {"WAKEUP", "TRXRDY", "EDC", "BATLOW",
+                                              "TRXERR", "IQIFSF", "b6", "b7"};
+    static constexpr const char *bb_irq[8] = {"RXFS", "RXFE", "RXAM", "RXEM",
+                                              "TXFE", "AGCH", "AGCR", "FBLI"};
+
+    // RFn_STATE and RFn_CMD, RF24 is at a 0x100 offset from RF09
+    static bool is_state(uint16_t reg) { return reg == 0x102 || reg == 0x202; }
+    static bool is_cmd(uint16_t reg) { return reg == 0x103 || reg == 0x203; }
+
+    static const char *state_name(unsigned s)
+    {
+        static const char *names[8] = {"?", "?", "TRXOFF", "TXPREP",
+                                       "TX", "RX", "TRANSITION", "RESET"};
+        return names[s];
+    }
+
+    static const char *cmd_name(unsigned c)
+    {
+        static const char *names[8] = {"NOP", "SLEEP", "TRXOFF", "TXPREP",
+                                       "TX", "RX", "?", "RESET"};
+        return names[c];
+    }
+
+    static std::string irqs(unsigned v, const char *const names[8])
+    {
+        if (!v) {
+            return "-";
+        }
+        std::string s;
+        for (int i = 0; i < 8; i++) {
+            if (v & (1u << i)) {
+                s += s.empty() ? "" : "|";
+                s += names[i];
+            }
+        }
+        return s;
+    }
+
+    std::string reg(uint16_t r) const
+    {
+        auto it = regs_.find(r);
+        return it == regs_.end() ? hex(r, 4) : it->second;
+    }
+
+    std::map<uint16_t, std::string> regs_;
+};
+
+void usage(const char *prog)
+{
+    std::cerr << "usage: " << prog << " dump.bin [-r regs.h] [-c cycles_per_us]\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string dump_path;
+    std::string regs_path;
+    uint32_t cycles_per_us = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-r" && i + 1 < argc) {
+            regs_path = argv[++i];
+        } else if (arg == "-c" && i + 1 < argc) {
+            cycles_per_us = std::stoul(argv[++i]);
+        } else if (dump_path.empty() && arg[0] != '-') {
+            dump_path = arg;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (dump_path.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ifstream in(dump_path, std::ios::binary);
+    if (!in) {
+        std::cerr << "cannot open " << dump_path << "\n";
+        return 1;
+    }
+    const std::vector<uint8_t> raw((std::istreambuf_iterator<char>(in)),
+                                   std::istreambuf_iterator<char>());
+    if (raw.size() < header_size || le32(&raw[0]) != trace_magic) {
+        std::cerr << dump_path << ": not a trace_ring dump\n";
+        return 1;
+    }
+    const uint32_t len = le32(&raw[4]);
+    const uint32_t head = le32(&raw[12]);
+    if (!cycles_per_us) {
+        cycles_per_us = le32(&raw[8]);
+    }
+    if (!len || (len & (len - 1)) || raw.size() < header_size + len * rec_size) {
+        std::cerr << dump_path << ": truncated dump, expected " << len << " records\n";
+        return 1;
+    }
+    if (!cycles_per_us) {
+        cycles_per_us = 1;
+    }
+
+    // Oldest first
+    std::vector<record> recs;
+    const uint32_t n = head < len ? head : len;
+    for (uint32_t i = 0; i < n; i++) {
+        const uint8_t *p = &raw[header_size + ((head - n + i) & (len - 1)) * rec_size];
+        record r{le32(p), p[4], p[5], le16(p + 6)};
+        if (r.type != TRACE_NONE) {
+            recs.push_back(r);
+        }
+    }
+
+    decoder dec(regs_path.empty() ? std::map<uint16_t, std::string>{} : load_regs(regs_path));
+    std::printf("%u records, %u written, %u cycles/us%s\n", unsigned(recs.size()),
+                unsigned(head), unsigned(cycles_per_us),
+                head > len ? ", oldest overwritten" : "");
+    std::printf("%12s %10s  event\n", "t [us]", "dt [us]");
+
+    // The cycle counter wraps, accumulate the differences
+    uint64_t t = 0;
+    for (size_t i = 0; i < recs.size(); i++) {
+        const uint32_t dt = i ? recs[i].cycles - recs[i - 1].cycles : 0;
+        t += dt;
+        std::printf("%12.2f %10.2f  %s\n", double(t) / cycles_per_us,
+                    double(dt) / cycles_per_us, dec.describe(recs[i]).c_str());
+    }
+    return 0;
+}